@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Bindings for the algorithms of main/core/src/algorithms, built as
+build/libalgorithms.so (or the path in $ALGORITHMS_LIBRARY).
+
+Every function takes numpy arrays and runs a whole batch of frames in one
+call. Frames are float64 arrays of shape (N, 16), which are passed to C
+without a copy when they are already C contiguous float64, e.g. the result
+of np.loadtxt(). Results are written into new arrays, or into out= when
+given.
+
+    import algorithms
+    frames = np.loadtxt("sensor_history-2.txt")
+    filtered = algorithms.filter_median(frames, 50)
+    positions = algorithms.line_bayesian(frames)
+    marks = algorithms.mark(frames, positions)
+
+As a script, runs the estimators, the mark detector and the filters over a
+sensor history or a recording and reports the time of each:
+
+    ./algorithms.py recordings/20250510-120000.rec
+"""
+
+import argparse
+import ctypes
+import os
+import sys
+import time
+
+import numpy as np
+
+NUM_SENSORS = 16
+
+LINE_DEFAULT_GATE = 0.3
+LINE_DEFAULT_PRIOR_WEIGHT = 4.0
+MARK_DEFAULT_THRESHOLD = 0.8
+MARK_DEFAULT_SIDE_MARGIN = 0.25
+
+MARK_NONE = 0x00
+MARK_RIGHT = 0x01
+MARK_LEFT = 0x02
+MARK_BOTH = 0x03
+MARK_CROSS = 0x04
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..")
+
+
+class LineConfig(ctypes.Structure):
+    _fields_ = [("gate", ctypes.c_double), ("prior_weight", ctypes.c_double)]
+
+
+class Mark(ctypes.Structure):
+    _fields_ = [
+        ("threshold", ctypes.c_double),
+        ("side_margin", ctypes.c_double),
+        ("state", ctypes.c_uint8),
+        ("is_left", ctypes.c_bool),
+        ("is_right", ctypes.c_bool),
+        ("accum", ctypes.c_bool * NUM_SENSORS),
+    ]
+
+
+class PidControl(ctypes.Structure):
+    _fields_ = [
+        ("kP", ctypes.c_double),
+        ("kI", ctypes.c_double),
+        ("kD", ctypes.c_double),
+        ("target", ctypes.c_double),
+        ("error_prev", ctypes.c_double),
+        ("error_accum", ctypes.c_double),
+    ]
+
+
+def _array(dtype, ndim):
+    return np.ctypeslib.ndpointer(dtype=dtype, ndim=ndim, flags="C_CONTIGUOUS")
+
+
+def _load():
+    path = os.environ.get("ALGORITHMS_LIBRARY", os.path.join(ROOT, "build", "libalgorithms.so"))
+    library = ctypes.CDLL(path)
+    frames = _array(np.float64, 2)
+    doubles = _array(np.float64, 1)
+    u32 = ctypes.c_uint32
+    signatures = {
+        "line_weighted_sum_batch": [
+            ctypes.POINTER(LineConfig),
+            frames,
+            u32,
+            ctypes.c_double,
+            doubles,
+            _array(np.uint32, 1),
+        ],
+        "line_bayesian_batch": [ctypes.POINTER(LineConfig), frames, u32, ctypes.c_double, doubles],
+        "mark_init": [ctypes.POINTER(Mark)],
+        "mark_batch": [ctypes.POINTER(Mark), frames, doubles, u32, _array(np.uint8, 1)],
+        "pid_init": [ctypes.POINTER(PidControl)],
+        "pid_batch": [ctypes.POINTER(PidControl), doubles, doubles, doubles, u32, doubles],
+        "filter_iir": [frames, u32, ctypes.c_double, frames],
+        "filter_mean": [frames, u32, u32, frames],
+        "filter_median": [frames, u32, u32, doubles, frames],
+    }
+    for name, argtypes in signatures.items():
+        function = getattr(library, name)
+        function.argtypes = argtypes
+        function.restype = None
+    return library
+
+
+_library = _load()
+
+
+def _frames(frames):
+    # No copy when the caller already has C contiguous float64 frames
+    frames = np.ascontiguousarray(frames, dtype=np.float64)
+    if frames.ndim != 2 or frames.shape[1] != NUM_SENSORS:
+        raise ValueError(f"Frames must have shape (N, {NUM_SENSORS})")
+    return frames
+
+
+def _vector(values, count, dtype=np.float64):
+    values = np.ascontiguousarray(values, dtype=dtype)
+    if values.shape != (count,):
+        raise ValueError(f"Expected {count} values")
+    return values
+
+
+def _window(window):
+    window = int(window)
+    if not 1 <= window < 2**32:
+        raise ValueError("window must be between 1 and 2**32 - 1")
+    return window
+
+
+def _output(out, shape, dtype):
+    if out is None:
+        return np.empty(shape, dtype=dtype)
+    if out.shape != shape or out.dtype != dtype or not out.flags.c_contiguous:
+        raise ValueError(f"out must be C contiguous {np.dtype(dtype).name} of shape {shape}")
+    return out
+
+
+def line_weighted_sum(frames, initial_position=0.0, gate=LINE_DEFAULT_GATE, out=None):
+    """Positions of the weighted sum estimator, and the bits of the sensors used in each frame"""
+    frames = _frames(frames)
+    positions = _output(out, (len(frames),), np.float64)
+    used = np.empty(len(frames), dtype=np.uint32)
+    config = LineConfig(gate, LINE_DEFAULT_PRIOR_WEIGHT)
+    _library.line_weighted_sum_batch(ctypes.byref(config), frames, len(frames), initial_position, positions, used)
+    return positions, used
+
+
+def line_bayesian(frames, initial_position=0.0, prior_weight=LINE_DEFAULT_PRIOR_WEIGHT, out=None):
+    """Positions of the Bayesian estimator"""
+    frames = _frames(frames)
+    positions = _output(out, (len(frames),), np.float64)
+    config = LineConfig(LINE_DEFAULT_GATE, prior_weight)
+    _library.line_bayesian_batch(ctypes.byref(config), frames, len(frames), initial_position, positions)
+    return positions
+
+
+def mark(frames, positions, threshold=MARK_DEFAULT_THRESHOLD, side_margin=MARK_DEFAULT_SIDE_MARGIN, out=None):
+    """MARK_* of every frame, from a fresh state machine"""
+    frames = _frames(frames)
+    positions = _vector(positions, len(frames))
+    marks = _output(out, (len(frames),), np.uint8)
+    state = Mark()
+    _library.mark_init(ctypes.byref(state))
+    state.threshold = threshold
+    state.side_margin = side_margin
+    _library.mark_batch(ctypes.byref(state), frames, positions, len(frames), marks)
+    return marks
+
+
+def pid(targets, currents, dts, kp, ki, kd=0.0, out=None):
+    """Outputs of a PID controller stepped over the given targets, measurements and time steps"""
+    currents = np.ascontiguousarray(currents, dtype=np.float64)
+    count = len(currents)
+    targets = _vector(np.broadcast_to(targets, (count,)), count)
+    dts = _vector(np.broadcast_to(dts, (count,)), count)
+    outputs = _output(out, (count,), np.float64)
+    control = PidControl()
+    _library.pid_init(ctypes.byref(control))
+    control.kP, control.kI, control.kD = kp, ki, kd
+    _library.pid_batch(ctypes.byref(control), targets, currents, dts, count, outputs)
+    return outputs
+
+
+def filter_iir(frames, gain, out=None):
+    frames = _frames(frames)
+    output = _output(out, frames.shape, np.float64)
+    _library.filter_iir(frames, len(frames), gain, output)
+    return output
+
+
+def filter_mean(frames, window, out=None):
+    """Mean over the last window frames, including the current one"""
+    frames = _frames(frames)
+    window = _window(window)
+    output = _output(out, frames.shape, np.float64)
+    _library.filter_mean(frames, len(frames), window, output)
+    return output
+
+
+def filter_median(frames, window, out=None):
+    """Median over the last window frames, including the current one"""
+    frames = _frames(frames)
+    window = _window(window)
+    output = _output(out, frames.shape, np.float64)
+    scratch = np.empty(window * NUM_SENSORS, dtype=np.float64)
+    _library.filter_median(frames, len(frames), window, scratch, output)
+    return output
+
+
+def load_frames(path):
+    """sensor_data of a recording (.rec), or the rows of a sensor history text file"""
+    if not path.endswith(".rec"):
+        return np.loadtxt(path)
+    import importlib.util
+
+    spec = importlib.util.spec_from_file_location(
+        "read_recording", os.path.join(ROOT, "analysis", "recording", "read-recording.py")
+    )
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    _, columns = module.read_recording(path)
+    return columns["sensor_data"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the algorithms over a sensor history or recording")
+    parser.add_argument("path")
+    parser.add_argument("--window", type=int, default=50, help="window of the mean and median filters")
+    args = parser.parse_args()
+
+    start = time.perf_counter()
+    frames = _frames(load_frames(args.path))
+    print(f"loaded {len(frames)} frames in {time.perf_counter() - start:.2f} s")
+
+    def timed(name, function, *arguments):
+        start = time.perf_counter()
+        result = function(*arguments)
+        elapsed = time.perf_counter() - start
+        print(f"{name}: {elapsed:.3f} s ({len(frames) / elapsed / 1e6:.2f} M frames/s)")
+        return result
+
+    timed("filter_iir", filter_iir, frames, 0.005)
+    timed("filter_mean", filter_mean, frames, args.window)
+    timed("filter_median", filter_median, frames, args.window)
+    timed("line_weighted_sum", line_weighted_sum, frames)
+    positions = timed("line_bayesian", line_bayesian, frames)
+    marks = timed("mark", mark, frames, positions)
+
+    names = {MARK_RIGHT: "right", MARK_LEFT: "left", MARK_BOTH: "both", MARK_CROSS: "cross"}
+    counts = ", ".join(f"{np.count_nonzero(marks == value)} {name}" for value, name in names.items())
+    print(f"marks: {counts}")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
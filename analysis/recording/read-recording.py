@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Reader for the binary recordings written by main/infra/output.c.
+
+    ./read-recording.py recordings/20250510-120000.rec
+    ./read-recording.py recordings/20250510-120000.rec --start 1.0 --end 2.0
+    ./read-recording.py recordings/20250510-120000.rec --sensor-history sensor_history.txt
+
+As a module, read_recording() returns the schema and a dict of columns,
+which are numpy arrays when numpy is available and lists otherwise. With
+numpy, whole chunks are decoded at once, which reads a million records in
+about a second.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+FILE_MAGIC = b"RPIREC1\0"
+FILE_HEADER = struct.Struct("<8s6I3Q")
+CHUNK_MAGIC = 0x4B4E4843
+CHUNK_HEADER = struct.Struct("<6I2Q24x")
+CHUNK_DATA = 0x01
+CHUNK_INDEX = 0x02
+INDEX_ENTRY = struct.Struct("<3Q")
+
+FORMATS = {
+    "uint8": "B",
+    "uint16": "H",
+    "uint32": "I",
+    "uint64": "Q",
+    "int8": "b",
+    "int16": "h",
+    "int32": "i",
+    "int64": "q",
+    "float": "f",
+    "double": "d",
+}
+NUMPY_FORMATS = {
+    "uint8": "u1",
+    "uint16": "u2",
+    "uint32": "u4",
+    "uint64": "u8",
+    "int8": "i1",
+    "int16": "i2",
+    "int32": "i4",
+    "int64": "i8",
+    "float": "f4",
+    "double": "f8",
+}
+
+
+def read_header(file):
+    file.seek(0)
+    values = FILE_HEADER.unpack(file.read(FILE_HEADER.size))
+    magic, version, header_size, chunk_size, record_size, index_interval, schema_size = values[:7]
+    start_timestamp_ns, record_count, dropped_count = values[7:]
+    if magic != FILE_MAGIC or version != 1:
+        raise ValueError("Not a recording, or an unsupported version")
+
+    schema = json.loads(file.read(schema_size).rstrip(b"\0"))
+    if schema["size"] != record_size:
+        raise ValueError("Schema does not match the record size")
+    return {
+        "header_size": header_size,
+        "chunk_size": chunk_size,
+        "record_size": record_size,
+        "index_interval": index_interval,
+        "start_timestamp_ns": start_timestamp_ns,
+        "record_count": record_count,
+        "dropped_count": dropped_count,
+        "schema": schema,
+    }
+
+
+def read_chunks(file, header):
+    """Yield (type, count, dropped, first_ns, last_ns, payload offset) for every chunk"""
+    offset = header["header_size"]
+    while True:
+        file.seek(offset)
+        raw = file.read(CHUNK_HEADER.size)
+        if len(raw) < CHUNK_HEADER.size:
+            return
+        magic, type, size, count, _, dropped, first_ns, last_ns = CHUNK_HEADER.unpack(raw)
+        if magic != CHUNK_MAGIC:
+            # Truncated recording, e.g. the program was killed
+            return
+        yield type, count, dropped, first_ns, last_ns, offset + CHUNK_HEADER.size
+        offset += size
+
+
+def read_index(file, header):
+    """Return [(offset, first_ns, last_ns)] of every data chunk, from the index chunks"""
+    entries = []
+    for type, count, _, _, _, payload in read_chunks(file, header):
+        if type == CHUNK_INDEX:
+            file.seek(payload)
+            raw = file.read(count * INDEX_ENTRY.size)
+            entries += [INDEX_ENTRY.unpack_from(raw, i * INDEX_ENTRY.size) for i in range(count)]
+    return entries
+
+
+def record_struct(schema):
+    # Explicit padding keeps the offsets of the C struct
+    format = "<"
+    position = 0
+    for _, type, count, offset in schema["fields"]:
+        format += f"{offset - position}x" if offset > position else ""
+        format += f"{count}{FORMATS[type]}"
+        position = offset + count * struct.calcsize("<" + FORMATS[type])
+    format += f"{schema['size'] - position}x" if schema["size"] > position else ""
+    return struct.Struct(format)
+
+
+def record_dtype(schema):
+    import numpy as np
+
+    fields = schema["fields"]
+    return np.dtype(
+        {
+            "names": [name for name, _, _, _ in fields],
+            "formats": [("<" + NUMPY_FORMATS[type], (count,) if count > 1 else ()) for _, type, count, _ in fields],
+            "offsets": [offset for _, _, _, offset in fields],
+            "itemsize": schema["size"],
+        }
+    )
+
+
+def read_recording_numpy(path, start_s=None, end_s=None):
+    """read_recording() that decodes whole chunks with numpy rather than a record at a time"""
+    import numpy as np
+
+    with open(path, "rb") as file:
+        header = read_header(file)
+        schema = header["schema"]
+        dtype = record_dtype(schema)
+        timestamp = schema["fields"][0][0]
+        origin_ns = header["start_timestamp_ns"]
+        start_ns = origin_ns + int(start_s * 1e9) if start_s is not None else 0
+        end_ns = origin_ns + int(end_s * 1e9) if end_s is not None else 2**64 - 1
+
+        chunks = []
+        for type, count, _, first_ns, last_ns, payload in read_chunks(file, header):
+            if type != CHUNK_DATA or last_ns < start_ns or first_ns > end_ns:
+                continue
+            file.seek(payload)
+            raw = file.read(count * dtype.itemsize)
+            records = np.frombuffer(raw, dtype=dtype, count=len(raw) // dtype.itemsize)
+            selected = (records[timestamp] >= start_ns) & (records[timestamp] <= end_ns)
+            chunks.append(records if selected.all() else records[selected])
+
+    records = np.concatenate(chunks) if chunks else np.empty(0, dtype=dtype)
+    # Contiguous columns, ready for analysis/algorithms without another copy
+    return header, {name: np.ascontiguousarray(records[name]) for name in dtype.names}
+
+
+def read_recording(path, start_s=None, end_s=None):
+    try:
+        return read_recording_numpy(path, start_s, end_s)
+    except ImportError:
+        pass
+
+    with open(path, "rb") as file:
+        header = read_header(file)
+        schema = header["schema"]
+        record = record_struct(schema)
+        origin_ns = header["start_timestamp_ns"]
+        start_ns = origin_ns + int(start_s * 1e9) if start_s is not None else 0
+        end_ns = origin_ns + int(end_s * 1e9) if end_s is not None else 2**64
+
+        columns = {name: [] for name, _, _, _ in schema["fields"]}
+        for type, count, _, first_ns, last_ns, payload in read_chunks(file, header):
+            # Skip whole chunks outside of the time range
+            if type != CHUNK_DATA or last_ns < start_ns or first_ns > end_ns:
+                continue
+            file.seek(payload)
+            raw = file.read(count * record.size)
+            for values in record.iter_unpack(raw[: count * record.size]):
+                if not start_ns <= values[0] <= end_ns:
+                    continue
+                i = 0
+                for name, _, field_count, _ in schema["fields"]:
+                    columns[name].append(values[i] if field_count == 1 else values[i : i + field_count])
+                    i += field_count
+
+    return header, columns
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Read a binary recording")
+    parser.add_argument("path")
+    parser.add_argument("--start", type=float, help="start time in seconds from the beginning")
+    parser.add_argument("--end", type=float, help="end time in seconds from the beginning")
+    parser.add_argument("--sensor-history", help="write sensor_data rows in the format of analyzer.py")
+    args = parser.parse_args()
+
+    header, columns = read_recording(args.path, args.start, args.end)
+    timestamps = columns[header["schema"]["fields"][0][0]]
+    print(f"records: {header['record_count']} written, {header['dropped_count']} dropped")
+    print(f"selected: {len(timestamps)}")
+    if len(timestamps) > 1:
+        duration = (timestamps[-1] - timestamps[0]) / 1e9
+        print(f"duration: {duration:.3f} s ({(len(timestamps) - 1) / duration:.1f} records/s)")
+    with open(args.path, "rb") as file:
+        print(f"index entries: {len(read_index(file, header))}")
+
+    if args.sensor_history:
+        with open(args.sensor_history, "w") as file:
+            for row in columns["sensor_data"]:
+                file.write(" ".join(f"{value:.6f}" for value in row) + "\n")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
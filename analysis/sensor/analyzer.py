@@ -1,8 +1,14 @@
 #! /usr/bin/env python3
+import os
+import sys
+
 import numpy as np
 import matplotlib.pyplot as plt
 from matplotlib.animation import FuncAnimation
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "algorithms"))
+import algorithms
+
 with open("sensor_history-2.txt", "r") as file:
     sensor_history = np.loadtxt(file)
 
@@ -13,27 +19,21 @@ if sample:
 
 filter_mode = "median"
 
+# The filters of main/core/src/algorithms run over every frame in one call.
+# The window filters there include the current frame, so frame i of the
+# mean and median here, over the n_steps frames before it, is frame i - 1
+# there.
 if filter_mode == "iir":
     iir_gain = 0.005
-    filtered = [np.zeros(16)]
-    for i in range(1, len(sensor_history)):
-        new_row = iir_gain * sensor_history[i] + (1 - iir_gain) * filtered[-1]
-        filtered.append(new_row)
-    sensor_history = np.array(filtered)
+    frames = sensor_history.copy()
+    frames[0] = 0  # Start from zeros
+    sensor_history = algorithms.filter_iir(frames, iir_gain)
 elif filter_mode == "mean":
     n_steps = 100
-    shifted = []
-    for i in range(n_steps, len(sensor_history)):
-        shifted.append(sensor_history[i - n_steps : i])
-    stacked = np.stack(shifted, axis=0)
-    sensor_history = stacked.mean(axis=1)
+    sensor_history = algorithms.filter_mean(sensor_history, n_steps)[n_steps - 1 : -1]
 elif filter_mode == "median":
     n_steps = 50
-    shifted = []
-    for i in range(n_steps, len(sensor_history)):
-        shifted.append(sensor_history[i - n_steps : i])
-    stacked = np.stack(shifted, axis=0)
-    sensor_history = np.median(stacked, axis=1)
+    sensor_history = algorithms.filter_median(sensor_history, n_steps)[n_steps - 1 : -1]
 
 
 threshold = 0.1
@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Measures the UI server of a running robot, to compare the Node server
+(server/app.js) with the native one (-DUI_SERVER=native).
+
+    ./compare-ui-server.py robot.local
+    ./compare-ui-server.py robot.local --pid 1234 --pid 1240 --duration 10
+    ./compare-ui-server.py robot.local --startup
+
+--startup waits for the server to come up, so start it right after the
+service is restarted. --pid reads VmRSS from /proc, so it has to run on
+the robot itself (use localhost then).
+
+Only the standard library is used.
+"""
+
+import argparse
+import base64
+import hashlib
+import json
+import os
+import socket
+import struct
+import time
+
+WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+STATE_MESSAGE_DELTA = 0x01
+
+
+class WebSocket:
+    def __init__(self, host, port, timeout=5.0):
+        self.socket = socket.create_connection((host, port), timeout=timeout)
+        self.socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.buffer = b""
+
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.socket.sendall(
+            (
+                f"GET / HTTP/1.1\r\nHost: {host}\r\nUpgrade: websocket\r\n"
+                f"Connection: Upgrade\r\nSec-WebSocket-Key: {key}\r\n"
+                "Sec-WebSocket-Version: 13\r\n\r\n"
+            ).encode()
+        )
+        while b"\r\n\r\n" not in self.buffer:
+            self.receive_more()
+        header, self.buffer = self.buffer.split(b"\r\n\r\n", 1)
+        accept = base64.b64encode(
+            hashlib.sha1((key + WEBSOCKET_GUID).encode()).digest()
+        ).decode()
+        if b" 101 " not in header.split(b"\r\n")[0] or accept.encode() not in header:
+            raise RuntimeError("WebSocket handshake failed")
+
+    def receive_more(self):
+        data = self.socket.recv(65536)
+        if not data:
+            raise ConnectionError("Connection closed")
+        self.buffer += data
+
+    def receive(self):
+        """Returns (is_binary, payload) of the next data frame"""
+        while True:
+            if len(self.buffer) >= 2:
+                opcode = self.buffer[0] & 0x0F
+                length = self.buffer[1] & 0x7F
+                offset = 2
+                if length == 126 and len(self.buffer) >= 4:
+                    (length,) = struct.unpack(">H", self.buffer[2:4])
+                    offset = 4
+                elif length == 127 and len(self.buffer) >= 10:
+                    (length,) = struct.unpack(">Q", self.buffer[2:10])
+                    offset = 10
+                if length < 126 or offset > 2:
+                    if len(self.buffer) >= offset + length:
+                        payload = self.buffer[offset : offset + length]
+                        self.buffer = self.buffer[offset + length :]
+                        if opcode in (0x1, 0x2):
+                            return opcode == 0x2, payload
+                        continue
+            self.receive_more()
+
+    def send(self, text):
+        payload = text.encode()
+        mask = os.urandom(4)
+        masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+        if len(payload) < 126:
+            header = struct.pack(">BB", 0x81, 0x80 | len(payload))
+        else:
+            header = struct.pack(">BBH", 0x81, 0x80 | 126, len(payload))
+        self.socket.sendall(header + mask + masked)
+
+    def close(self):
+        self.socket.close()
+
+
+def percentile(values, fraction):
+    if not values:
+        return float("nan")
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def measure_startup(host, port, timeout_s):
+    """Time until the first state delta can be received"""
+    begin = time.monotonic()
+    while time.monotonic() - begin < timeout_s:
+        try:
+            ws = WebSocket(host, port, timeout=1.0)
+            while True:
+                is_binary, payload = ws.receive()
+                if is_binary and payload[0] == STATE_MESSAGE_DELTA:
+                    ws.close()
+                    return time.monotonic() - begin
+        except (OSError, RuntimeError):
+            time.sleep(0.01)
+    return None
+
+
+def measure_http(host, port, path, encoding):
+    begin = time.monotonic()
+    connection = socket.create_connection((host, port))
+    connection.sendall(
+        (
+            f"GET {path} HTTP/1.1\r\nHost: {host}\r\nAccept-Encoding: {encoding}\r\n"
+            "Connection: close\r\n\r\n"
+        ).encode()
+    )
+    response = b""
+    while True:
+        data = connection.recv(65536)
+        if not data:
+            break
+        response += data
+        header, _, body = response.partition(b"\r\n\r\n")
+        for line in header.split(b"\r\n"):
+            if line.lower().startswith(b"content-length:"):
+                if len(body) >= int(line.split(b":")[1]):
+                    connection.close()
+                    return time.monotonic() - begin, len(response)
+    connection.close()
+    return time.monotonic() - begin, len(response)
+
+
+def measure_websocket(host, port, duration_s, round_trips):
+    begin = time.monotonic()
+    ws = WebSocket(host, port)
+    connected_s = time.monotonic() - begin
+
+    # Greeting: status, schema, full state, input and parameters
+    first_state_s = None
+    parameters = None
+    while first_state_s is None or parameters is None:
+        is_binary, payload = ws.receive()
+        if is_binary:
+            if first_state_s is None:
+                first_state_s = time.monotonic() - begin
+        else:
+            message = json.loads(payload)
+            if message["type"] == "parameters":
+                parameters = message["data"]
+
+    # Push latency: setting a parameter to its current value goes through the
+    # command queue, the main thread and back as a parameters message
+    name = parameters["definitions"][0]["name"]
+    value = parameters["values"][name]
+    latencies = []
+    for _ in range(round_trips):
+        sent = time.monotonic()
+        ws.send(json.dumps({"type": "set_parameter", "name": name, "value": value}))
+        while True:
+            is_binary, payload = ws.receive()
+            if not is_binary and json.loads(payload)["type"] == "parameters":
+                latencies.append(time.monotonic() - sent)
+                break
+
+    # State deltas: arrival intervals and sizes
+    intervals = []
+    sizes = []
+    last = None
+    end = time.monotonic() + duration_s
+    while time.monotonic() < end:
+        is_binary, payload = ws.receive()
+        if not is_binary:
+            continue
+        now = time.monotonic()
+        if last is not None:
+            intervals.append(now - last)
+        last = now
+        sizes.append(len(payload))
+    ws.close()
+
+    return connected_s, first_state_s, latencies, intervals, sizes
+
+
+def read_rss_kb(pid):
+    with open(f"/proc/{pid}/status") as file:
+        for line in file:
+            if line.startswith("VmRSS:"):
+                return int(line.split()[1])
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure the UI server")
+    parser.add_argument("host", help="Host name of the robot")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--duration", type=float, default=5.0, help="Seconds of state deltas to collect")
+    parser.add_argument("--round-trips", type=int, default=20, help="Number of command round trips")
+    parser.add_argument("--pid", type=int, action="append", default=[], help="Process to report VmRSS of, repeatable")
+    parser.add_argument("--startup", action="store_true", help="First wait for the server to come up")
+    args = parser.parse_args()
+
+    if args.startup:
+        startup_s = measure_startup(args.host, args.port, 60)
+        if startup_s is None:
+            print("Server did not come up within 60 s")
+            return
+        print(f"Startup: first state after {startup_s * 1000:.0f} ms")
+
+    for encoding in ("", "gzip", "br"):
+        elapsed_s, size = measure_http(args.host, args.port, "/", encoding)
+        print(f"HTTP / (Accept-Encoding: {encoding or '-'}): {elapsed_s * 1000:.1f} ms, {size} bytes")
+
+    connected_s, first_state_s, latencies, intervals, sizes = measure_websocket(
+        args.host, args.port, args.duration, args.round_trips
+    )
+    print(f"WebSocket: connected in {connected_s * 1000:.1f} ms, first state after {first_state_s * 1000:.1f} ms")
+    print(
+        f"Command round trip: p50 {percentile(latencies, 0.5) * 1000:.2f} ms, "
+        f"p99 {percentile(latencies, 0.99) * 1000:.2f} ms, max {max(latencies) * 1000:.2f} ms"
+    )
+    if intervals:
+        print(
+            f"State deltas: {len(sizes)} in {args.duration:.0f} s, mean {sum(sizes) / len(sizes):.0f} bytes, "
+            f"interval p50 {percentile(intervals, 0.5) * 1000:.2f} ms, "
+            f"p99 {percentile(intervals, 0.99) * 1000:.2f} ms, max {max(intervals) * 1000:.2f} ms"
+        )
+
+    for pid in args.pid:
+        print(f"VmRSS of {pid}: {read_rss_kb(pid)} kB")
+
+
+if __name__ == "__main__":
+    main()
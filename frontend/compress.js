@@ -0,0 +1,31 @@
+// Writes .br and .gz copies of the text assets in dist, which the native UI
+// server sends instead of the originals when the browser accepts them.
+
+import { readdirSync, readFileSync, statSync, writeFileSync } from "node:fs";
+import { extname, join } from "node:path";
+import { brotliCompressSync, constants, gzipSync } from "node:zlib";
+
+const DIST_PATH = "dist";
+const EXTENSIONS = [".html", ".js", ".css", ".svg", ".json"];
+
+function compress(directory) {
+  for (const name of readdirSync(directory)) {
+    const path = join(directory, name);
+    if (statSync(path).isDirectory()) {
+      compress(path);
+      continue;
+    }
+    if (!EXTENSIONS.includes(extname(name))) continue;
+
+    const data = readFileSync(path);
+    writeFileSync(
+      `${path}.br`,
+      brotliCompressSync(data, {
+        params: { [constants.BROTLI_PARAM_QUALITY]: constants.BROTLI_MAX_QUALITY },
+      })
+    );
+    writeFileSync(`${path}.gz`, gzipSync(data, { level: 9 }));
+  }
+}
+
+compress(DIST_PATH);
@@ -1,9 +1,10 @@
 import { Terminal } from "@xterm/xterm";
-import { useEffect, useRef } from "react";
+import { useEffect, useRef, useState } from "react";
 import { Button } from "./Button";
 import { Card } from "./Card";
-import { Server } from "./core/server";
-import { RobotStatus } from "./core/types";
+import { EncoderTrace, SensorWaterfall } from "./SensorCanvas";
+import { Replay, Server } from "./core/server";
+import { ParameterDefinition, RobotState, RobotStatus } from "./core/types";
 import { useServer } from "./useServer";
 function SensorDataRow({
   low,
@@ -158,12 +159,209 @@ function BatteryMeter({ voltage }: { voltage: number }) {
   );
 }
 
+function InputAgeHistogram({
+  histogram,
+  maxUs,
+}: {
+  histogram: number[];
+  maxUs: number;
+}) {
+  // Age of the oldest sensor sample behind each motor write, log2 buckets
+  const total = histogram.reduce((sum, count) => sum + count, 0);
+  const label = (index: number) =>
+    index === 0 ? "<1us" : `<${formatUs(2 ** index)}`;
+  return (
+    <div>
+      <div className="flex flex-row items-end gap-1 h-[80px]">
+        {histogram.map((count, index) => (
+          <div
+            key={index}
+            className="w-0 grow-1 bg-green-300 rounded-sm"
+            title={`${label(index)}: ${count}`}
+            style={{
+              height: `${total > 0 ? (count / total) * 100 : 0}%`,
+            }}></div>
+        ))}
+      </div>
+      <div className="flex flex-row gap-1 text-gray-400 text-xs text-center">
+        {histogram.map((_, index) => (
+          <div key={index} className="w-0 grow-1">
+            {index % 4 === 0 ? label(index) : ""}
+          </div>
+        ))}
+      </div>
+      <div className="text-gray-400 text-sm font-bold text-center mt-2">
+        Sensor to motor: max {formatUs(maxUs)} over {total} writes
+      </div>
+    </div>
+  );
+}
+
+function formatUs(us: number) {
+  return us >= 1000 ? `${(us / 1000).toFixed(1)}ms` : `${us}us`;
+}
+
+// health_names holds a NUL padded name of 16 bytes per context
+const HEALTH_NAME_SIZE = 16;
+
+function healthName(names: number[], index: number) {
+  const bytes = names.slice(
+    index * HEALTH_NAME_SIZE,
+    (index + 1) * HEALTH_NAME_SIZE
+  );
+  const end = bytes.indexOf(0);
+  return String.fromCharCode(...(end >= 0 ? bytes.slice(0, end) : bytes));
+}
+
+function ThreadHealth({ state }: { state: RobotState }) {
+  // Counters are cumulative since each execution context started, in
+  // topology order. Unused slots stay at zero.
+  const rows = state.health_cpu_time_ms
+    .map((cpuTime, index) => ({ cpuTime, index }))
+    .filter(({ cpuTime }) => cpuTime > 0);
+  return (
+    <table className="w-full text-white text-sm text-right">
+      <thead className="text-gray-400">
+        <tr>
+          <th className="text-left">Context</th>
+          <th>CPU time</th>
+          <th>Faults (minor/major)</th>
+          <th>Switches (vol/invol)</th>
+          <th>Migrations</th>
+        </tr>
+      </thead>
+      <tbody>
+        {rows.map(({ cpuTime, index }) => (
+          <tr key={index}>
+            <td className="text-left">
+              {healthName(state.health_names, index) || index}
+            </td>
+            <td>{(cpuTime / 1000).toFixed(1)}s</td>
+            <td>
+              {state.health_minor_faults[index]} /{" "}
+              {state.health_major_faults[index]}
+            </td>
+            <td>
+              {state.health_voluntary_switches[index]} /{" "}
+              {state.health_involuntary_switches[index]}
+            </td>
+            <td>{state.health_migrations[index]}</td>
+          </tr>
+        ))}
+      </tbody>
+    </table>
+  );
+}
+
+function ParameterRow({
+  definition,
+  value,
+  onChange,
+}: {
+  definition: ParameterDefinition;
+  value: number;
+  onChange: (value: number) => void;
+}) {
+  // Keep the text being edited locally, the robot value is applied on commit
+  const [text, setText] = useState<string | null>(null);
+
+  const commit = () => {
+    if (text === null) return;
+    const parsed = Number(text);
+    if (text !== "" && !Number.isNaN(parsed)) onChange(parsed);
+    setText(null);
+  };
+
+  return (
+    <div className="flex flex-row items-center gap-2">
+      <div className="text-gray-300 text-sm font-bold w-0 grow-1">
+        {definition.name}
+      </div>
+      <input
+        className="w-24 px-2 py-1 rounded-sm bg-gray-700 text-white text-right"
+        type="number"
+        min={definition.min}
+        max={definition.max}
+        step="any"
+        value={text ?? value}
+        onChange={(event) => setText(event.target.value)}
+        onBlur={commit}
+        onKeyDown={(event) => {
+          if (event.key === "Enter") commit();
+        }}
+      />
+      <div className="text-gray-500 text-xs w-20">
+        [{definition.min}, {definition.max}]
+      </div>
+    </div>
+  );
+}
+
 const server = new Server();
 
+type Session = {
+  name: string;
+  start: number | null;
+  end: number | null;
+  bytes: number;
+};
+
+const REPLAY_SPEEDS = [1, 4];
+
+function SessionList({ replay }: { replay: Replay | null }) {
+  const [sessions, setSessions] = useState<Session[]>([]);
+
+  const refresh = () => {
+    fetch("/api/sessions")
+      .then((response) => response.json())
+      .then((list: Session[]) => setSessions(list.reverse()))
+      .catch(() => setSessions([]));
+  };
+  useEffect(refresh, [replay]);
+
+  return (
+    <div className="flex flex-col gap-2">
+      <div className="flex flex-row items-center gap-2">
+        <Button onClick={refresh}>REFRESH</Button>
+        {replay && (
+          <>
+            <Button variant="activated" onClick={() => server.stopReplay()}>
+              STOP_REPLAY
+            </Button>
+            <div className="text-gray-300 text-sm">Replaying {replay.name}</div>
+          </>
+        )}
+      </div>
+      <div className="max-h-48 overflow-y-auto">
+        {sessions.map((session) => (
+          <div
+            key={session.name}
+            className="flex flex-row items-center gap-2 py-1 text-sm">
+            <div className="text-white w-0 grow-1">{session.name}</div>
+            <div className="text-gray-400 w-16 text-right">
+              {session.start !== null && session.end !== null
+                ? `${((session.end - session.start) / 1000).toFixed(1)}s`
+                : "-"}
+            </div>
+            {REPLAY_SPEEDS.map((speed) => (
+              <Button
+                key={speed}
+                onClick={() => server.startReplay(session.name, speed)}>
+                {speed}x
+              </Button>
+            ))}
+          </div>
+        ))}
+      </div>
+    </div>
+  );
+}
+
 function App() {
   useServer(server);
 
   const state = server.getState();
+  const parameters = server.getParameters();
 
   const terminalElementRef = useRef<HTMLDivElement>(null);
 
@@ -236,6 +434,9 @@ function App() {
           <div className="text-white text-2xl font-bold">
             {RobotStatus[state.state]}
           </div>
+          <div className="text-gray-400 text-sm font-bold mt-2">
+            Time to first loop: {state.boot_time_ms} ms
+          </div>
         </Card>
         <Card title="Control">
           <div className="flex flex-wrap gap-2">
@@ -270,6 +471,31 @@ function App() {
               onClick={() => server.sendCommand("drive")}>
               DRIVE
             </Button>
+            <Button
+              variant={
+                state.state === RobotStatus.JITTER ? "activated" : "default"
+              }
+              onClick={() => server.sendCommand("jitter")}>
+              JITTER
+            </Button>
+            <Button onClick={() => server.sendCommand("trace_start")}>
+              TRACE_START
+            </Button>
+            <Button onClick={() => server.sendCommand("trace_stop")}>
+              TRACE_STOP
+            </Button>
+            <Button onClick={() => server.sendCommand("profile_start")}>
+              PROFILE_START
+            </Button>
+            <Button onClick={() => server.sendCommand("profile_stop")}>
+              PROFILE_STOP
+            </Button>
+            <Button onClick={() => server.sendCommand("record_start")}>
+              RECORD_START
+            </Button>
+            <Button onClick={() => server.sendCommand("record_stop")}>
+              RECORD_STOP
+            </Button>
             <Button onClick={() => server.sendCommand("quit")}>QUIT</Button>
           </div>
         </Card>
@@ -286,14 +512,47 @@ function App() {
             ))}
           </div>
         </Card>
+        <Card title="Sensor History">
+          <SensorWaterfall history={server.history} />
+          <br />
+          <EncoderTrace history={server.history} />
+        </Card>
         <Card title="Drive State">
           <Speedometer speed={state.speed} maxSpeed={30} />
           <br />
           <PositionMeter position={state.position} />
+          <br />
+          <InputAgeHistogram
+            histogram={state.input_age_histogram}
+            maxUs={state.input_age_max_us}
+          />
         </Card>
         <Card title="Battery Voltage">
           <BatteryMeter voltage={state.battery_voltage} />
         </Card>
+        <Card title="Thread Health">
+          <ThreadHealth state={state} />
+        </Card>
+        <Card title="Parameters">
+          <div className="flex flex-col gap-2">
+            {parameters.definitions.map((definition) => (
+              <ParameterRow
+                key={definition.name}
+                definition={definition}
+                value={parameters.values[definition.name] ?? definition.default}
+                onChange={(value) => server.setParameter(definition.name, value)}
+              />
+            ))}
+            <div>
+              <Button onClick={() => server.saveParameters()}>
+                SAVE_PARAMETERS
+              </Button>
+            </div>
+          </div>
+        </Card>
+        <Card title="Sessions">
+          <SessionList replay={server.getReplay()} />
+        </Card>
         <Card title="Terminal">
           <div className="rounded-md overflow-hidden p-2 bg-black">
             <div ref={terminalElementRef} />
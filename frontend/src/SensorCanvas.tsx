@@ -0,0 +1,153 @@
+import { useEffect, useRef } from "react";
+import {
+  SAMPLE_ENCODER_LEFT,
+  SAMPLE_ENCODER_RIGHT,
+  SAMPLE_POSITION,
+  SAMPLE_SENSOR_DATA,
+  SAMPLE_SENSORS,
+  SampleHistory,
+} from "./core/history";
+
+// Samples shown across the width of a canvas
+const WINDOW_SAMPLES = 1024;
+
+// Runs draw on every animation frame in which new samples arrived, with the
+// canvas sized to its element in device pixels. React only mounts it.
+type Draw = (
+  history: SampleHistory,
+  context: CanvasRenderingContext2D,
+  first: number,
+  last: number
+) => void;
+
+function useHistoryCanvas(history: SampleHistory, draw: Draw) {
+  const canvasRef = useRef<HTMLCanvasElement>(null);
+
+  useEffect(() => {
+    const canvas = canvasRef.current;
+    const context = canvas?.getContext("2d");
+    if (!canvas || !context) return;
+
+    let drawnCount = -1;
+    let frame = requestAnimationFrame(function render() {
+      const width = Math.round(canvas.clientWidth * devicePixelRatio);
+      const height = Math.round(canvas.clientHeight * devicePixelRatio);
+      if (canvas.width !== width || canvas.height !== height) {
+        canvas.width = width;
+        canvas.height = height;
+        drawnCount = -1;
+      }
+      if (history.count !== drawnCount && history.count > 0) {
+        drawnCount = history.count;
+        const first = Math.max(history.first(), history.count - WINDOW_SAMPLES);
+        draw(history, context, first, history.count);
+      }
+      frame = requestAnimationFrame(render);
+    });
+    return () => cancelAnimationFrame(frame);
+  }, [history, draw]);
+
+  return canvasRef;
+}
+
+// Dark blue to green to yellow, as packed ABGR for a Uint32Array of pixels
+const PALETTE = new Uint32Array(256).map((_, i) => {
+  const t = i / 255;
+  const r = Math.round(255 * Math.max(0, 2 * t - 1));
+  const g = Math.round(255 * Math.min(1, 1.5 * t));
+  const b = Math.round(255 * Math.max(0, 0.5 - t) + 40 * (1 - t));
+  return (0xff << 24) | (b << 16) | (g << 8) | r;
+});
+
+// One column per sample, one row per sensor, scaled up without smoothing
+const heatmap = document.createElement("canvas");
+heatmap.width = WINDOW_SAMPLES;
+heatmap.height = SAMPLE_SENSORS;
+const heatmapContext = heatmap.getContext("2d")!;
+const heatmapImage = heatmapContext.createImageData(WINDOW_SAMPLES, SAMPLE_SENSORS);
+const heatmapPixels = new Uint32Array(heatmapImage.data.buffer);
+
+function drawWaterfall(
+  history: SampleHistory,
+  context: CanvasRenderingContext2D,
+  first: number,
+  last: number
+) {
+  const { width, height } = context.canvas;
+  const columns = last - first;
+  const offset = WINDOW_SAMPLES - columns;
+
+  heatmapPixels.fill(PALETTE[0]);
+  for (let sample = first; sample < last; sample++) {
+    const column = offset + sample - first;
+    for (let sensor = 0; sensor < SAMPLE_SENSORS; sensor++) {
+      const value = history.get(sample, SAMPLE_SENSOR_DATA + sensor);
+      const index = Math.max(0, Math.min(255, Math.round(value * 255)));
+      heatmapPixels[sensor * WINDOW_SAMPLES + column] = PALETTE[index];
+    }
+  }
+  heatmapContext.putImageData(heatmapImage, 0, 0);
+  context.imageSmoothingEnabled = false;
+  context.drawImage(heatmap, 0, 0, width, height);
+
+  // Line position on the same axis as the sensors, -1 at the first
+  context.strokeStyle = "white";
+  context.lineWidth = devicePixelRatio;
+  context.beginPath();
+  for (let sample = first; sample < last; sample++) {
+    const x = ((offset + sample - first + 0.5) / WINDOW_SAMPLES) * width;
+    const y = ((history.get(sample, SAMPLE_POSITION) + 1) / 2) * height;
+    if (sample === first) context.moveTo(x, y);
+    else context.lineTo(x, y);
+  }
+  context.stroke();
+}
+
+function drawEncoders(
+  history: SampleHistory,
+  context: CanvasRenderingContext2D,
+  first: number,
+  last: number
+) {
+  const { width, height } = context.canvas;
+  context.clearRect(0, 0, width, height);
+
+  // Autoscaled to the counts in the window
+  let min = Infinity;
+  let max = -Infinity;
+  for (let sample = first; sample < last; sample++) {
+    for (const field of [SAMPLE_ENCODER_LEFT, SAMPLE_ENCODER_RIGHT]) {
+      const value = history.get(sample, field);
+      min = Math.min(min, value);
+      max = Math.max(max, value);
+    }
+  }
+  const range = max > min ? max - min : 1;
+  const offset = WINDOW_SAMPLES - (last - first);
+
+  context.lineWidth = devicePixelRatio;
+  for (const [field, color] of [
+    [SAMPLE_ENCODER_LEFT, "#93c5fd"],
+    [SAMPLE_ENCODER_RIGHT, "#fca5a5"],
+  ] as const) {
+    context.strokeStyle = color;
+    context.beginPath();
+    for (let sample = first; sample < last; sample++) {
+      const x = ((offset + sample - first + 0.5) / WINDOW_SAMPLES) * width;
+      const y = height - ((history.get(sample, field) - min) / range) * height;
+      if (sample === first) context.moveTo(x, y);
+      else context.lineTo(x, y);
+    }
+    context.stroke();
+  }
+}
+
+export function SensorWaterfall({ history }: { history: SampleHistory }) {
+  const canvasRef = useHistoryCanvas(history, drawWaterfall);
+  return <canvas ref={canvasRef} className="w-full h-40 rounded-sm" />;
+}
+
+export function EncoderTrace({ history }: { history: SampleHistory }) {
+  const canvasRef = useHistoryCanvas(history, drawEncoders);
+  return <canvas ref={canvasRef} className="w-full h-24 rounded-sm bg-gray-700" />;
+}
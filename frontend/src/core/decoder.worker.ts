@@ -0,0 +1,100 @@
+// Owns the WebSocket so that decoding never blocks rendering. Every state
+// delta becomes a sample for the canvases, batched per SAMPLE_INTERVAL,
+// while the full state only goes to React every STATE_INTERVAL.
+
+import {
+  SAMPLE_ENCODER_LEFT,
+  SAMPLE_ENCODER_RIGHT,
+  SAMPLE_POSITION,
+  SAMPLE_SENSOR_DATA,
+  SAMPLE_SENSORS,
+  SAMPLE_STRIDE,
+  SAMPLE_TIME,
+} from "./history";
+import {
+  createRobotState,
+  decodeStateDelta,
+  STATE_MESSAGE_DELTA,
+} from "./state-codec";
+import type { FromWorker, ToWorker } from "./worker-protocol";
+
+const SAMPLE_INTERVAL = 16; // ms, about once per frame
+const STATE_INTERVAL = 100; // ms
+const RECONNECT_INTERVAL = 1000; // ms
+const BATCH_CAPACITY = 1024;
+
+let ws: WebSocket | null = null;
+let state = createRobotState();
+let isStateChanged = false;
+
+let batch = new Float64Array(BATCH_CAPACITY * SAMPLE_STRIDE);
+let batchCount = 0;
+
+function post(message: FromWorker, transfer: Transferable[] = []) {
+  self.postMessage(message, { transfer });
+}
+
+function flushSamples() {
+  if (batchCount === 0) return;
+  post({ type: "samples", data: batch, count: batchCount }, [batch.buffer]);
+  batch = new Float64Array(BATCH_CAPACITY * SAMPLE_STRIDE);
+  batchCount = 0;
+}
+
+function flushState() {
+  if (!isStateChanged) return;
+  post({ type: "state", data: state });
+  isStateChanged = false;
+}
+
+function addSample() {
+  if (batchCount === BATCH_CAPACITY) flushSamples();
+  const base = batchCount * SAMPLE_STRIDE;
+  batch[base + SAMPLE_TIME] = performance.timeOrigin + performance.now();
+  for (let i = 0; i < SAMPLE_SENSORS; i++) {
+    batch[base + SAMPLE_SENSOR_DATA + i] = state.sensor_data[i];
+  }
+  batch[base + SAMPLE_POSITION] = state.position;
+  batch[base + SAMPLE_ENCODER_LEFT] = state.encoder_left;
+  batch[base + SAMPLE_ENCODER_RIGHT] = state.encoder_right;
+  batchCount++;
+}
+
+function handleMessage(event: MessageEvent) {
+  // State updates are binary deltas, everything else is JSON
+  if (event.data instanceof ArrayBuffer) {
+    const view = new DataView(event.data);
+    if (view.getUint8(0) !== STATE_MESSAGE_DELTA) {
+      console.log("Unknown binary message type:", view.getUint8(0));
+      return;
+    }
+    decodeStateDelta(view, state);
+    isStateChanged = true;
+    addSample();
+    return;
+  }
+  post({ type: "message", data: JSON.parse(event.data) });
+}
+
+function connect() {
+  const url = new URL("/", self.location.href);
+  url.protocol = url.protocol === "https:" ? "wss:" : "ws:";
+
+  ws = new WebSocket(url);
+  ws.binaryType = "arraybuffer";
+  ws.onopen = () => post({ type: "connectionStatus", data: "connected" });
+  ws.onmessage = handleMessage;
+  ws.onclose = () => {
+    ws = null;
+    post({ type: "connectionStatus", data: "connecting" });
+    setTimeout(connect, RECONNECT_INTERVAL);
+  };
+}
+
+self.onmessage = (event: MessageEvent<ToWorker>) => {
+  if (event.data.type === "send") ws?.send(event.data.data);
+};
+
+setInterval(flushSamples, SAMPLE_INTERVAL);
+setInterval(flushState, STATE_INTERVAL);
+connect();
@@ -0,0 +1,46 @@
+// Ring buffer of the recent state samples that the canvases draw from,
+// filled by the decoder worker without going through React.
+
+export const SAMPLE_SENSORS = 16;
+
+// Layout of one sample: time (ms since epoch), sensor_data, position and
+// the encoder counts
+export const SAMPLE_TIME = 0;
+export const SAMPLE_SENSOR_DATA = 1;
+export const SAMPLE_POSITION = SAMPLE_SENSOR_DATA + SAMPLE_SENSORS;
+export const SAMPLE_ENCODER_LEFT = SAMPLE_POSITION + 1;
+export const SAMPLE_ENCODER_RIGHT = SAMPLE_POSITION + 2;
+export const SAMPLE_STRIDE = SAMPLE_POSITION + 3;
+
+export class SampleHistory {
+  readonly capacity: number;
+  readonly data: Float64Array;
+
+  // Number of samples ever pushed, sample n lives at slot n % capacity
+  count = 0;
+
+  constructor(capacity: number) {
+    this.capacity = capacity;
+    this.data = new Float64Array(capacity * SAMPLE_STRIDE);
+  }
+
+  push(samples: Float64Array, count: number) {
+    for (let i = 0; i < count; i++) {
+      const slot = (this.count % this.capacity) * SAMPLE_STRIDE;
+      this.data.set(
+        samples.subarray(i * SAMPLE_STRIDE, (i + 1) * SAMPLE_STRIDE),
+        slot
+      );
+      this.count++;
+    }
+  }
+
+  // Oldest sample that is still held
+  first() {
+    return Math.max(0, this.count - this.capacity);
+  }
+
+  get(sample: number, field: number) {
+    return this.data[(sample % this.capacity) * SAMPLE_STRIDE + field];
+  }
+}
@@ -1,8 +1,12 @@
-import { RobotStatus } from "./types";
+import { SampleHistory } from "./history";
+import { Parameters, RobotState } from "./types";
+import { createRobotState, STATE_SCHEMA_VERSION } from "./state-codec";
+import type { ConnectionStatus, FromWorker } from "./worker-protocol";
 
-import { RobotState } from "./types";
+export type { ConnectionStatus } from "./worker-protocol";
 
-export type ConnectionStatus = "connecting" | "connected";
+// Samples kept for the canvases, seconds at a 1 kHz input rate
+const HISTORY_CAPACITY = 8192;
 
 export type ServerStatus = "INITIALIZING" | "INITIALIZED" | "ERROR";
 
@@ -22,55 +26,84 @@ export type ServerEvent =
   | {
       type: "state";
       data: RobotState;
+    }
+  | {
+      type: "parameters";
+      data: Parameters;
+    }
+  | {
+      type: "replay";
+      data: Replay;
     };
 
+// A recorded session being replayed instead of the live state
+export type Replay = {
+  name: string;
+  active: boolean;
+};
+
 export class Server {
-  private ws: WebSocket | null = null;
+  // The WebSocket and the decoding live in a worker, see decoder.worker.ts
+  private worker: Worker;
 
   private connectionStatus: ConnectionStatus = "connecting";
   private serverStatus: ServerStatus = "INITIALIZING";
   private inputs: ServerEvent[] = [];
 
-  private state: RobotState = {
-    state: RobotStatus.IDLE,
-    sensor_raw: Array(16).fill(0),
-    sensor_data: Array(16).fill(0),
-    position: 0,
-    sensor_low: Array(16).fill(0),
-    sensor_high: Array(16).fill(0),
-    encoder_left: 0,
-    encoder_right: 0,
-    speed: 0,
-    battery_voltage: 0,
-  };
+  private state: RobotState = createRobotState();
+  private parameters: Parameters = { definitions: [], values: {} };
+  private replay: Replay | null = null;
   private listeners: ((data: ServerEvent) => void)[] = [];
 
-  constructor() {
-    this.initializeWebSocket();
-  }
+  // Every state sample, for drawing outside of React
+  readonly history = new SampleHistory(HISTORY_CAPACITY);
 
-  private initializeWebSocket() {
-    this.ws = new WebSocket("/");
-    this.ws.onopen = () => this.handleWebSocketOpen();
-    this.ws.onmessage = (event) => this.handleWebSocketMessage(event);
-    this.ws.onclose = () => this.handleWebSocketDisconnect();
+  constructor() {
+    this.worker = new Worker(new URL("./decoder.worker.ts", import.meta.url), {
+      type: "module",
+    });
+    this.worker.onmessage = (event: MessageEvent<FromWorker>) =>
+      this.handleWorkerMessage(event.data);
   }
 
-  private handleWebSocketOpen() {
-    this.connectionStatus = "connected";
-    this.notify({ type: "connectionStatus", data: this.connectionStatus });
+  private handleWorkerMessage(message: FromWorker) {
+    switch (message.type) {
+      case "samples":
+        this.history.push(message.data, message.count);
+        break;
+      case "state":
+        // Already throttled by the worker
+        this.state = message.data;
+        this.notify({ type: "state", data: this.state });
+        break;
+      case "connectionStatus":
+        this.connectionStatus = message.data;
+        this.notify({ type: "connectionStatus", data: this.connectionStatus });
+        break;
+      case "message":
+        this.handleServerMessage(message.data);
+        break;
+    }
   }
 
-  private handleWebSocketMessage(event: MessageEvent<any>) {
-    const data = JSON.parse(event.data);
+  private handleServerMessage(data: any) {
     switch (data.type) {
+      case "schema":
+        if (data.data.version !== STATE_SCHEMA_VERSION) {
+          console.error("State schema mismatch, re-run state-gen");
+        }
+        break;
       case "status":
         this.serverStatus = data.data;
         this.notify({ type: "serverStatus", data: this.serverStatus });
         break;
-      case "state":
-        this.state = data.data;
-        this.notify({ type: "state", data: this.state });
+      case "parameters":
+        this.parameters = data.data;
+        this.notify({ type: "parameters", data: this.parameters });
+        break;
+      case "replay":
+        this.replay = data.data.active ? data.data : null;
+        this.notify({ type: "replay", data: data.data });
         break;
       case "input":
         this.inputs.push({ type: "input", data: data.data });
@@ -82,13 +115,8 @@ export class Server {
     }
   }
 
-  private handleWebSocketDisconnect() {
-    this.ws?.close();
-    this.connectionStatus = "connecting";
-    this.notify({ type: "connectionStatus", data: this.connectionStatus });
-    setTimeout(() => {
-      this.initializeWebSocket();
-    }, 1000);
+  private send(data: string) {
+    this.worker.postMessage({ type: "send", data });
   }
 
   private notify(data: ServerEvent) {
@@ -104,7 +132,27 @@ export class Server {
   }
 
   public sendCommand(command: string) {
-    this.ws?.send(command);
+    this.send(command);
+  }
+
+  public setParameter(name: string, value: number) {
+    this.send(JSON.stringify({ type: "set_parameter", name, value }));
+  }
+
+  public saveParameters() {
+    this.send(JSON.stringify({ type: "save_parameters" }));
+  }
+
+  public startReplay(name: string, speed: number) {
+    this.send(JSON.stringify({ type: "replay", name, speed }));
+  }
+
+  public stopReplay() {
+    this.send(JSON.stringify({ type: "replay_stop" }));
+  }
+
+  public getReplay() {
+    return this.replay;
   }
 
   public getConnectionStatus() {
@@ -118,4 +166,8 @@ export class Server {
   public getState() {
     return this.state;
   }
+
+  public getParameters() {
+    return this.parameters;
+  }
 }
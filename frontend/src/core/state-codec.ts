@@ -0,0 +1,374 @@
+// This file is automatically generated by state-gen script
+// Do not edit this file manually
+export enum RobotStatus {
+  HALT = 0x00,
+  IDLE = 0x01,
+  CALI_HIGH = 0x02,
+  CALI_LOW = 0x04,
+  DRIVE = 0x08,
+  MUSIC = 0x10,
+  JITTER = 0x20,
+}
+
+export interface RobotState {
+  state: RobotStatus;
+  generation: number;
+  boot_time_ms: number;
+  sensor_low: number[];
+  sensor_high: number[];
+  sensor_raw: number[];
+  sensor_data: number[];
+  position: number;
+  speed: number;
+  battery_voltage: number;
+  track: number;
+  input_age_histogram: number[];
+  input_age_max_us: number;
+  encoder_left: number;
+  encoder_right: number;
+  encoder_rate: number;
+  health_minor_faults: number[];
+  health_major_faults: number[];
+  health_voluntary_switches: number[];
+  health_involuntary_switches: number[];
+  health_migrations: number[];
+  health_cpu_time_ms: number[];
+  health_names: number[];
+}
+
+export const STATE_MESSAGE_DELTA = 0x01;
+export const STATE_SCHEMA_VERSION = 3783565041;
+
+export function createRobotState(): RobotState {
+  return {
+    state: 0,
+    generation: 0,
+    boot_time_ms: 0,
+    sensor_low: Array(16).fill(0),
+    sensor_high: Array(16).fill(0),
+    sensor_raw: Array(16).fill(0),
+    sensor_data: Array(16).fill(0),
+    position: 0,
+    speed: 0,
+    battery_voltage: 0,
+    track: 0,
+    input_age_histogram: Array(16).fill(0),
+    input_age_max_us: 0,
+    encoder_left: 0,
+    encoder_right: 0,
+    encoder_rate: 0,
+    health_minor_faults: Array(8).fill(0),
+    health_major_faults: Array(8).fill(0),
+    health_voluntary_switches: Array(8).fill(0),
+    health_involuntary_switches: Array(8).fill(0),
+    health_migrations: Array(8).fill(0),
+    health_cpu_time_ms: Array(8).fill(0),
+    health_names: Array(128).fill(0),
+  };
+}
+
+type SlotType = "double" | "int32" | "uint16" | "uint32" | "uint8";
+
+// Slot table: [field, element index or -1 for scalars, value type]
+const slots: [keyof RobotState, number, SlotType][] = [
+  ["state", -1, "uint32"],
+  ["generation", -1, "uint32"],
+  ["boot_time_ms", -1, "uint32"],
+  ["sensor_low", 0, "uint16"],
+  ["sensor_low", 1, "uint16"],
+  ["sensor_low", 2, "uint16"],
+  ["sensor_low", 3, "uint16"],
+  ["sensor_low", 4, "uint16"],
+  ["sensor_low", 5, "uint16"],
+  ["sensor_low", 6, "uint16"],
+  ["sensor_low", 7, "uint16"],
+  ["sensor_low", 8, "uint16"],
+  ["sensor_low", 9, "uint16"],
+  ["sensor_low", 10, "uint16"],
+  ["sensor_low", 11, "uint16"],
+  ["sensor_low", 12, "uint16"],
+  ["sensor_low", 13, "uint16"],
+  ["sensor_low", 14, "uint16"],
+  ["sensor_low", 15, "uint16"],
+  ["sensor_high", 0, "uint16"],
+  ["sensor_high", 1, "uint16"],
+  ["sensor_high", 2, "uint16"],
+  ["sensor_high", 3, "uint16"],
+  ["sensor_high", 4, "uint16"],
+  ["sensor_high", 5, "uint16"],
+  ["sensor_high", 6, "uint16"],
+  ["sensor_high", 7, "uint16"],
+  ["sensor_high", 8, "uint16"],
+  ["sensor_high", 9, "uint16"],
+  ["sensor_high", 10, "uint16"],
+  ["sensor_high", 11, "uint16"],
+  ["sensor_high", 12, "uint16"],
+  ["sensor_high", 13, "uint16"],
+  ["sensor_high", 14, "uint16"],
+  ["sensor_high", 15, "uint16"],
+  ["sensor_raw", 0, "uint16"],
+  ["sensor_raw", 1, "uint16"],
+  ["sensor_raw", 2, "uint16"],
+  ["sensor_raw", 3, "uint16"],
+  ["sensor_raw", 4, "uint16"],
+  ["sensor_raw", 5, "uint16"],
+  ["sensor_raw", 6, "uint16"],
+  ["sensor_raw", 7, "uint16"],
+  ["sensor_raw", 8, "uint16"],
+  ["sensor_raw", 9, "uint16"],
+  ["sensor_raw", 10, "uint16"],
+  ["sensor_raw", 11, "uint16"],
+  ["sensor_raw", 12, "uint16"],
+  ["sensor_raw", 13, "uint16"],
+  ["sensor_raw", 14, "uint16"],
+  ["sensor_raw", 15, "uint16"],
+  ["sensor_data", 0, "double"],
+  ["sensor_data", 1, "double"],
+  ["sensor_data", 2, "double"],
+  ["sensor_data", 3, "double"],
+  ["sensor_data", 4, "double"],
+  ["sensor_data", 5, "double"],
+  ["sensor_data", 6, "double"],
+  ["sensor_data", 7, "double"],
+  ["sensor_data", 8, "double"],
+  ["sensor_data", 9, "double"],
+  ["sensor_data", 10, "double"],
+  ["sensor_data", 11, "double"],
+  ["sensor_data", 12, "double"],
+  ["sensor_data", 13, "double"],
+  ["sensor_data", 14, "double"],
+  ["sensor_data", 15, "double"],
+  ["position", -1, "double"],
+  ["speed", -1, "double"],
+  ["battery_voltage", -1, "double"],
+  ["track", -1, "uint8"],
+  ["input_age_histogram", 0, "uint32"],
+  ["input_age_histogram", 1, "uint32"],
+  ["input_age_histogram", 2, "uint32"],
+  ["input_age_histogram", 3, "uint32"],
+  ["input_age_histogram", 4, "uint32"],
+  ["input_age_histogram", 5, "uint32"],
+  ["input_age_histogram", 6, "uint32"],
+  ["input_age_histogram", 7, "uint32"],
+  ["input_age_histogram", 8, "uint32"],
+  ["input_age_histogram", 9, "uint32"],
+  ["input_age_histogram", 10, "uint32"],
+  ["input_age_histogram", 11, "uint32"],
+  ["input_age_histogram", 12, "uint32"],
+  ["input_age_histogram", 13, "uint32"],
+  ["input_age_histogram", 14, "uint32"],
+  ["input_age_histogram", 15, "uint32"],
+  ["input_age_max_us", -1, "uint32"],
+  ["encoder_left", -1, "int32"],
+  ["encoder_right", -1, "int32"],
+  ["encoder_rate", -1, "uint32"],
+  ["health_minor_faults", 0, "uint32"],
+  ["health_minor_faults", 1, "uint32"],
+  ["health_minor_faults", 2, "uint32"],
+  ["health_minor_faults", 3, "uint32"],
+  ["health_minor_faults", 4, "uint32"],
+  ["health_minor_faults", 5, "uint32"],
+  ["health_minor_faults", 6, "uint32"],
+  ["health_minor_faults", 7, "uint32"],
+  ["health_major_faults", 0, "uint32"],
+  ["health_major_faults", 1, "uint32"],
+  ["health_major_faults", 2, "uint32"],
+  ["health_major_faults", 3, "uint32"],
+  ["health_major_faults", 4, "uint32"],
+  ["health_major_faults", 5, "uint32"],
+  ["health_major_faults", 6, "uint32"],
+  ["health_major_faults", 7, "uint32"],
+  ["health_voluntary_switches", 0, "uint32"],
+  ["health_voluntary_switches", 1, "uint32"],
+  ["health_voluntary_switches", 2, "uint32"],
+  ["health_voluntary_switches", 3, "uint32"],
+  ["health_voluntary_switches", 4, "uint32"],
+  ["health_voluntary_switches", 5, "uint32"],
+  ["health_voluntary_switches", 6, "uint32"],
+  ["health_voluntary_switches", 7, "uint32"],
+  ["health_involuntary_switches", 0, "uint32"],
+  ["health_involuntary_switches", 1, "uint32"],
+  ["health_involuntary_switches", 2, "uint32"],
+  ["health_involuntary_switches", 3, "uint32"],
+  ["health_involuntary_switches", 4, "uint32"],
+  ["health_involuntary_switches", 5, "uint32"],
+  ["health_involuntary_switches", 6, "uint32"],
+  ["health_involuntary_switches", 7, "uint32"],
+  ["health_migrations", 0, "uint32"],
+  ["health_migrations", 1, "uint32"],
+  ["health_migrations", 2, "uint32"],
+  ["health_migrations", 3, "uint32"],
+  ["health_migrations", 4, "uint32"],
+  ["health_migrations", 5, "uint32"],
+  ["health_migrations", 6, "uint32"],
+  ["health_migrations", 7, "uint32"],
+  ["health_cpu_time_ms", 0, "uint32"],
+  ["health_cpu_time_ms", 1, "uint32"],
+  ["health_cpu_time_ms", 2, "uint32"],
+  ["health_cpu_time_ms", 3, "uint32"],
+  ["health_cpu_time_ms", 4, "uint32"],
+  ["health_cpu_time_ms", 5, "uint32"],
+  ["health_cpu_time_ms", 6, "uint32"],
+  ["health_cpu_time_ms", 7, "uint32"],
+  ["health_names", 0, "uint8"],
+  ["health_names", 1, "uint8"],
+  ["health_names", 2, "uint8"],
+  ["health_names", 3, "uint8"],
+  ["health_names", 4, "uint8"],
+  ["health_names", 5, "uint8"],
+  ["health_names", 6, "uint8"],
+  ["health_names", 7, "uint8"],
+  ["health_names", 8, "uint8"],
+  ["health_names", 9, "uint8"],
+  ["health_names", 10, "uint8"],
+  ["health_names", 11, "uint8"],
+  ["health_names", 12, "uint8"],
+  ["health_names", 13, "uint8"],
+  ["health_names", 14, "uint8"],
+  ["health_names", 15, "uint8"],
+  ["health_names", 16, "uint8"],
+  ["health_names", 17, "uint8"],
+  ["health_names", 18, "uint8"],
+  ["health_names", 19, "uint8"],
+  ["health_names", 20, "uint8"],
+  ["health_names", 21, "uint8"],
+  ["health_names", 22, "uint8"],
+  ["health_names", 23, "uint8"],
+  ["health_names", 24, "uint8"],
+  ["health_names", 25, "uint8"],
+  ["health_names", 26, "uint8"],
+  ["health_names", 27, "uint8"],
+  ["health_names", 28, "uint8"],
+  ["health_names", 29, "uint8"],
+  ["health_names", 30, "uint8"],
+  ["health_names", 31, "uint8"],
+  ["health_names", 32, "uint8"],
+  ["health_names", 33, "uint8"],
+  ["health_names", 34, "uint8"],
+  ["health_names", 35, "uint8"],
+  ["health_names", 36, "uint8"],
+  ["health_names", 37, "uint8"],
+  ["health_names", 38, "uint8"],
+  ["health_names", 39, "uint8"],
+  ["health_names", 40, "uint8"],
+  ["health_names", 41, "uint8"],
+  ["health_names", 42, "uint8"],
+  ["health_names", 43, "uint8"],
+  ["health_names", 44, "uint8"],
+  ["health_names", 45, "uint8"],
+  ["health_names", 46, "uint8"],
+  ["health_names", 47, "uint8"],
+  ["health_names", 48, "uint8"],
+  ["health_names", 49, "uint8"],
+  ["health_names", 50, "uint8"],
+  ["health_names", 51, "uint8"],
+  ["health_names", 52, "uint8"],
+  ["health_names", 53, "uint8"],
+  ["health_names", 54, "uint8"],
+  ["health_names", 55, "uint8"],
+  ["health_names", 56, "uint8"],
+  ["health_names", 57, "uint8"],
+  ["health_names", 58, "uint8"],
+  ["health_names", 59, "uint8"],
+  ["health_names", 60, "uint8"],
+  ["health_names", 61, "uint8"],
+  ["health_names", 62, "uint8"],
+  ["health_names", 63, "uint8"],
+  ["health_names", 64, "uint8"],
+  ["health_names", 65, "uint8"],
+  ["health_names", 66, "uint8"],
+  ["health_names", 67, "uint8"],
+  ["health_names", 68, "uint8"],
+  ["health_names", 69, "uint8"],
+  ["health_names", 70, "uint8"],
+  ["health_names", 71, "uint8"],
+  ["health_names", 72, "uint8"],
+  ["health_names", 73, "uint8"],
+  ["health_names", 74, "uint8"],
+  ["health_names", 75, "uint8"],
+  ["health_names", 76, "uint8"],
+  ["health_names", 77, "uint8"],
+  ["health_names", 78, "uint8"],
+  ["health_names", 79, "uint8"],
+  ["health_names", 80, "uint8"],
+  ["health_names", 81, "uint8"],
+  ["health_names", 82, "uint8"],
+  ["health_names", 83, "uint8"],
+  ["health_names", 84, "uint8"],
+  ["health_names", 85, "uint8"],
+  ["health_names", 86, "uint8"],
+  ["health_names", 87, "uint8"],
+  ["health_names", 88, "uint8"],
+  ["health_names", 89, "uint8"],
+  ["health_names", 90, "uint8"],
+  ["health_names", 91, "uint8"],
+  ["health_names", 92, "uint8"],
+  ["health_names", 93, "uint8"],
+  ["health_names", 94, "uint8"],
+  ["health_names", 95, "uint8"],
+  ["health_names", 96, "uint8"],
+  ["health_names", 97, "uint8"],
+  ["health_names", 98, "uint8"],
+  ["health_names", 99, "uint8"],
+  ["health_names", 100, "uint8"],
+  ["health_names", 101, "uint8"],
+  ["health_names", 102, "uint8"],
+  ["health_names", 103, "uint8"],
+  ["health_names", 104, "uint8"],
+  ["health_names", 105, "uint8"],
+  ["health_names", 106, "uint8"],
+  ["health_names", 107, "uint8"],
+  ["health_names", 108, "uint8"],
+  ["health_names", 109, "uint8"],
+  ["health_names", 110, "uint8"],
+  ["health_names", 111, "uint8"],
+  ["health_names", 112, "uint8"],
+  ["health_names", 113, "uint8"],
+  ["health_names", 114, "uint8"],
+  ["health_names", 115, "uint8"],
+  ["health_names", 116, "uint8"],
+  ["health_names", 117, "uint8"],
+  ["health_names", 118, "uint8"],
+  ["health_names", 119, "uint8"],
+  ["health_names", 120, "uint8"],
+  ["health_names", 121, "uint8"],
+  ["health_names", 122, "uint8"],
+  ["health_names", 123, "uint8"],
+  ["health_names", 124, "uint8"],
+  ["health_names", 125, "uint8"],
+  ["health_names", 126, "uint8"],
+  ["health_names", 127, "uint8"],
+];
+
+// Returns the value of the given type at offset, and its size
+function readValue(view: DataView, offset: number, type: SlotType): [number, number] {
+  switch (type) {
+    case "double":
+      return [view.getFloat64(offset, true), 8];
+    case "int32":
+      return [view.getInt32(offset, true), 4];
+    case "uint16":
+      return [view.getUint16(offset, true), 2];
+    case "uint32":
+      return [view.getUint32(offset, true), 4];
+    case "uint8":
+      return [view.getUint8(offset), 1];
+  }
+}
+
+export function decodeStateDelta(view: DataView, state: RobotState) {
+  const count = view.getUint16(1, true);
+  let offset = 3;
+  for (let i = 0; i < count; i++) {
+    const slot = view.getUint16(offset, true);
+    const [field, index, type] = slots[slot];
+    const [value, size] = readValue(view, offset + 2, type);
+    const fields = state as unknown as Record<string, number | number[]>;
+    if (index < 0) {
+      fields[field] = value;
+    } else {
+      (fields[field] as number[])[index] = value;
+    }
+    offset += 2 + size;
+  }
+}
@@ -1,20 +1,14 @@
-export enum RobotStatus {
-  EXIT = 0x00,
-  IDLE = 0x01,
-  CALI_LOW = 0x02,
-  CALI_HIGH = 0x03,
-  DRIVE = 0x04,
-}
+// The robot state and status are generated from state-definition.json
+export { RobotStatus, type RobotState } from "./state-codec";
 
-export interface RobotState {
-  state: RobotStatus;
-  sensor_low: number[];
-  sensor_high: number[];
-  sensor_raw: number[];
-  sensor_data: number[];
-  position: number;
-  speed: number;
-  battery_voltage: number;
-  encoder_left: number;
-  encoder_right: number;
-}
+export type ParameterDefinition = {
+  name: string;
+  default: number;
+  min: number;
+  max: number;
+};
+
+export type Parameters = {
+  definitions: ParameterDefinition[];
+  values: Record<string, number>;
+};
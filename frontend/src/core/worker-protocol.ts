@@ -0,0 +1,12 @@
+import type { RobotState } from "./state-codec";
+
+export type ConnectionStatus = "connecting" | "connected";
+
+// Messages between the decoder worker and the main thread
+export type FromWorker =
+  | { type: "connectionStatus"; data: ConnectionStatus }
+  | { type: "message"; data: any } // A JSON message from the server
+  | { type: "state"; data: RobotState }
+  | { type: "samples"; data: Float64Array; count: number };
+
+export type ToWorker = { type: "send"; data: string };
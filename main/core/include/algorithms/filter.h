@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NUM_SENSORS 16
+
+/*
+ * Filters over count frames of NUM_SENSORS values each, every sensor on its
+ * own. output has the same layout and may not overlap frames, except for
+ * filter_iir.
+ *
+ * The window filters are causal: output frame i is taken over frames
+ * (i - window, i], or over all frames up to i for the first ones.
+ */
+
+// output = gain * frame + (1 - gain) * previous output, from the first frame
+void filter_iir(const double *frames, uint32_t count, double gain, double *output);
+void filter_mean(const double *frames, uint32_t count, uint32_t window, double *output);
+// scratch holds FILTER_MEDIAN_SCRATCH(window) values. An even window gives
+// the mean of the two middle values.
+#define FILTER_MEDIAN_SCRATCH(window) ((size_t)(window) * NUM_SENSORS)
+void filter_median(const double *frames, uint32_t count, uint32_t window, double *scratch, double *output);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NUM_SENSORS 16
+#define LINE_NUM_CANDIDATES 1000
+
+#define LINE_DEFAULT_GATE 0.3         // Sensors further from the previous position are ignored
+#define LINE_DEFAULT_PRIOR_WEIGHT 4.0 // Cost of moving away from the previous position
+
+typedef struct
+{
+  double gate;         // Weighted sum only
+  double prior_weight; // Bayesian only
+} line_config_t;
+
+void line_config_init(line_config_t *config);
+
+// Weighted sum of the sensor positions near prev_position. Returns false,
+// leaving position alone, if no sensor is in range. used gets a bit per
+// sensor that contributed.
+bool line_weighted_sum(const line_config_t *config, const double *sensor_data, double prev_position, double *position, uint32_t *used);
+
+// Candidate position that best explains the sensor values, given a prior
+// around prev_position. Every sensor contributes.
+double line_bayesian(const line_config_t *config, const double *sensor_data, double prev_position);
+
+// The estimators over count frames of NUM_SENSORS values each, chained as
+// the line service does: every frame starts from the position of the one
+// before, the first from initial_position. Where the weighted sum finds no
+// sensor in range the previous position is kept and used is 0. used may be
+// NULL.
+void line_weighted_sum_batch(const line_config_t *config, const double *frames, uint32_t count, double initial_position, double *positions, uint32_t *used);
+void line_bayesian_batch(const line_config_t *config, const double *frames, uint32_t count, double initial_position, double *positions);
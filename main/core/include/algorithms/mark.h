@@ -11,8 +11,13 @@
 #define MARK_BOTH 0x03
 #define MARK_CROSS 0x04
 
+#define MARK_DEFAULT_THRESHOLD 0.8   // Sensor value that counts as a mark
+#define MARK_DEFAULT_SIDE_MARGIN 0.25 // Distance from the line to count as a side
+
 typedef struct
 {
+  double threshold;
+  double side_margin;
   uint8_t state;
   bool is_left;
   bool is_right;
@@ -20,4 +25,7 @@ typedef struct
 } mark_t;
 
 void mark_init(mark_t *mark);
-uint8_t mark_state_machine(mark_t *mark, double *sensor_data, double position);
+uint8_t mark_state_machine(mark_t *mark, const double *sensor_data, double position);
+// mark_state_machine() over count frames of NUM_SENSORS values each, with the
+// position of every frame. marks gets a MARK_* per frame.
+void mark_batch(mark_t *mark, const double *frames, const double *positions, uint32_t count, uint8_t *marks);
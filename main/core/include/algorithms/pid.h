@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 typedef struct
 {
   double kP;
@@ -12,3 +14,5 @@ typedef struct
 
 void pid_init(pid_control_t *pid);
 double pid_update(pid_control_t *pid, double current, double dt);
+// pid_update() over count steps, with the target and the time step of each.
+void pid_batch(pid_control_t *pid, const double *targets, const double *currents, const double *dts, uint32_t count, double *outputs);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <ports/timer.h>
+
+#define BOOT_MAX_STEPS 32
+
+// Time a startup step and add it to the boot timeline
+#define BOOT_STEP(name, step)                                  \
+  do                                                           \
+  {                                                            \
+    uint64_t boot_begin_ns = timer_get_timestamp_ns();         \
+    step;                                                      \
+    boot_record((name), boot_begin_ns, timer_get_timestamp_ns()); \
+  } while (0)
+
+/*
+ * Boot timeline.
+ *
+ * Steps may be recorded from any thread. Each execution context reports
+ * when its setup phase is done, so that its next iteration is its first
+ * loop. boot_report() then prints the timeline and the time from process
+ * start to the first loop of the last context, publishes it in
+ * state->boot_time_ms and appends it to the boot history file.
+ */
+void boot_init();
+void boot_record(const char *name, uint64_t begin_ns, uint64_t end_ns);
+void boot_context_ready(const char *name, uint64_t begin_ns);
+bool boot_wait_ready(uint32_t num_contexts, uint32_t timeout_ms);
+void boot_report();
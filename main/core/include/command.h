@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define COMMAND_MAGIC 0x444D4D43 // "CMMD"
+#define COMMAND_CAPACITY 64      // Must be a power of two
+
+// Command types
+#define COMMAND_SET_STATE 0x01       // id: EM state
+#define COMMAND_SET_PARAMETER 0x02   // id: parameter index, value: new value
+#define COMMAND_START_RECORDING 0x03 // Records drive telemetry to RECORDING_DIRECTORY
+#define COMMAND_STOP_RECORDING 0x04  //
+#define COMMAND_QUIT 0x05            //
+#define COMMAND_SAVE_PARAMETERS 0x06 //
+#define COMMAND_START_TRACE 0x07     //
+#define COMMAND_STOP_TRACE 0x08      // Writes the trace file
+#define COMMAND_START_PROFILE 0x09   //
+#define COMMAND_STOP_PROFILE 0x0A    // Writes the profile file
+
+// Acknowledgement status
+#define COMMAND_OK 0
+#define COMMAND_ERROR_UNKNOWN -1
+#define COMMAND_ERROR_UNSUPPORTED -2
+#define COMMAND_ERROR_INVALID -3
+
+typedef struct
+{
+  uint32_t seq;
+  uint32_t type;
+  uint32_t id;
+  uint32_t reserved;
+  double value;
+  uint64_t timestamp; // CLOCK_MONOTONIC time at which the command was issued
+} command_t;
+
+typedef struct
+{
+  uint32_t seq;
+  int32_t status;
+  uint64_t latency_ns; // From command timestamp to the command taking effect
+} command_ack_t;
+
+/*
+ * Two single-producer/single-consumer rings in shared memory.
+ *
+ * The UI server produces commands: it writes a slot and then advances
+ * command_head. The main thread consumes them and advances command_tail.
+ * Acknowledgements flow the other way through the ack ring, whose head is
+ * advanced by the main thread only. The UI server keeps its own ack cursor,
+ * and never has more than COMMAND_CAPACITY commands in flight, so acks are
+ * never overwritten before they are read.
+ *
+ * Each index lives on its own cache line since they are written by
+ * different processes. The layout is shared with server/command.js.
+ */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t capacity;
+  uint8_t padding_0[56];
+  _Atomic uint32_t command_head;
+  uint8_t padding_1[60];
+  _Atomic uint32_t command_tail;
+  uint8_t padding_2[60];
+  _Atomic uint32_t ack_head;
+  uint8_t padding_3[60];
+  command_t commands[COMMAND_CAPACITY];
+  command_ack_t acks[COMMAND_CAPACITY];
+} command_queue_t;
+
+void command_init(command_queue_t *queue);
+bool command_pop(command_queue_t *queue, command_t *command);
+void command_ack(command_queue_t *queue, const command_t *command, int32_t status, uint64_t latency_ns);
+
+// Producer side, for the native UI server. There must only be one producer,
+// so these are never used together with server/command.js. command_push()
+// refuses a command while COMMAND_CAPACITY are not acknowledged as of
+// ack_cursor, the cursor of command_poll_ack(), as server/command.js does.
+bool command_push(command_queue_t *queue, uint32_t ack_cursor, const command_t *command);
+bool command_poll_ack(command_queue_t *queue, uint32_t *cursor, command_ack_t *ack);
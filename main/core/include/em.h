@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <pthread.h>
@@ -23,10 +24,12 @@ typedef struct
 
 typedef struct
 {
+  const char *name; // Shown in traces
   em_state_t state_mask;
   function_t setup;
   function_t loop;
   function_t teardown;
+  size_t arena_size; // Reserved in the arena at startup
 } em_service_t;
 
 typedef struct
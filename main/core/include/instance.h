@@ -0,0 +1,14 @@
+#pragma once
+
+/*
+ * INSTANCE_LOCAL marks state of one robot that lives outside the EM
+ * contexts: the pointers to the shared tables, and the file-static state of
+ * the services that drive it. On the robot these are ordinary globals. Host
+ * builds that run several simulated robots in one process, one per thread,
+ * define INSTANCE_PER_THREAD so that every thread has its own copy.
+ */
+#ifdef INSTANCE_PER_THREAD
+#define INSTANCE_LOCAL _Thread_local
+#else
+#define INSTANCE_LOCAL
+#endif
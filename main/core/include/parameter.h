@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include <state.h>
+#include <instance.h>
+
+#define PARAMETER_MAGIC 0x41524150 // "PARA"
+
+/*
+ * Live parameter table in shared memory.
+ *
+ * The main thread is the only writer (through COMMAND_SET_PARAMETER) and
+ * protects updates with a sequence lock: the sequence is odd while an update
+ * is in progress. RT services call parameter_sync() at a safe point in their
+ * loop, which copies the whole table atomically into a local parameters_t
+ * only if the sequence has changed, so the common case is a single load.
+ *
+ * The layout is shared with server/parameter.js.
+ */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t count;
+  _Atomic uint32_t sequence;
+  uint32_t reserved;
+  parameters_t values;
+  uint32_t versions[PARAMETER_COUNT];
+} parameter_table_t;
+
+void parameter_init(parameter_table_t *table);
+int32_t parameter_set(uint32_t index, double value);
+bool parameter_sync(parameters_t *local, uint32_t *sequence);
+bool parameter_save(const char *path);
+bool parameter_load(const char *path);
+
+extern INSTANCE_LOCAL parameter_table_t *parameters;
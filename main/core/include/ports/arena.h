@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ARENA_MAX_POOLS 16
+#define ARENA_ALIGNMENT 64
+
+// Allocate count elements of type from the pool of owner
+#define ARENA_ALLOC(owner, type, count) ((type *)arena_alloc((owner), sizeof(type) * (count)))
+
+/*
+ * Startup-time arena for runtime buffers.
+ *
+ * Every owner (usually a service) declares its quota before arena_init(),
+ * which maps one locked and prefaulted region, backed by huge pages when
+ * available, and carves it into one pool per owner. Allocation is a bump
+ * of the pool offset and never touches the heap; arena_reset() releases
+ * everything an owner allocated, e.g. in its teardown.
+ *
+ * When built with ARENA_AUDIT, malloc/calloc/realloc/free called from a
+ * thread marked with arena_mark_rt_thread() after arena_audit_start() are
+ * reported, or abort the program with ARENA_AUDIT=abort.
+ */
+bool arena_declare(const char *owner, size_t quota);
+bool arena_init(bool use_hugepages);
+void *arena_alloc(const char *owner, size_t size);
+void arena_reset(const char *owner);
+
+void arena_mark_rt_thread();
+void arena_audit_start();
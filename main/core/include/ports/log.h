@@ -1,6 +1,13 @@
 #pragma once
 
+// Log calls are deferred once log_start() has been called: the caller only
+// captures the format pointer, a timestamp and the raw arguments, and a
+// background thread formats and writes them. The format must therefore be a
+// string literal (or otherwise outlive the call); %s arguments are copied.
 void print(const char *format, ...);
 void error(const char *format, ...);
 void warning(const char *format, ...);
-void clear();
\ No newline at end of file
+void clear();
+
+void log_start();
+void log_stop();
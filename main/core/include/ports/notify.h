@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdbool.h>
+
+typedef int notify_t;
+
+bool notify_create(notify_t *notify);
+void notify_signal(notify_t notify);
+bool notify_wait(notify_t notify);
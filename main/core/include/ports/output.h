@@ -1,5 +1,82 @@
 #pragma once
 
-int output_create(char *filename);
-void output_write(int fd, char *data);
-void output_close(int fd);
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/*
+ * Asynchronous binary recorder.
+ *
+ * output_write() appends a fixed-size record into a preallocated chunk
+ * buffer and never blocks: a writer thread streams full chunks to disk, and
+ * records are dropped (and counted) when both buffers are waiting for it.
+ * Records must start with a uint64_t timestamp in nanoseconds, which is
+ * used for the time index. output_write() must be called from one thread
+ * only; output_create() and output_close() from another.
+ *
+ * File format, all little endian:
+ *   header  4096 bytes: output_file_header_t, followed by the schema JSON
+ *   chunk   OUTPUT_CHUNK_SIZE bytes: output_chunk_header_t + records
+ *   index   every OUTPUT_INDEX_INTERVAL chunks and at the end:
+ *           output_chunk_header_t + output_index_entry_t[count]
+ */
+
+#define OUTPUT_FILE_MAGIC "RPIREC1"
+#define OUTPUT_FILE_VERSION 1
+#define OUTPUT_HEADER_SIZE 4096
+#define OUTPUT_CHUNK_SIZE (256 * 1024)
+#define OUTPUT_INDEX_INTERVAL 64
+
+#define OUTPUT_CHUNK_MAGIC 0x4B4E4843 // "CHNK"
+#define OUTPUT_CHUNK_DATA 0x01
+#define OUTPUT_CHUNK_INDEX 0x02
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t chunk_size;
+    uint32_t record_size;
+    uint32_t index_interval;
+    uint32_t schema_size;
+    uint64_t start_timestamp_ns;
+    uint64_t record_count;  // Written on close
+    uint64_t dropped_count; // Written on close
+} output_file_header_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t type;
+    uint32_t size;     // Bytes including this header
+    uint32_t count;    // Records or index entries
+    uint32_t sequence; // Data chunk number
+    uint32_t dropped;  // Records dropped since the previous chunk
+    uint64_t first_timestamp_ns;
+    uint64_t last_timestamp_ns;
+    uint8_t reserved[24];
+} output_chunk_header_t;
+
+typedef struct
+{
+    uint64_t offset;
+    uint64_t first_timestamp_ns;
+    uint64_t last_timestamp_ns;
+} output_index_entry_t;
+
+typedef struct
+{
+    uint64_t record_count;
+    uint64_t dropped_count;
+    uint64_t bytes_written;
+    double elapsed_s;
+    double write_s; // Time spent in write()
+} output_stats_t;
+
+int mkdir_recursive(const char *path, mode_t mode);
+
+bool output_create(const char *filename, const char *schema, uint32_t record_size);
+bool output_write(const void *record);
+void output_close(output_stats_t *stats);
+bool output_is_open();
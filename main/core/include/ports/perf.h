@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PERF_COUNTER_CYCLES 0
+#define PERF_COUNTER_INSTRUCTIONS 1
+#define PERF_COUNTER_CACHE_MISSES 2
+#define PERF_COUNTER_BRANCH_MISSES 3
+#define PERF_NUM_COUNTERS 4
+
+/*
+ * Hardware counters of the calling thread, read together as one group.
+ *
+ * Counters the CPU or the kernel does not provide are left out of the group
+ * and read as 0; perf_open() only fails when none of them is available,
+ * e.g. in a VM or with kernel.perf_event_paranoid > 2.
+ */
+typedef struct
+{
+    int32_t group_fd;
+    uint32_t num_open;
+    int32_t fds[PERF_NUM_COUNTERS];   // -1 if unavailable
+    int32_t slots[PERF_NUM_COUNTERS]; // Position in the group, -1 if unavailable
+} perf_counters_t;
+
+typedef struct
+{
+    uint64_t values[PERF_NUM_COUNTERS];
+} perf_sample_t;
+
+extern const char *const perf_counter_names[PERF_NUM_COUNTERS];
+
+bool perf_open(perf_counters_t *counters);
+bool perf_read(const perf_counters_t *counters, perf_sample_t *sample);
+void perf_close(perf_counters_t *counters);
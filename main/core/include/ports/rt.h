@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <pthread.h>
+
+#define RT_STACK_SIZE (1024 * 1024)        // Stack size of the EM threads
+#define RT_STACK_PREFAULT_SIZE (256 * 1024) // Part of the stack touched up front
+#define RT_THREAD_STACK_SIZE (256 * 1024)  // Stack size of the other threads
+
+bool rt_lock_memory();
+// Attributes for every thread of the application besides the EM threads.
+// Stacks are locked in memory like everything else, so the default 8 MiB
+// per thread would be resident.
+const pthread_attr_t *rt_get_thread_attr();
+bool rt_verify_memory();
+// Sets kernel.sched_rt_runtime_us to -1 if allowed, warns if it stays on.
+// rt_restore_throttling() puts back the previous value, it is async signal
+// safe.
+bool rt_disable_throttling();
+bool rt_restore_throttling();
+
+// Apply to the calling thread. cpu < 0 leaves the affinity unchanged,
+// priority 0 keeps SCHED_OTHER.
+bool rt_set_affinity(int32_t cpu);
+bool rt_set_priority(int32_t priority);
+void rt_prefault_stack();
+bool rt_verify_thread(int32_t cpu, int32_t priority);
+
+// Scheduler and memory counters of one thread, cumulative since it started
+typedef struct
+{
+    uint64_t minor_faults;
+    uint64_t major_faults;
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+    uint64_t migrations;
+    uint64_t cpu_time_ns;
+    uint64_t wait_time_ns; // Runnable but not running
+    int32_t cpu;           // Last CPU the thread ran on
+} rt_thread_stats_t;
+
+int32_t rt_get_thread_id();
+
+// Kernel release and command line, e.g. to check isolcpus in reports
+void rt_describe_kernel(char *buffer, size_t size);
+
+// Read from /proc/self/task/<thread_id>, so any thread can sample another
+// one without disturbing it. Counters the kernel does not expose stay 0.
+bool rt_read_thread_stats(int32_t thread_id, rt_thread_stats_t *stats);
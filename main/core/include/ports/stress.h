@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STRESS_MAX_THREADS 8
+
+/*
+ * Background load for jitter measurements, cyclictest style.
+ *
+ * Threads rotate through CPU (integer arithmetic), memory (streaming over a
+ * buffer larger than the caches) and IO (write and fsync a file in the
+ * working directory) load. They run as SCHED_OTHER on every online CPU
+ * except the excluded ones, i.e. the isolated cores under test.
+ */
+bool stress_start(uint32_t num_threads, const int32_t *excluded_cpus, uint32_t num_excluded);
+void stress_stop();
@@ -10,6 +10,9 @@
 bool timer_init();
 void timer_sleep_ns(uint32_t ns);
 uint32_t timer_get_ns();
+uint64_t timer_get_timestamp_ns();     // Monotonic, never wraps. Same clock as Node's process.hrtime
+uint64_t timer_get_uptime_ns();        // Since kernel boot
+uint64_t timer_get_process_start_ns(); // Start of this process, on the timer_get_timestamp_ns() clock
 
 // Loop-related
 
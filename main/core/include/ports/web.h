@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WEB_MAX_CLIENTS 16
+#define WEB_MAX_WATCHED 4
+#define WEB_BROADCAST -1 // Client of web_send() that means every WebSocket
+
+#define WEB_EVENT_TIMEOUT 0
+#define WEB_EVENT_OPEN 1     // client: a WebSocket was opened
+#define WEB_EVENT_MESSAGE 2  // client, data, length, is_binary
+#define WEB_EVENT_READABLE 3 // fd: a watched descriptor can be read
+
+typedef struct
+{
+    uint32_t type;
+    int32_t client;
+    int32_t fd;
+    bool is_binary;
+    const uint8_t *data; // Valid until the next web_poll()
+    size_t length;
+} web_event_t;
+
+/*
+ * Minimal HTTP/1.1 and WebSocket (RFC 6455) server, driven by web_poll()
+ * from a single thread.
+ *
+ * GET requests are served from the root directory. When the client accepts
+ * it, a precompressed <file>.br or <file>.gz is sent instead of the file.
+ * Unknown paths get index.html, as for any single page app. A request with
+ * an Upgrade: websocket header on any path opens a WebSocket.
+ *
+ * Sockets are non-blocking, and a client whose unsent data grows beyond
+ * WEB_OUTPUT_LIMIT is disconnected rather than buffered without bound.
+ */
+bool web_open(uint16_t port, const char *root);
+bool web_watch(int32_t fd);
+bool web_poll(web_event_t *event, int32_t timeout_ms);
+void web_send(int32_t client, bool is_binary, const void *data, size_t length);
+void web_close();
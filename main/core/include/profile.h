@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#include <ports/perf.h>
+
+#define PROFILE_THREAD_COUNT 8  // Threads that can be profiled
+#define PROFILE_MAX_SERVICES 16 // Services per thread
+
+/*
+ * Per-service hardware counter profile of the EM loops.
+ *
+ * While profiling is enabled, every service loop call is bracketed by two
+ * reads of the hardware counters of its thread, and the deltas are summed
+ * per service. Each thread opens its counters the first time it is
+ * profiled and closes them when its EM loop halts. Without counters, only
+ * the calls and the wall time are summed.
+ *
+ * A counter read is a syscall, so the profile inflates the wall time of
+ * short loops; compare counters, not time, against an unprofiled run.
+ */
+typedef struct
+{
+  uint64_t time_ns;
+  perf_sample_t perf;
+} profile_sample_t;
+
+typedef struct
+{
+  const char *name;
+  uint64_t calls;
+  uint64_t time_ns;
+  uint64_t counters[PERF_NUM_COUNTERS];
+} profile_entry_t;
+
+extern atomic_bool profile_enabled;
+
+#define PROFILE_IS_ENABLED() atomic_load_explicit(&profile_enabled, memory_order_relaxed)
+
+void profile_set_thread_name(const char *name);
+void profile_start();
+void profile_stop();
+void profile_begin(profile_sample_t *begin);
+void profile_end(const char *name, const profile_sample_t *begin);
+// Closes the counters of the calling thread, before it exits
+void profile_close_thread();
+bool profile_write(const char *path);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <em.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+extern em_service_t service_health;
+
+// Called by each execution context on its own thread, once it has finished
+// its setup. Isolated threads get a warning when they are preempted more than
+// health_preemption_threshold times a second, migrated or take a page fault,
+// at most once per health_warning_interval_s for each, except major faults.
+void health_register_thread(uint32_t index, const char *name, bool is_isolated);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <em.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JITTER_HISTOGRAM_SIZE 1000 // 1us buckets, the last one collects the rest
+
+/*
+ * Synthetic periodic service of the jitter mode (EM_STATE_JITTER), added to
+ * every execution context. It records the latency from each intended
+ * release time, one period after the previous one, to the loop iteration
+ * that observes it, like cyclictest does for clock_nanosleep wake-ups.
+ */
+extern em_service_t service_jitter;
+
+void jitter_set_thread_name(const char *name);
+
+// Waits until every context has left the jitter mode, then writes the
+// histograms of the last run
+bool jitter_write_report(const char *path, uint32_t stress_threads);
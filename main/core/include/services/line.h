@@ -1,5 +1,8 @@
 #pragma once
 
 #include <em.h>
+#include <stdint.h>
 
-extern em_service_t service_line;
\ No newline at end of file
+extern em_service_t service_line;
+// Acquisition time of the oldest sensor sample in state->position
+uint64_t line_get_timestamp();
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+#include <em.h>
+#include <ports/notify.h>
+
+extern em_service_t service_publish;
+void publish_set_max_rate(uint32_t rate_hz);
+void publish_set_notify(notify_t notify);
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <em.h>
+#include <stdint.h>
 
 extern em_service_t service_sensor;
 extern em_service_t service_sensor_low;
-extern em_service_t service_sensor_high;
\ No newline at end of file
+extern em_service_t service_sensor_high;
+// Time of the last ADC sample of a sensor, on the timer_get_timestamp_ns() clock
+uint64_t sensor_get_timestamp(uint8_t sensor_index);
@@ -2,20 +2,28 @@
 // Do not edit this file manually
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <instance.h>
+
 #define EM_STATE_HALT 0x00
 #define EM_STATE_IDLE 0x01
 #define EM_STATE_CALI_HIGH 0x02
 #define EM_STATE_CALI_LOW 0x04
 #define EM_STATE_DRIVE 0x08
 #define EM_STATE_MUSIC 0x10
+#define EM_STATE_JITTER 0x20
 #define EM_STATE_ALL (~(uint32_t)(0))
 
 typedef struct
 {
-  uint32_t state;
-  uint16_t sensor_low[16];
+  // Written by: main
+  _Alignas(64) uint32_t state;
+  uint32_t generation;
+  uint32_t boot_time_ms;
+  // Written by: control
+  _Alignas(64) uint16_t sensor_low[16];
   uint16_t sensor_high[16];
   uint16_t sensor_raw[16];
   double sensor_data[16];
@@ -23,9 +31,83 @@ typedef struct
   double speed;
   double battery_voltage;
   uint8_t track;
-  int32_t encoder_left;
+  uint32_t input_age_histogram[16];
+  uint32_t input_age_max_us;
+  // Written by: encoder
+  _Alignas(64) int32_t encoder_left;
   int32_t encoder_right;
+  uint32_t encoder_rate;
+  // Written by: health
+  _Alignas(64) uint32_t health_minor_faults[8];
+  uint32_t health_major_faults[8];
+  uint32_t health_voluntary_switches[8];
+  uint32_t health_involuntary_switches[8];
+  uint32_t health_migrations[8];
+  uint32_t health_cpu_time_ms[8];
+  uint8_t health_names[128];
 } state_t;
 
+typedef struct
+{
+  uint64_t timestamp;
+  uint64_t input_timestamp;
+  uint16_t sensor_raw[16];
+  double sensor_data[16];
+  double position;
+  double speed;
+  int32_t encoder_left;
+  int32_t encoder_right;
+  double pid_left_target;
+  double pid_right_target;
+  double pid_left_output;
+  double pid_right_output;
+  double motor_left;
+  double motor_right;
+} telemetry_record_t;
+
+#define PARAMETER_COUNT 11
+#define PARAMETER_DRIVE_SPEED 0
+#define PARAMETER_DRIVE_CURVATURE 1
+#define PARAMETER_DRIVE_ACCELERATION 2
+#define PARAMETER_DRIVE_BRAKE_ACCELERATION 3
+#define PARAMETER_DRIVE_KP 4
+#define PARAMETER_DRIVE_KI 5
+#define PARAMETER_DRIVE_KD 6
+#define PARAMETER_JITTER_PERIOD_US 7
+#define PARAMETER_JITTER_STRESS_THREADS 8
+#define PARAMETER_HEALTH_PREEMPTION_THRESHOLD 9
+#define PARAMETER_HEALTH_WARNING_INTERVAL_S 10
+
+// All parameters are doubles, so they can also be indexed as an array
+typedef struct
+{
+  double drive_speed;
+  double drive_curvature;
+  double drive_acceleration;
+  double drive_brake_acceleration;
+  double drive_kp;
+  double drive_ki;
+  double drive_kd;
+  double jitter_period_us;
+  double jitter_stress_threads;
+  double health_preemption_threshold;
+  double health_warning_interval_s;
+} parameters_t;
+
+typedef struct
+{
+  const char *name;
+  double default_value;
+  double min;
+  double max;
+} parameter_definition_t;
+
+#define STATE_MESSAGE_DELTA 0x01
+#define STATE_DELTA_MAX_SIZE 2673
+
 void state_print_offsets(state_t *state, char *buffer);
-extern state_t *state;
+size_t state_encode_delta(state_t *sent, const state_t *next, uint8_t *buffer);
+extern INSTANCE_LOCAL state_t *state;
+extern const parameter_definition_t parameter_definitions[PARAMETER_COUNT];
+extern const char telemetry_schema[];
+extern const char state_schema[];
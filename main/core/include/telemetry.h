@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include <state.h>
+#include <instance.h>
+
+#define TELEMETRY_MAGIC 0x4D4C4554 // "TELM"
+#define TELEMETRY_CAPACITY 4096    // Must be a power of two
+
+/*
+ * Single-producer/multi-consumer ring of telemetry records.
+ *
+ * The producer writes the record into slot (head % capacity) and then
+ * publishes it by incrementing head with release semantics. It never waits
+ * for readers. Readers keep their own cursor, and a record is valid only if
+ * the producer has not lapped it while it was being copied, which is checked
+ * by reading head again after the copy.
+ *
+ * The layout is shared with server/telemetry.js, so keep the header at
+ * exactly one cache line.
+ */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t record_size;
+  uint32_t capacity;
+  uint32_t reserved;
+  _Atomic uint64_t head;
+  uint8_t padding[40];
+  telemetry_record_t records[TELEMETRY_CAPACITY];
+} telemetry_t;
+
+typedef struct
+{
+  uint64_t cursor;
+  uint64_t overruns;
+} telemetry_reader_t;
+
+void telemetry_init(telemetry_t *telemetry);
+void telemetry_push(const telemetry_record_t *record);
+void telemetry_reader_init(telemetry_reader_t *reader);
+uint32_t telemetry_read(telemetry_reader_t *reader, telemetry_record_t *records, uint32_t max_records);
+
+extern INSTANCE_LOCAL telemetry_t *telemetry;
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <em.h>
+
+#define TOPOLOGY_MAX_CONTEXTS 8
+#define TOPOLOGY_NAME_SIZE 32
+
+#define TOPOLOGY_WAIT_SPIN 0x00  // Busy loop, for isolated cores
+#define TOPOLOGY_WAIT_YIELD 0x01 // sched_yield() between iterations
+#define TOPOLOGY_WAIT_SLEEP 0x02 // Sleep wait_us between iterations
+
+typedef struct
+{
+  char name[TOPOLOGY_NAME_SIZE];
+  int32_t cpu;      // -1: not pinned
+  int32_t priority; // 0: SCHED_OTHER, 1-99: SCHED_FIFO
+  uint32_t wait;
+  uint32_t wait_us;
+  uint32_t num_services;
+  char services[EM_MAX_EXECUTION_CONTEXTS][TOPOLOGY_NAME_SIZE];
+} topology_context_t;
+
+// Which local execution contexts exist, how they are scheduled and which
+// services run in each of them
+typedef struct
+{
+  uint32_t num_contexts;
+  topology_context_t contexts[TOPOLOGY_MAX_CONTEXTS];
+} topology_t;
+
+bool topology_parse(topology_t *topology, const char *text);
+bool topology_load(topology_t *topology, const char *path);
+
+extern const char topology_default[];
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define TRACE_BUFFER_COUNT 8         // Threads that can record events
+#define TRACE_BUFFER_CAPACITY 16384 // Events per thread, must be a power of two
+
+#define TRACE_PHASE_BEGIN 'B'
+#define TRACE_PHASE_END 'E'
+#define TRACE_PHASE_INSTANT 'i'
+
+/*
+ * Flight recorder for the EM timeline.
+ *
+ * Every thread records into its own preallocated ring, which keeps the most
+ * recent TRACE_BUFFER_CAPACITY events. trace_write() exports all rings as a
+ * Chrome trace JSON file, which can be opened in chrome://tracing or
+ * https://ui.perfetto.dev.
+ *
+ * Names are stored as pointers, so they must be string literals. When
+ * tracing is disabled, a trace point costs a single relaxed load and branch.
+ */
+typedef struct
+{
+  uint64_t timestamp_ns;
+  const char *name;
+  uint32_t phase;
+  uint32_t reserved;
+} trace_event_t;
+
+extern atomic_bool trace_enabled;
+
+#define TRACE_IS_ENABLED() atomic_load_explicit(&trace_enabled, memory_order_relaxed)
+
+#define TRACE_EVENT(phase, name)         \
+  do                                     \
+  {                                      \
+    if (TRACE_IS_ENABLED())              \
+    {                                    \
+      trace_record((phase), (name));     \
+    }                                    \
+  } while (0)
+
+#define TRACE_BEGIN(name) TRACE_EVENT(TRACE_PHASE_BEGIN, name)
+#define TRACE_END(name) TRACE_EVENT(TRACE_PHASE_END, name)
+#define TRACE_INSTANT(name) TRACE_EVENT(TRACE_PHASE_INSTANT, name)
+
+void trace_init();
+void trace_set_thread_name(const char *name);
+void trace_start();
+void trace_stop();
+void trace_record(uint32_t phase, const char *name);
+bool trace_write(const char *path);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <command.h>
+#include <ports/notify.h>
+
+#define UI_INPUT_HISTORY 3000 // Log text replayed to new clients
+
+typedef struct
+{
+  uint16_t port;
+  const char *root;   // Static files, i.e. frontend/dist
+  int32_t log_fd;     // Read end of the pipe that stdout and stderr go to
+  int32_t console_fd; // Where the log text goes on to, the original stdout
+  notify_t state_notify;
+  notify_t command_notify;
+  command_queue_t *commands;
+} ui_config_t;
+
+/*
+ * Native UI server, a thread entry point taking a ui_config_t.
+ *
+ * It speaks the same protocol as server/app.js and server/robot.js, so the
+ * frontend works with either: state deltas are encoded straight from the
+ * shared state_t, log text, parameters and acknowledgements are JSON, and
+ * commands from clients go to the command queue like from the Node server.
+ *
+ * If the server cannot start or stops, stdout and stderr are pointed back
+ * at console_fd, so that nothing blocks on the undrained pipe.
+ */
+void *ui_run(void *arg);
@@ -0,0 +1,107 @@
+#include <algorithms/filter.h>
+
+#include <string.h>
+
+#define AT(frame, sensor) ((size_t)(frame) * NUM_SENSORS + (sensor))
+
+void filter_iir(const double *frames, uint32_t count, double gain, double *output)
+{
+  if (count == 0)
+  {
+    return;
+  }
+  for (int j = 0; j < NUM_SENSORS; j++)
+  {
+    output[AT(0, j)] = frames[AT(0, j)];
+  }
+  for (uint32_t i = 1; i < count; i++)
+  {
+    for (int j = 0; j < NUM_SENSORS; j++)
+    {
+      output[AT(i, j)] = gain * frames[AT(i, j)] + (1 - gain) * output[AT(i - 1, j)];
+    }
+  }
+}
+
+// Running sums, so that the cost does not grow with the window
+void filter_mean(const double *frames, uint32_t count, uint32_t window, double *output)
+{
+  double sums[NUM_SENSORS] = {0};
+
+  if (window == 0)
+  {
+    return;
+  }
+  for (uint32_t i = 0; i < count; i++)
+  {
+    uint32_t size = i + 1 < window ? i + 1 : window;
+    for (int j = 0; j < NUM_SENSORS; j++)
+    {
+      sums[j] += frames[AT(i, j)];
+      if (i >= window)
+      {
+        sums[j] -= frames[AT(i - window, j)];
+      }
+      output[AT(i, j)] = sums[j] / size;
+    }
+  }
+}
+
+// First index in sorted[0, size) whose value is not less than value
+static uint32_t filter_lower_bound(const double *sorted, uint32_t size, double value)
+{
+  uint32_t low = 0;
+  uint32_t high = size;
+  while (low < high)
+  {
+    uint32_t middle = (low + high) / 2;
+    if (sorted[middle] < value)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+// Every sensor keeps its window sorted in scratch: every frame removes the
+// value that leaves the window and inserts the one that enters, each a
+// binary search and a move of at most window values. Frames are visited
+// once, in order, as a recording is laid out.
+void filter_median(const double *frames, uint32_t count, uint32_t window, double *scratch, double *output)
+{
+  uint32_t size = 0;
+
+  if (window == 0)
+  {
+    return;
+  }
+  for (uint32_t i = 0; i < count; i++)
+  {
+    for (int j = 0; j < NUM_SENSORS; j++)
+    {
+      double *sorted = &scratch[(size_t)j * window];
+      uint32_t current = size;
+      if (i >= window)
+      {
+        uint32_t index = filter_lower_bound(sorted, current, frames[AT(i - window, j)]);
+        memmove(&sorted[index], &sorted[index + 1], (current - index - 1) * sizeof(double));
+        current--;
+      }
+      double value = frames[AT(i, j)];
+      uint32_t index = filter_lower_bound(sorted, current, value);
+      memmove(&sorted[index + 1], &sorted[index], (current - index) * sizeof(double));
+      sorted[index] = value;
+      current++;
+
+      output[AT(i, j)] = current % 2 == 1 ? sorted[current / 2] : (sorted[current / 2 - 1] + sorted[current / 2]) / 2;
+    }
+    if (size < window)
+    {
+      size++;
+    }
+  }
+}
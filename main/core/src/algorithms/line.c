@@ -0,0 +1,133 @@
+#include <algorithms/line.h>
+
+#include <math.h>
+#include <stddef.h>
+
+#define LINE_MU_RANGE (1.0 / 3) // Distance at which line_mu() reaches 0
+
+#define SENSOR_POSITION(i) ((i) * 2.0 / (NUM_SENSORS - 1) - 1.0)       // -1.0 ~ 1.0
+#define CANDIDATE_POSITION(i) ((i) * 2.0 / (LINE_NUM_CANDIDATES - 1) - 1.0) // -1.0 ~ 1.0
+#define CANDIDATE_INDEX(position) ((int)(((position) + 1.0) * (LINE_NUM_CANDIDATES - 1) / 2.0 + 1.0) - 1) // Floor
+
+void line_config_init(line_config_t *config)
+{
+  config->gate = LINE_DEFAULT_GATE;
+  config->prior_weight = LINE_DEFAULT_PRIOR_WEIGHT;
+}
+
+static double line_mu(double distance)
+{
+  double mu = 1 - 3 * fabs(distance);
+  return (mu + fabs(mu)) / 2; // Clamped at 0 without a branch, so that the evidence loop vectorizes
+}
+
+bool line_weighted_sum(const line_config_t *config, const double *sensor_data, double prev_position, double *position, uint32_t *used)
+{
+  double weighted_sum = 0;
+  double weight_sum = 0;
+  *used = 0;
+
+  for (int i = 0; i < NUM_SENSORS; i++)
+  {
+    double weight = sensor_data[i];
+    if (fabs(SENSOR_POSITION(i) - prev_position) > config->gate)
+    {
+      weight = 0;
+    }
+    weighted_sum += weight * SENSOR_POSITION(i);
+    weight_sum += weight;
+    if (weight > 0)
+    {
+      *used |= 1u << i;
+    }
+  }
+
+  if (weight_sum == 0)
+  {
+    return false;
+  }
+  *position = weighted_sum / weight_sum;
+  return true;
+}
+
+void line_weighted_sum_batch(const line_config_t *config, const double *frames, uint32_t count, double initial_position, double *positions, uint32_t *used)
+{
+  double position = initial_position;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    uint32_t frame_used;
+    line_weighted_sum(config, &frames[(size_t)i * NUM_SENSORS], position, &position, &frame_used);
+    positions[i] = position;
+    if (used != NULL)
+    {
+      used[i] = frame_used;
+    }
+  }
+}
+
+// Sensors further than LINE_MU_RANGE from a candidate predict 0, so they
+// add their own square to every candidate alike: the sum of squares of all
+// sensors is taken once, and every sensor then visits only the candidates
+// in its reach. The likelihoods of the candidates are independent of each
+// other, which keeps the loop free of a dependency chain.
+double line_bayesian(const line_config_t *config, const double *sensor_data, double prev_position)
+{
+  double candidates[LINE_NUM_CANDIDATES];
+  double likelihoods[LINE_NUM_CANDIDATES];
+
+  double evidence_base = 0;
+  for (int j = 0; j < NUM_SENSORS; j++)
+  {
+    evidence_base += sensor_data[j] * sensor_data[j];
+  }
+
+  // Set the prior
+  for (int i = 0; i < LINE_NUM_CANDIDATES; i++)
+  {
+    candidates[i] = CANDIDATE_POSITION(i);
+    double tmp = candidates[i] - prev_position;
+    likelihoods[i] = config->prior_weight * tmp * tmp + evidence_base;
+  }
+
+  // Add evidence
+  for (int j = 0; j < NUM_SENSORS; j++)
+  {
+    double sensor_position = SENSOR_POSITION(j);
+    double value = sensor_data[j];
+    int first = CANDIDATE_INDEX(sensor_position - LINE_MU_RANGE);
+    int last = CANDIDATE_INDEX(sensor_position + LINE_MU_RANGE) + 1;
+    first = first < 0 ? 0 : first;
+    last = last < LINE_NUM_CANDIDATES ? last : LINE_NUM_CANDIDATES - 1;
+    for (int i = first; i <= last; i++)
+    {
+      // tmp is the difference between the predicted value and the actual value.
+      // Therefore, we need to find the place that minimizes this value.
+      double tmp = value - line_mu(candidates[i] - sensor_position);
+      likelihoods[i] += tmp * tmp - value * value;
+    }
+  }
+
+  // Find the best position
+  double optimal_likelihood = 999999999;
+  double optimal_position = 0;
+  for (int i = 0; i < LINE_NUM_CANDIDATES; i++)
+  {
+    if (likelihoods[i] < optimal_likelihood)
+    {
+      optimal_likelihood = likelihoods[i];
+      optimal_position = candidates[i];
+    }
+  }
+
+  return optimal_position;
+}
+
+void line_bayesian_batch(const line_config_t *config, const double *frames, uint32_t count, double initial_position, double *positions)
+{
+  double position = initial_position;
+  for (uint32_t i = 0; i < count; i++)
+  {
+    position = line_bayesian(config, &frames[(size_t)i * NUM_SENSORS], position);
+    positions[i] = position;
+  }
+}
@@ -1,19 +1,18 @@
 #include <algorithms/mark.h>
 
+#include <stddef.h>
+
 #define STATE_NONE 0x00
 #define STATE_ACCUM 0x01
 
-static double mark_threshold = 0.8;
-
-static double sensor_positions[NUM_SENSORS];
+#define SENSOR_POSITION(i) ((i) * 2.0 / (NUM_SENSORS - 1) - 1.0) // -1.0 ~ 1.0
 
+// The threshold and margin can be changed after mark_init(), e.g. by the
+// parameter sweep. Everything else is in mark_t, so marks are reentrant.
 void mark_init(mark_t *mark)
 {
-  for (int i = 0; i < NUM_SENSORS; i++)
-  {
-    sensor_positions[i] = i * 2.0 / (NUM_SENSORS - 1) - 1.0; // -1.0 ~ 1.0
-  }
-
+  mark->threshold = MARK_DEFAULT_THRESHOLD;
+  mark->side_margin = MARK_DEFAULT_SIDE_MARGIN;
   mark->state = STATE_NONE;
   mark->is_left = false;
   mark->is_right = false;
@@ -23,23 +22,23 @@ void mark_init(mark_t *mark)
   }
 }
 
-uint8_t mark_state_machine(mark_t *mark, double *sensor_data, double position)
+uint8_t mark_state_machine(mark_t *mark, const double *sensor_data, double position)
 {
   bool current_left = false;
   bool current_right = false;
 
   for (int i = 0; i < NUM_SENSORS; i++)
   {
-    bool b = sensor_data[i] > mark_threshold;
+    bool b = sensor_data[i] > mark->threshold;
     if (b)
     {
       mark->accum[i] = true;
-      if (sensor_positions[i] < position - 0.25)
+      if (SENSOR_POSITION(i) < position - mark->side_margin)
       {
         current_left = true;
         mark->is_left = true;
       }
-      else if (sensor_positions[i] > position + 0.25)
+      else if (SENSOR_POSITION(i) > position + mark->side_margin)
       {
         current_right = true;
         mark->is_right = true;
@@ -98,3 +97,11 @@ uint8_t mark_state_machine(mark_t *mark, double *sensor_data, double position)
 
   return MARK_NONE;
 }
+
+void mark_batch(mark_t *mark, const double *frames, const double *positions, uint32_t count, uint8_t *marks)
+{
+  for (uint32_t i = 0; i < count; i++)
+  {
+    marks[i] = mark_state_machine(mark, &frames[(size_t)i * NUM_SENSORS], positions[i]);
+  }
+}
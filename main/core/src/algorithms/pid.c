@@ -17,4 +17,13 @@ double pid_update(pid_control_t *pid, double current, double dt)
   double derivative = (error - pid->error_prev) / dt;
   pid->error_prev = error;
   return pid->kP * error + pid->kI * pid->error_accum + pid->kD * derivative;
-}
\ No newline at end of file
+}
+
+void pid_batch(pid_control_t *pid, const double *targets, const double *currents, const double *dts, uint32_t count, double *outputs)
+{
+  for (uint32_t i = 0; i < count; i++)
+  {
+    pid->target = targets[i];
+    outputs[i] = pid_update(pid, currents[i], dts[i]);
+  }
+}
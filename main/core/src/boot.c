@@ -0,0 +1,112 @@
+#include <boot.h>
+
+#include <stdio.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include <state.h>
+#include <ports/log.h>
+
+#define BOOT_HISTORY_FILE "boot-history.csv"
+
+typedef struct
+{
+  const char *name;
+  uint64_t begin_ns;
+  uint64_t end_ns;
+} boot_step_t;
+
+static boot_step_t steps[BOOT_MAX_STEPS];
+static _Atomic uint32_t num_steps;
+static _Atomic uint32_t num_ready;
+static _Atomic uint64_t last_ready_ns;
+static uint64_t process_start_ns;
+static uint64_t main_start_ns;
+
+void boot_init()
+{
+  main_start_ns = timer_get_timestamp_ns();
+  process_start_ns = timer_get_process_start_ns();
+  atomic_store(&num_steps, 0);
+  atomic_store(&num_ready, 0);
+  atomic_store(&last_ready_ns, 0);
+}
+
+void boot_record(const char *name, uint64_t begin_ns, uint64_t end_ns)
+{
+  uint32_t index = atomic_fetch_add(&num_steps, 1);
+  if (index >= BOOT_MAX_STEPS)
+  {
+    return;
+  }
+  steps[index] = (boot_step_t){name, begin_ns, end_ns};
+}
+
+void boot_report()
+{
+  uint64_t ready_ns = atomic_load(&last_ready_ns);
+
+  uint32_t count = atomic_load(&num_steps);
+  if (count > BOOT_MAX_STEPS)
+  {
+    count = BOOT_MAX_STEPS;
+  }
+
+  // Print in start order, steps from other threads are interleaved
+  print("Boot timeline (ms since process start):");
+  print("  %8.1f  %8s  %s", (main_start_ns - process_start_ns) / 1e6, "", "main");
+  bool is_printed[BOOT_MAX_STEPS] = {false};
+  for (uint32_t i = 0; i < count; i++)
+  {
+    uint32_t first = count;
+    for (uint32_t j = 0; j < count; j++)
+    {
+      if (!is_printed[j] && (first == count || steps[j].begin_ns < steps[first].begin_ns))
+      {
+        first = j;
+      }
+    }
+    is_printed[first] = true;
+    print("  %8.1f  %6.1fms  %s", (steps[first].begin_ns - process_start_ns) / 1e6,
+          (steps[first].end_ns - steps[first].begin_ns) / 1e6, steps[first].name);
+  }
+
+  double boot_time_ms = (ready_ns - process_start_ns) / 1e6;
+  double uptime_ms = (timer_get_uptime_ns() - (timer_get_timestamp_ns() - ready_ns)) / 1e6;
+  print("Time to first loop: %.1f ms (%.1f ms since kernel boot)", boot_time_ms, uptime_ms);
+  state->boot_time_ms = (uint32_t)boot_time_ms;
+
+  // Keep a history across power cycles
+  FILE *file = fopen(BOOT_HISTORY_FILE, "a");
+  if (file != NULL)
+  {
+    fprintf(file, "%lld,%.1f,%.1f\n", (long long)time(NULL), boot_time_ms, uptime_ms);
+    fclose(file);
+  }
+}
+
+void boot_context_ready(const char *name, uint64_t begin_ns)
+{
+  uint64_t ready_ns = timer_get_timestamp_ns();
+  boot_record(name, begin_ns, ready_ns);
+
+  // The boot is complete when the last context has finished its setup
+  uint64_t last = atomic_load(&last_ready_ns);
+  while (last < ready_ns && !atomic_compare_exchange_weak(&last_ready_ns, &last, ready_ns))
+    ;
+  atomic_fetch_add(&num_ready, 1);
+}
+
+bool boot_wait_ready(uint32_t num_contexts, uint32_t timeout_ms)
+{
+  for (uint32_t i = 0; i < timeout_ms; i++)
+  {
+    if (atomic_load(&num_ready) >= num_contexts)
+    {
+      return true;
+    }
+    struct timespec interval = {0, 1000000};
+    nanosleep(&interval, NULL);
+  }
+  return false;
+}
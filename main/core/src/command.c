@@ -0,0 +1,75 @@
+#include <command.h>
+
+#include <stddef.h>
+
+_Static_assert(sizeof(command_t) == 32, "command_t size mismatch");
+_Static_assert(sizeof(command_ack_t) == 16, "command_ack_t size mismatch");
+_Static_assert(offsetof(command_queue_t, command_head) == 64, "command_queue_t.command_head offset mismatch");
+_Static_assert(offsetof(command_queue_t, command_tail) == 128, "command_queue_t.command_tail offset mismatch");
+_Static_assert(offsetof(command_queue_t, ack_head) == 192, "command_queue_t.ack_head offset mismatch");
+_Static_assert(offsetof(command_queue_t, commands) == 256, "command_queue_t.commands offset mismatch");
+
+#define SLOT(index) ((index) & (COMMAND_CAPACITY - 1))
+
+void command_init(command_queue_t *queue)
+{
+  queue->magic = COMMAND_MAGIC;
+  queue->capacity = COMMAND_CAPACITY;
+  atomic_store_explicit(&queue->command_head, 0, memory_order_relaxed);
+  atomic_store_explicit(&queue->command_tail, 0, memory_order_relaxed);
+  atomic_store_explicit(&queue->ack_head, 0, memory_order_release);
+}
+
+bool command_pop(command_queue_t *queue, command_t *command)
+{
+  uint32_t tail = atomic_load_explicit(&queue->command_tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&queue->command_head, memory_order_acquire);
+  if (tail == head)
+  {
+    return false;
+  }
+
+  *command = queue->commands[SLOT(tail)];
+  atomic_store_explicit(&queue->command_tail, tail + 1, memory_order_release);
+  return true;
+}
+
+void command_ack(command_queue_t *queue, const command_t *command, int32_t status, uint64_t latency_ns)
+{
+  uint32_t head = atomic_load_explicit(&queue->ack_head, memory_order_relaxed);
+  queue->acks[SLOT(head)] = (command_ack_t){
+      .seq = command->seq,
+      .status = status,
+      .latency_ns = latency_ns,
+  };
+  atomic_store_explicit(&queue->ack_head, head + 1, memory_order_release);
+}
+
+// Commands are acknowledged after they are consumed, so bounding the ones
+// not acknowledged yet also keeps the command ring from overflowing
+bool command_push(command_queue_t *queue, uint32_t ack_cursor, const command_t *command)
+{
+  uint32_t head = atomic_load_explicit(&queue->command_head, memory_order_relaxed);
+  if (head - ack_cursor >= COMMAND_CAPACITY)
+  {
+    return false;
+  }
+
+  // Write the slot before publishing it by advancing the head
+  queue->commands[SLOT(head)] = *command;
+  atomic_store_explicit(&queue->command_head, head + 1, memory_order_release);
+  return true;
+}
+
+bool command_poll_ack(command_queue_t *queue, uint32_t *cursor, command_ack_t *ack)
+{
+  uint32_t head = atomic_load_explicit(&queue->ack_head, memory_order_acquire);
+  if (*cursor == head)
+  {
+    return false;
+  }
+
+  *ack = queue->acks[SLOT(*cursor)];
+  (*cursor)++;
+  return true;
+}
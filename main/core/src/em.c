@@ -1,5 +1,7 @@
 #include <em.h>
 #include <state.h>
+#include <trace.h>
+#include <profile.h>
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -50,7 +52,12 @@ void em_add_service(em_local_context_t *local_context, em_service_t *service)
   {
     return;
   }
-  local_context->services[local_context->num_services++] = *service;
+  local_context->services[local_context->num_services] = *service;
+  if (service->name == NULL)
+  {
+    local_context->services[local_context->num_services].name = "service";
+  }
+  local_context->num_services++;
 }
 
 #define PHASE_SETUP 0x01
@@ -84,6 +91,43 @@ static inline bool em_counter_down(em_context_t *context)
 
 #define CHECK_STATE(service, state) ((service)->state_mask & (state))
 
+static void em_call_instrumented(em_service_t *service, function_t function)
+{
+  // Only loop calls are profiled, setup and teardown would skew the averages
+  bool is_tracing = TRACE_IS_ENABLED();
+  bool is_profiling = PROFILE_IS_ENABLED() && function == service->loop;
+  profile_sample_t begin;
+
+  if (is_tracing)
+  {
+    trace_record(TRACE_PHASE_BEGIN, service->name);
+  }
+  if (is_profiling)
+  {
+    profile_begin(&begin);
+  }
+  function();
+  if (is_profiling)
+  {
+    profile_end(service->name, &begin);
+  }
+  if (is_tracing)
+  {
+    trace_record(TRACE_PHASE_END, service->name);
+  }
+}
+
+// Run a service function, instrumented if tracing or profiling is enabled
+static inline void em_call(em_service_t *service, function_t function)
+{
+  if (TRACE_IS_ENABLED() || PROFILE_IS_ENABLED())
+  {
+    em_call_instrumented(service, function);
+    return;
+  }
+  function();
+}
+
 bool em_update(em_local_context_t *local_context)
 {
   uint8_t phase = em_get_phase(local_context);
@@ -91,6 +135,7 @@ bool em_update(em_local_context_t *local_context)
   {
   case PHASE_SETUP:
   {
+    TRACE_BEGIN("em_setup");
     for (uint32_t i = 0; i < local_context->num_services; i++)
     {
       em_service_t *service = &local_context->services[i];
@@ -98,9 +143,10 @@ bool em_update(em_local_context_t *local_context)
       // Setup if the service is not in the previous state and in the current state
       if (!CHECK_STATE(service, local_context->prev_state) && CHECK_STATE(service, local_context->curr_state) && service->setup != NULL)
       {
-        service->setup();
+        em_call(service, service->setup);
       }
     }
+    TRACE_END("em_setup");
     local_context->prev_state = local_context->curr_state; // Move to loop state
     em_counter_up(local_context->context);
   }
@@ -113,7 +159,7 @@ bool em_update(em_local_context_t *local_context)
       // Loop if the service is in the current state
       if (CHECK_STATE(service, local_context->curr_state) && service->loop != NULL)
       {
-        service->loop();
+        em_call(service, service->loop);
       }
     }
   }
@@ -121,15 +167,17 @@ bool em_update(em_local_context_t *local_context)
   case PHASE_TEARDOWN:
   {
     em_context_t *context = local_context->context;
+    TRACE_BEGIN("em_teardown");
     for (uint32_t i = 0; i < local_context->num_services; i++)
     {
       em_service_t *service = &local_context->services[i];
       // Teardown if the service is in the global previous state and not in the global current state
       if (CHECK_STATE(service, context->prev_state) && !CHECK_STATE(service, context->curr_state) && service->teardown != NULL)
       {
-        service->teardown();
+        em_call(service, service->teardown);
       }
     }
+    TRACE_END("em_teardown");
     local_context->curr_state = context->curr_state; // Move to intermission state
     if (em_counter_down(context))
     {
@@ -139,6 +187,7 @@ bool em_update(em_local_context_t *local_context)
     // Break loop if the global context is HALT
     if (context->curr_state == EM_STATE_HALT)
     {
+      profile_close_thread();
       return false;
     }
   }
@@ -150,7 +199,7 @@ bool em_update(em_local_context_t *local_context)
       em_service_t *service = &local_context->services[i];
       if (CHECK_STATE(service, local_context->curr_state) && CHECK_STATE(service, local_context->prev_state) && service->loop != NULL)
       {
-        service->loop();
+        em_call(service, service->loop);
       }
     }
   }
@@ -161,5 +210,6 @@ bool em_update(em_local_context_t *local_context)
 
 void em_set_state(em_context_t *context, em_state_t state)
 {
+  TRACE_INSTANT("em_set_state");
   context->curr_state = state;
 }
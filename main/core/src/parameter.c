@@ -0,0 +1,154 @@
+#include <parameter.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+
+#include <command.h>
+#include <ports/log.h>
+
+_Static_assert(offsetof(parameter_table_t, values) == 16, "parameter_table_t.values offset mismatch");
+
+static double *parameter_values(parameters_t *values)
+{
+  return (double *)values;
+}
+
+void parameter_init(parameter_table_t *table)
+{
+  table->magic = PARAMETER_MAGIC;
+  table->count = PARAMETER_COUNT;
+  table->reserved = 0;
+  for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+  {
+    parameter_values(&table->values)[i] = parameter_definitions[i].default_value;
+    table->versions[i] = 0;
+  }
+  atomic_store_explicit(&table->sequence, 0, memory_order_release);
+}
+
+int32_t parameter_set(uint32_t index, double value)
+{
+  if (index >= PARAMETER_COUNT)
+  {
+    return COMMAND_ERROR_INVALID;
+  }
+
+  const parameter_definition_t *definition = &parameter_definitions[index];
+  if (!(value >= definition->min && value <= definition->max))
+  {
+    print("Warning: Parameter %s=%f is out of range [%f, %f]", definition->name, value, definition->min, definition->max);
+    return COMMAND_ERROR_INVALID;
+  }
+
+  // Single writer, so the sequence can be bumped without a CAS
+  uint32_t sequence = atomic_load_explicit(&parameters->sequence, memory_order_relaxed);
+  atomic_store_explicit(&parameters->sequence, sequence + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  parameter_values(&parameters->values)[index] = value;
+  parameters->versions[index]++;
+
+  atomic_store_explicit(&parameters->sequence, sequence + 2, memory_order_release);
+
+  print("Parameter %s=%f", definition->name, value);
+  return COMMAND_OK;
+}
+
+bool parameter_sync(parameters_t *local, uint32_t *sequence)
+{
+  uint32_t before = atomic_load_explicit(&parameters->sequence, memory_order_acquire);
+  if (before == *sequence)
+  {
+    return false;
+  }
+
+  // Retry until a copy is taken without a concurrent update
+  while (true)
+  {
+    if ((before & 1) == 0)
+    {
+      memcpy(local, &parameters->values, sizeof(parameters_t));
+      atomic_thread_fence(memory_order_acquire);
+      uint32_t after = atomic_load_explicit(&parameters->sequence, memory_order_relaxed);
+      if (after == before)
+      {
+        break;
+      }
+    }
+    before = atomic_load_explicit(&parameters->sequence, memory_order_acquire);
+  }
+
+  *sequence = before;
+  return true;
+}
+
+bool parameter_save(const char *path)
+{
+  FILE *file = fopen(path, "w");
+  if (file == NULL)
+  {
+    error("Failed to open parameter file. Parameters not saved.");
+    return false;
+  }
+
+  // Parameters are saved by name, so that the file survives changes of the
+  // parameter definition.
+  parameters_t values;
+  uint32_t sequence = ~atomic_load_explicit(&parameters->sequence, memory_order_relaxed);
+  parameter_sync(&values, &sequence);
+  for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+  {
+    fprintf(file, "%s=%.17g\n", parameter_definitions[i].name, parameter_values(&values)[i]);
+  }
+  fclose(file);
+
+  print("Parameters saved to %s", path);
+  return true;
+}
+
+bool parameter_load(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+  {
+    warning("Failed to open parameter file. Using defaults.");
+    return false;
+  }
+
+  char line[256];
+  while (fgets(line, sizeof(line), file) != NULL)
+  {
+    char *separator = strchr(line, '=');
+    if (separator == NULL)
+    {
+      continue;
+    }
+    *separator = '\0';
+
+    double value;
+    if (sscanf(separator + 1, "%lf", &value) != 1)
+    {
+      continue;
+    }
+
+    bool is_known = false;
+    for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+    {
+      if (strcmp(line, parameter_definitions[i].name) == 0)
+      {
+        parameter_set(i, value);
+        is_known = true;
+        break;
+      }
+    }
+    if (!is_known)
+    {
+      print("Warning: Unknown parameter %s ignored", line);
+    }
+  }
+  fclose(file);
+
+  print("Parameters loaded from %s", path);
+  return true;
+}
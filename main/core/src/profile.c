@@ -0,0 +1,223 @@
+#include <profile.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <ports/log.h>
+#include <ports/timer.h>
+
+// Written by the owning thread only
+typedef struct
+{
+  const char *thread_name;
+  uint32_t session;
+  bool is_opened;
+  bool has_counters;
+  perf_counters_t counters;
+  uint32_t num_entries;
+  profile_entry_t entries[PROFILE_MAX_SERVICES];
+} profile_thread_t;
+
+atomic_bool profile_enabled;
+
+static profile_thread_t threads[PROFILE_THREAD_COUNT];
+static _Atomic uint32_t threads_claimed;
+static _Atomic uint32_t session;
+static _Thread_local profile_thread_t *thread;
+static _Thread_local bool is_thread_exhausted;
+
+static profile_thread_t *profile_get_thread()
+{
+  if (thread != NULL || is_thread_exhausted)
+  {
+    return thread;
+  }
+
+  uint32_t index = atomic_fetch_add_explicit(&threads_claimed, 1, memory_order_acq_rel);
+  if (index >= PROFILE_THREAD_COUNT)
+  {
+    is_thread_exhausted = true;
+    return NULL;
+  }
+  thread = &threads[index];
+  return thread;
+}
+
+void profile_set_thread_name(const char *name)
+{
+  profile_thread_t *t = profile_get_thread();
+  if (t != NULL)
+  {
+    t->thread_name = name;
+  }
+}
+
+void profile_start()
+{
+  if (PROFILE_IS_ENABLED())
+  {
+    return;
+  }
+
+  // Every thread drops its entries of the previous session on its next call
+  atomic_fetch_add_explicit(&session, 1, memory_order_relaxed);
+  atomic_store_explicit(&profile_enabled, true, memory_order_release);
+  print("Profile started");
+}
+
+void profile_stop()
+{
+  atomic_store_explicit(&profile_enabled, false, memory_order_release);
+  print("Profile stopped");
+}
+
+void profile_begin(profile_sample_t *begin)
+{
+  profile_thread_t *t = profile_get_thread();
+  if (t == NULL)
+  {
+    return;
+  }
+
+  if (!t->is_opened)
+  {
+    t->is_opened = true;
+    t->has_counters = perf_open(&t->counters);
+  }
+
+  uint32_t current_session = atomic_load_explicit(&session, memory_order_relaxed);
+  if (t->session != current_session)
+  {
+    t->session = current_session;
+    t->num_entries = 0;
+  }
+
+  if (!t->has_counters || !perf_read(&t->counters, &begin->perf))
+  {
+    memset(&begin->perf, 0, sizeof(perf_sample_t));
+  }
+  begin->time_ns = timer_get_timestamp_ns();
+}
+
+void profile_close_thread()
+{
+  profile_thread_t *t = thread;
+  if (t == NULL || !t->has_counters)
+  {
+    return;
+  }
+
+  // is_opened stays set, so that the counters are not opened again
+  perf_close(&t->counters);
+  t->has_counters = false;
+}
+
+void profile_end(const char *name, const profile_sample_t *begin)
+{
+  uint64_t end_ns = timer_get_timestamp_ns();
+  profile_thread_t *t = thread;
+  if (t == NULL)
+  {
+    return;
+  }
+
+  perf_sample_t end = {0};
+  if (t->has_counters)
+  {
+    perf_read(&t->counters, &end);
+  }
+
+  // Names are literals, so compare the pointers
+  profile_entry_t *entry = NULL;
+  for (uint32_t i = 0; i < t->num_entries; i++)
+  {
+    if (t->entries[i].name == name)
+    {
+      entry = &t->entries[i];
+      break;
+    }
+  }
+  if (entry == NULL)
+  {
+    if (t->num_entries >= PROFILE_MAX_SERVICES)
+    {
+      return;
+    }
+    entry = &t->entries[t->num_entries];
+    memset(entry, 0, sizeof(profile_entry_t));
+    entry->name = name;
+    t->num_entries++;
+  }
+
+  entry->calls++;
+  entry->time_ns += end_ns - begin->time_ns;
+  for (uint32_t i = 0; i < PERF_NUM_COUNTERS; i++)
+  {
+    entry->counters[i] += end.values[i] - begin->perf.values[i];
+  }
+}
+
+bool profile_write(const char *path)
+{
+  FILE *file = fopen(path, "w");
+  if (file == NULL)
+  {
+    error("Failed to open profile file %s", path);
+    return false;
+  }
+
+  fprintf(file, "thread,service,calls,time_ns");
+  for (uint32_t i = 0; i < PERF_NUM_COUNTERS; i++)
+  {
+    fprintf(file, ",%s", perf_counter_names[i]);
+  }
+  fprintf(file, "\n");
+
+  // Threads may still finish the call in flight, which is acceptable here
+  uint32_t num_threads = atomic_load_explicit(&threads_claimed, memory_order_acquire);
+  if (num_threads > PROFILE_THREAD_COUNT)
+  {
+    num_threads = PROFILE_THREAD_COUNT;
+  }
+  uint32_t current_session = atomic_load_explicit(&session, memory_order_relaxed);
+  for (uint32_t i = 0; i < num_threads; i++)
+  {
+    profile_thread_t *t = &threads[i];
+    if (t->session != current_session)
+    {
+      continue;
+    }
+
+    for (uint32_t j = 0; j < t->num_entries; j++)
+    {
+      profile_entry_t *entry = &t->entries[j];
+      const char *thread_name = t->thread_name != NULL ? t->thread_name : "unknown";
+      fprintf(file, "%s,%s,%llu,%llu", thread_name, entry->name, (unsigned long long)entry->calls, (unsigned long long)entry->time_ns);
+
+      // Counters that could not be opened are left empty
+      for (uint32_t k = 0; k < PERF_NUM_COUNTERS; k++)
+      {
+        if (t->has_counters && t->counters.slots[k] >= 0)
+        {
+          fprintf(file, ",%llu", (unsigned long long)entry->counters[k]);
+        }
+        else
+        {
+          fprintf(file, ",");
+        }
+      }
+      fprintf(file, "\n");
+
+      double calls = entry->calls > 0 ? (double)entry->calls : 1;
+      double cycles = (double)entry->counters[PERF_COUNTER_CYCLES];
+      print("Profile %s/%s: %llu calls, %.0f ns, IPC %.2f, %.1f cache and %.1f branch misses per call",
+            thread_name, entry->name, (unsigned long long)entry->calls, entry->time_ns / calls,
+            cycles > 0 ? entry->counters[PERF_COUNTER_INSTRUCTIONS] / cycles : 0.0,
+            entry->counters[PERF_COUNTER_CACHE_MISSES] / calls, entry->counters[PERF_COUNTER_BRANCH_MISSES] / calls);
+    }
+  }
+
+  fclose(file);
+  print("Profile written to %s", path);
+  return true;
+}
@@ -40,6 +40,7 @@ uint32_t clock_get_s()
 }
 
 em_service_t service_clock = {
+    .name = "clock",
     .state_mask = EM_STATE_ALL,
     .setup = clock_setup,
     .loop = clock_loop,
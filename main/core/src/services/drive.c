@@ -5,11 +5,17 @@
 #include <sys/stat.h>
 
 #include <state.h>
+#include <instance.h>
+#include <telemetry.h>
+#include <parameter.h>
+#include <trace.h>
 
 #include <ports/motor.h>
 #include <ports/log.h>
 #include <ports/timer.h>
+#include <ports/output.h>
 
+#include <services/line.h>
 #include <services/encoder.h>
 #include <services/sensor.h>
 #include <services/vsense.h>
@@ -21,38 +27,87 @@
 #define TRACK_LEFT 0x01
 #define TRACK_RIGHT 0x02
 
-static double default_speed;
-static double default_curvature;
-static double acceleration;
-static int end_count;
+#define INPUT_AGE_BUCKETS 16
 
-int32_t encoer_left_prev;
-int32_t encoder_right_prev;
-pid_control_t pid_left;
-pid_control_t pid_right;
-loop_t loop_motor;
-mark_t mark;
+_Static_assert(sizeof(((state_t *)0)->input_age_histogram) / sizeof(uint32_t) == INPUT_AGE_BUCKETS,
+               "input_age_histogram in state-definition.json must have INPUT_AGE_BUCKETS entries");
+
+static INSTANCE_LOCAL parameters_t params;
+static INSTANCE_LOCAL uint32_t params_sequence;
+static INSTANCE_LOCAL double default_speed;
+static INSTANCE_LOCAL double acceleration;
+static INSTANCE_LOCAL int end_count;
+
+INSTANCE_LOCAL int32_t encoer_left_prev;
+INSTANCE_LOCAL int32_t encoder_right_prev;
+INSTANCE_LOCAL pid_control_t pid_left;
+INSTANCE_LOCAL pid_control_t pid_right;
+INSTANCE_LOCAL loop_t loop_motor;
+INSTANCE_LOCAL mark_t mark;
+
+static void drive_apply_parameters()
+{
+    // Stay stopped once the end of the track has been reached
+    if (end_count < 2)
+    {
+        default_speed = params.drive_speed;
+        acceleration = params.drive_acceleration;
+    }
+    else
+    {
+        acceleration = params.drive_brake_acceleration;
+    }
+
+    pid_left.kP = params.drive_kp;
+    pid_right.kP = params.drive_kp;
+
+    pid_left.kI = params.drive_ki;
+    pid_right.kI = params.drive_ki;
+
+    pid_left.kD = params.drive_kd;
+    pid_right.kD = params.drive_kd;
+}
+
+static void drive_record_input_age(uint64_t age_ns)
+{
+    // Bucket 0 is below 1us, bucket i covers [2^(i-1), 2^i) us
+    uint64_t age_us = age_ns / 1000;
+    uint32_t bucket = 0;
+    for (uint64_t v = age_us; v > 0 && bucket < INPUT_AGE_BUCKETS - 1; v >>= 1)
+    {
+        bucket++;
+    }
+    state->input_age_histogram[bucket]++;
+
+    if (age_us > state->input_age_max_us)
+    {
+        state->input_age_max_us = (uint32_t)age_us;
+    }
+}
 
 void drive_setup()
 {
-    default_speed = 15;
-    default_curvature = 1.5;
-    acceleration = 20;
     end_count = 0;
 
     pid_init(&pid_left);
     pid_init(&pid_right);
 
-    pid_left.kP = 3.0;
-    pid_right.kP = 3.0;
-
-    pid_left.kI = 100.0;
-    pid_right.kI = 100.0;
+    // Force a full copy of the parameter table
+    params_sequence = ~atomic_load_explicit(&parameters->sequence, memory_order_relaxed);
+    parameter_sync(&params, &params_sequence);
+    drive_apply_parameters();
 
     // Initialize encoder values
     encoer_left_prev = state->encoder_left;
     encoder_right_prev = state->encoder_right;
 
+    // Every drive run starts a new input age histogram
+    for (int i = 0; i < INPUT_AGE_BUCKETS; i++)
+    {
+        state->input_age_histogram[i] = 0;
+    }
+    state->input_age_max_us = 0;
+
     // Initialize state
     state->position = 0.0;
     state->speed = 0.0;
@@ -71,23 +126,27 @@ void drive_loop()
     switch (current_mark)
     {
     case MARK_LEFT:
+        TRACE_INSTANT("MARK_LEFT");
         print("MARK_LEFT");
         break;
     case MARK_RIGHT:
+        TRACE_INSTANT("MARK_RIGHT");
         print("MARK_RIGHT");
         break;
     case MARK_BOTH:
+        TRACE_INSTANT("MARK_BOTH");
         print("MARK_BOTH");
         end_count++;
 
         if (end_count == 2)
         {
             default_speed = 0;
-            acceleration = 40;
+            acceleration = params.drive_brake_acceleration;
         }
 
         break;
     case MARK_CROSS:
+        TRACE_INSTANT("MARK_CROSS");
         print("MARK_CROSS");
         break;
     }
@@ -97,12 +156,23 @@ void drive_loop()
     if (!loop_update(&loop_motor, &dt_ns))
         return;
 
+    TRACE_BEGIN("drive_control");
+
+    // Pick up parameter changes at the start of a control step only
+    if (parameter_sync(&params, &params_sequence))
+    {
+        drive_apply_parameters();
+    }
+
+    // The oldest sensor sample behind the position used in this step
+    uint64_t input_timestamp = line_get_timestamp();
+
     // Get dt (loop may not run at constant rate)
     double dt = dt_ns / 1e9;
 
     // Update PID targets based on position
-    pid_left.target = -state->speed * (1.0 + state->position * default_curvature);
-    pid_right.target = state->speed * (1.0 - state->position * default_curvature);
+    pid_left.target = -state->speed * (1.0 + state->position * params.drive_curvature);
+    pid_right.target = state->speed * (1.0 - state->position * params.drive_curvature);
 
     // Update speed
     if (state->speed < default_speed)
@@ -139,6 +209,34 @@ void drive_loop()
     double motor_right_output = pid_right_output / state->battery_voltage;
 
     motor_set_velocity(motor_left_output, motor_right_output);
+    if (input_timestamp != 0)
+    {
+        drive_record_input_age(timer_get_timestamp_ns() - input_timestamp);
+    }
+
+    // Record the control step for high-rate telemetry
+    telemetry_record_t record;
+    record.timestamp = timer_get_timestamp_ns();
+    record.input_timestamp = input_timestamp;
+    for (int i = 0; i < 16; i++)
+    {
+        record.sensor_raw[i] = state->sensor_raw[i];
+        record.sensor_data[i] = state->sensor_data[i];
+    }
+    record.position = state->position;
+    record.speed = state->speed;
+    record.encoder_left = encoer_left_prev;
+    record.encoder_right = encoder_right_prev;
+    record.pid_left_target = pid_left.target;
+    record.pid_right_target = pid_right.target;
+    record.pid_left_output = pid_left_output;
+    record.pid_right_output = pid_right_output;
+    record.motor_left = motor_left_output;
+    record.motor_right = motor_right_output;
+    telemetry_push(&record);
+    output_write(&record);
+
+    TRACE_END("drive_control");
 }
 
 void drive_teardown()
@@ -149,6 +247,7 @@ void drive_teardown()
 }
 
 em_service_t service_drive = {
+    .name = "drive",
     .state_mask = EM_STATE_DRIVE,
     .setup = drive_setup,
     .loop = drive_loop,
@@ -3,6 +3,7 @@
 #include <stdint.h>
 
 #include <state.h>
+#include <instance.h>
 #include <ports/dev.h>
 #include <ports/timer.h>
 
@@ -11,10 +12,12 @@
 #define ENCODER_R_A 21
 #define ENCODER_R_B 22
 
-static loop_t loop_encoder;
+static INSTANCE_LOCAL loop_t loop_encoder;
+static INSTANCE_LOCAL uint32_t rate_count;
+static INSTANCE_LOCAL uint32_t rate_elapsed_ns;
 
-static uint8_t prev_l = 0;
-static uint8_t prev_r = 0;
+static INSTANCE_LOCAL uint8_t prev_l;
+static INSTANCE_LOCAL uint8_t prev_r;
 
 static const int diff_dict[16] = {
     0,  // 00 -> 00 (stay)
@@ -41,6 +44,11 @@ static inline int rotary_encoder_update(uint8_t last, uint8_t cur)
     return diff_dict[diff];
 }
 
+static uint8_t encoder_read_phase(uint8_t pin_a, uint8_t pin_b)
+{
+    return (dev_gpio_get_pin(pin_a) << 1) | dev_gpio_get_pin(pin_b);
+}
+
 static void encoder_setup()
 {
     dev_gpio_set_mode(ENCODER_L_A, GPIO_FSEL_IN);
@@ -48,8 +56,17 @@ static void encoder_setup()
     dev_gpio_set_mode(ENCODER_R_A, GPIO_FSEL_IN);
     dev_gpio_set_mode(ENCODER_R_B, GPIO_FSEL_IN);
 
+    // Count from the phase the wheels are in now, not the one an earlier
+    // run left behind
+    prev_l = encoder_read_phase(ENCODER_L_A, ENCODER_L_B);
+    prev_r = encoder_read_phase(ENCODER_R_A, ENCODER_R_B);
+
     state->encoder_left = 0;
     state->encoder_right = 0;
+    state->encoder_rate = 0;
+
+    rate_count = 0;
+    rate_elapsed_ns = 0;
 
     loop_init(&loop_encoder, 1000); // 1us = 1MHz
 }
@@ -59,13 +76,8 @@ static void encoder_loop()
     uint32_t dt_ns;
     if (loop_update(&loop_encoder, &dt_ns))
     {
-        bool la = dev_gpio_get_pin(ENCODER_L_A);
-        bool lb = dev_gpio_get_pin(ENCODER_L_B);
-        bool ra = dev_gpio_get_pin(ENCODER_R_A);
-        bool rb = dev_gpio_get_pin(ENCODER_R_B);
-
-        uint8_t cur_l = (la << 1) | lb;
-        uint8_t cur_r = (ra << 1) | rb;
+        uint8_t cur_l = encoder_read_phase(ENCODER_L_A, ENCODER_L_B);
+        uint8_t cur_r = encoder_read_phase(ENCODER_R_A, ENCODER_R_B);
 
         int diff_l = rotary_encoder_update(prev_l, cur_l);
         int diff_r = rotary_encoder_update(prev_r, cur_r);
@@ -75,10 +87,22 @@ static void encoder_loop()
 
         state->encoder_left += diff_l;
         state->encoder_right += diff_r;
+
+        // Publish the achieved sample rate once per second. This reuses dt_ns
+        // so that measuring the throughput does not cost an extra timer read.
+        rate_count++;
+        rate_elapsed_ns += dt_ns;
+        if (rate_elapsed_ns >= 1000000000)
+        {
+            state->encoder_rate = rate_count;
+            rate_count = 0;
+            rate_elapsed_ns = 0;
+        }
     }
 }
 
 em_service_t service_encoder = {
+    .name = "encoder",
     .state_mask = EM_STATE_ALL,
     .setup = encoder_setup,
     .loop = encoder_loop,
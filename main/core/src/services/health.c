@@ -0,0 +1,184 @@
+#include <services/health.h>
+
+#include <string.h>
+#include <stdatomic.h>
+
+#include <state.h>
+#include <topology.h>
+#include <parameter.h>
+
+#include <ports/rt.h>
+#include <ports/log.h>
+#include <ports/timer.h>
+
+#define HEALTH_INTERVAL_NS 1000000000
+#define HEALTH_MAX_THREADS TOPOLOGY_MAX_CONTEXTS
+#define HEALTH_NAME_SIZE 16 // Bytes of health_names per context
+
+// What a thread is warned about, each spaced out on its own
+#define HEALTH_WARNING_PREEMPTION 0
+#define HEALTH_WARNING_FAULT 1
+#define HEALTH_WARNING_MIGRATION 2
+#define HEALTH_NUM_WARNINGS 3
+
+_Static_assert(sizeof(((state_t *)0)->health_cpu_time_ms) / sizeof(uint32_t) == HEALTH_MAX_THREADS,
+               "health fields in state-definition.json must have one entry per context");
+_Static_assert(sizeof(((state_t *)0)->health_names) == HEALTH_MAX_THREADS * HEALTH_NAME_SIZE,
+               "health_names in state-definition.json must have HEALTH_NAME_SIZE bytes per context");
+
+typedef struct
+{
+    atomic_int thread_id; // 0 until registered
+    const char *name;
+    bool is_isolated;
+    bool has_sample;
+    rt_thread_stats_t previous;
+    rt_thread_stats_t warned; // Counters at the last warning of each kind, or the first sample
+    uint64_t warned_ns[HEALTH_NUM_WARNINGS];
+    bool has_warned[HEALTH_NUM_WARNINGS];
+} health_thread_t;
+
+static health_thread_t threads[HEALTH_MAX_THREADS];
+static loop_t loop_health;
+static parameters_t params;
+static uint32_t params_sequence;
+
+void health_register_thread(uint32_t index, const char *name, bool is_isolated)
+{
+    if (index >= HEALTH_MAX_THREADS)
+    {
+        return;
+    }
+    threads[index].name = name;
+    threads[index].is_isolated = is_isolated;
+    atomic_store_explicit(&threads[index].thread_id, rt_get_thread_id(), memory_order_release);
+}
+
+// Seconds since the last warning of the kind, or since the first sample.
+// Marks the warning as given if it is due, which it always is when
+// is_forced.
+static bool health_warn(health_thread_t *thread, uint32_t kind, uint64_t now_ns, bool is_forced, unsigned long *seconds)
+{
+    uint64_t interval_ns = (uint64_t)(params.health_warning_interval_s * 1e9);
+    if (!is_forced && thread->has_warned[kind] && now_ns - thread->warned_ns[kind] < interval_ns)
+    {
+        return false;
+    }
+    *seconds = (unsigned long)((now_ns - thread->warned_ns[kind]) / 1000000000);
+    thread->warned_ns[kind] = now_ns;
+    thread->has_warned[kind] = true;
+    return true;
+}
+
+// The kernel preempts even a thread on an isolated core now and then, e.g.
+// for a timer or an RCU callback, so preemption is only reported above
+// health_preemption_threshold switches a second (0 for any). Faults and
+// migrations should not happen at all once a thread runs. Each kind of
+// warning is spaced out by health_warning_interval_s (0 for none) and
+// reports the counts since its previous one, except that a major fault is
+// always reported at once.
+static void health_check(health_thread_t *thread, const rt_thread_stats_t *stats, uint64_t now_ns)
+{
+    const rt_thread_stats_t *previous = &thread->previous;
+    rt_thread_stats_t *warned = &thread->warned;
+    unsigned long seconds;
+
+    uint64_t preemptions = stats->involuntary_switches - previous->involuntary_switches;
+    if (preemptions > params.health_preemption_threshold &&
+        health_warn(thread, HEALTH_WARNING_PREEMPTION, now_ns, false, &seconds))
+    {
+        unsigned long involuntary = (unsigned long)(stats->involuntary_switches - warned->involuntary_switches);
+        warning("Context %s was preempted %lu times in %lu s", thread->name, involuntary, seconds);
+        warned->involuntary_switches = stats->involuntary_switches;
+    }
+
+    bool is_major = stats->major_faults != previous->major_faults;
+    if ((is_major || stats->minor_faults != previous->minor_faults) &&
+        health_warn(thread, HEALTH_WARNING_FAULT, now_ns, is_major, &seconds))
+    {
+        unsigned long minor = (unsigned long)(stats->minor_faults - warned->minor_faults);
+        unsigned long major = (unsigned long)(stats->major_faults - warned->major_faults);
+        warning("Context %s took %lu minor and %lu major page faults in %lu s", thread->name, minor, major, seconds);
+        warned->minor_faults = stats->minor_faults;
+        warned->major_faults = stats->major_faults;
+    }
+
+    if (stats->migrations != previous->migrations &&
+        health_warn(thread, HEALTH_WARNING_MIGRATION, now_ns, false, &seconds))
+    {
+        unsigned long migrations = (unsigned long)(stats->migrations - warned->migrations);
+        warning("Context %s migrated %lu times in %lu s, now on CPU %d", thread->name, migrations, seconds, stats->cpu);
+        warned->migrations = stats->migrations;
+    }
+}
+
+static void health_setup()
+{
+    loop_init(&loop_health, HEALTH_INTERVAL_NS);
+
+    // Force a full copy of the parameter table
+    params_sequence = ~atomic_load_explicit(&parameters->sequence, memory_order_relaxed);
+    parameter_sync(&params, &params_sequence);
+}
+
+static void health_loop()
+{
+    uint32_t dt_ns;
+    if (!loop_update(&loop_health, &dt_ns))
+    {
+        return;
+    }
+    uint64_t now_ns = timer_get_timestamp_ns();
+    parameter_sync(&params, &params_sequence);
+
+    for (uint32_t i = 0; i < HEALTH_MAX_THREADS; i++)
+    {
+        health_thread_t *thread = &threads[i];
+        int32_t thread_id = atomic_load_explicit(&thread->thread_id, memory_order_acquire);
+        if (thread_id == 0)
+        {
+            continue;
+        }
+
+        rt_thread_stats_t stats;
+        if (!rt_read_thread_stats(thread_id, &stats))
+        {
+            continue;
+        }
+
+        state->health_minor_faults[i] = (uint32_t)stats.minor_faults;
+        state->health_major_faults[i] = (uint32_t)stats.major_faults;
+        state->health_voluntary_switches[i] = (uint32_t)stats.voluntary_switches;
+        state->health_involuntary_switches[i] = (uint32_t)stats.involuntary_switches;
+        state->health_migrations[i] = (uint32_t)stats.migrations;
+        state->health_cpu_time_ms[i] = (uint32_t)(stats.cpu_time_ns / 1000000);
+
+        if (!thread->has_sample)
+        {
+            // Name the slot for the dashboard, truncated to fit
+            char *name = (char *)&state->health_names[i * HEALTH_NAME_SIZE];
+            strncpy(name, thread->name, HEALTH_NAME_SIZE - 1);
+            name[HEALTH_NAME_SIZE - 1] = '\0';
+
+            thread->warned = stats;
+            for (uint32_t kind = 0; kind < HEALTH_NUM_WARNINGS; kind++)
+            {
+                thread->warned_ns[kind] = now_ns;
+            }
+        }
+        else if (thread->is_isolated)
+        {
+            health_check(thread, &stats, now_ns);
+        }
+        thread->previous = stats;
+        thread->has_sample = true;
+    }
+}
+
+em_service_t service_health = {
+    .name = "health",
+    .state_mask = EM_STATE_ALL,
+    .setup = health_setup,
+    .loop = health_loop,
+    .teardown = NULL,
+};
@@ -0,0 +1,245 @@
+#include <services/jitter.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include <state.h>
+#include <parameter.h>
+#include <topology.h>
+
+#include <ports/rt.h>
+#include <ports/log.h>
+#include <ports/timer.h>
+
+#define JITTER_MAX_CONTEXTS TOPOLOGY_MAX_CONTEXTS
+#define JITTER_REPORT_TIMEOUT_MS 1000
+
+// Written by the owning thread only, read by the report once it is stopped
+typedef struct
+{
+    const char *name;
+    atomic_bool is_running;
+    uint64_t period_ns;
+    uint64_t next_release_ns;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+    uint64_t samples;
+    uint64_t missed;
+    uint64_t sum_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint32_t histogram[JITTER_HISTOGRAM_SIZE];
+} jitter_slot_t;
+
+static jitter_slot_t slots[JITTER_MAX_CONTEXTS];
+static _Atomic uint32_t slots_claimed;
+static _Thread_local jitter_slot_t *slot;
+
+static jitter_slot_t *jitter_get_slot()
+{
+    if (slot != NULL)
+    {
+        return slot;
+    }
+
+    uint32_t index = atomic_fetch_add_explicit(&slots_claimed, 1, memory_order_acq_rel);
+    if (index >= JITTER_MAX_CONTEXTS)
+    {
+        return NULL;
+    }
+    slot = &slots[index];
+    return slot;
+}
+
+void jitter_set_thread_name(const char *name)
+{
+    jitter_slot_t *s = jitter_get_slot();
+    if (s != NULL)
+    {
+        s->name = name;
+    }
+}
+
+static void jitter_setup()
+{
+    jitter_slot_t *s = jitter_get_slot();
+    if (s == NULL)
+    {
+        return;
+    }
+
+    // Force a full copy of the parameter table
+    parameters_t params;
+    uint32_t sequence = ~atomic_load_explicit(&parameters->sequence, memory_order_relaxed);
+    parameter_sync(&params, &sequence);
+
+    memset(s->histogram, 0, sizeof(s->histogram));
+    s->samples = 0;
+    s->missed = 0;
+    s->sum_ns = 0;
+    s->min_ns = UINT64_MAX;
+    s->max_ns = 0;
+    s->period_ns = (uint64_t)(params.jitter_period_us * 1000);
+    s->begin_ns = timer_get_timestamp_ns();
+    s->next_release_ns = s->begin_ns + s->period_ns;
+    atomic_store_explicit(&s->is_running, true, memory_order_release);
+}
+
+static void jitter_loop()
+{
+    jitter_slot_t *s = slot;
+    if (s == NULL)
+    {
+        return;
+    }
+
+    uint64_t now_ns = timer_get_timestamp_ns();
+    if (now_ns < s->next_release_ns)
+    {
+        return;
+    }
+
+    uint64_t latency_ns = now_ns - s->next_release_ns;
+    uint64_t bucket = latency_ns / 1000;
+    s->histogram[bucket < JITTER_HISTOGRAM_SIZE ? bucket : JITTER_HISTOGRAM_SIZE - 1]++;
+    s->samples++;
+    s->sum_ns += latency_ns;
+    if (latency_ns < s->min_ns)
+    {
+        s->min_ns = latency_ns;
+    }
+    if (latency_ns > s->max_ns)
+    {
+        s->max_ns = latency_ns;
+    }
+
+    // Releases that passed entirely are missed, not queued up
+    uint64_t missed = latency_ns / s->period_ns;
+    s->missed += missed;
+    s->next_release_ns += (missed + 1) * s->period_ns;
+}
+
+static void jitter_teardown()
+{
+    jitter_slot_t *s = slot;
+    if (s == NULL)
+    {
+        return;
+    }
+    s->end_ns = timer_get_timestamp_ns();
+    atomic_store_explicit(&s->is_running, false, memory_order_release);
+}
+
+// Smallest latency bucket that covers the fraction of samples, in us
+static uint32_t jitter_percentile(const jitter_slot_t *s, double fraction)
+{
+    uint64_t target = (uint64_t)(s->samples * fraction);
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < JITTER_HISTOGRAM_SIZE; i++)
+    {
+        count += s->histogram[i];
+        if (count > target)
+        {
+            return i;
+        }
+    }
+    return JITTER_HISTOGRAM_SIZE - 1;
+}
+
+bool jitter_write_report(const char *path, uint32_t stress_threads)
+{
+    uint32_t num_slots = atomic_load_explicit(&slots_claimed, memory_order_acquire);
+    if (num_slots > JITTER_MAX_CONTEXTS)
+    {
+        num_slots = JITTER_MAX_CONTEXTS;
+    }
+
+    // The contexts tear down on their next update
+    for (uint32_t elapsed_ms = 0; elapsed_ms < JITTER_REPORT_TIMEOUT_MS; elapsed_ms++)
+    {
+        bool is_running = false;
+        for (uint32_t i = 0; i < num_slots; i++)
+        {
+            is_running |= atomic_load_explicit(&slots[i].is_running, memory_order_acquire);
+        }
+        if (!is_running)
+        {
+            break;
+        }
+        timer_sleep_ns(1000000);
+    }
+
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+    {
+        error("Failed to open jitter report %s", path);
+        return false;
+    }
+
+    char kernel[640];
+    rt_describe_kernel(kernel, sizeof(kernel));
+    fprintf(file, "# Kernel: %s\n", kernel);
+    fprintf(file, "# Stress threads: %u\n", stress_threads);
+    fprintf(file, "# Latency from intended to actual release, in us\n");
+    fprintf(file, "# context period duration_s samples missed min avg p50 p99 p99.9 max\n");
+
+    for (uint32_t i = 0; i < num_slots; i++)
+    {
+        jitter_slot_t *s = &slots[i];
+        if (s->samples == 0)
+        {
+            continue;
+        }
+
+        const char *name = s->name != NULL ? s->name : "unknown";
+        double duration_s = (s->end_ns - s->begin_ns) / 1e9;
+        double avg_us = s->sum_ns / 1e3 / s->samples;
+        uint32_t p50 = jitter_percentile(s, 0.5);
+        uint32_t p99 = jitter_percentile(s, 0.99);
+        uint32_t p999 = jitter_percentile(s, 0.999);
+        fprintf(file, "%s %llu %.1f %llu %llu %.1f %.1f %u %u %u %.1f\n", name,
+                (unsigned long long)(s->period_ns / 1000), duration_s, (unsigned long long)s->samples,
+                (unsigned long long)s->missed, s->min_ns / 1e3, avg_us, p50, p99, p999, s->max_ns / 1e3);
+        print("Jitter %s: avg %.1f us, p99 %u us, max %.1f us, %lu missed", name, avg_us, p99,
+              s->max_ns / 1e3, (unsigned long)s->missed);
+    }
+
+    // Histogram, one column per context, only the buckets that were hit
+    fprintf(file, "\n# bucket_us");
+    for (uint32_t i = 0; i < num_slots; i++)
+    {
+        fprintf(file, " %s", slots[i].name != NULL ? slots[i].name : "unknown");
+    }
+    fprintf(file, "\n");
+    for (uint32_t bucket = 0; bucket < JITTER_HISTOGRAM_SIZE; bucket++)
+    {
+        bool is_hit = false;
+        for (uint32_t i = 0; i < num_slots; i++)
+        {
+            is_hit |= slots[i].histogram[bucket] > 0;
+        }
+        if (!is_hit)
+        {
+            continue;
+        }
+        fprintf(file, "%u", bucket);
+        for (uint32_t i = 0; i < num_slots; i++)
+        {
+            fprintf(file, " %u", slots[i].histogram[bucket]);
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    print("Jitter report written to %s", path);
+    return true;
+}
+
+em_service_t service_jitter = {
+    .name = "jitter",
+    .state_mask = EM_STATE_JITTER,
+    .setup = jitter_setup,
+    .loop = jitter_loop,
+    .teardown = jitter_teardown,
+};
@@ -1,99 +1,69 @@
 #include <services/line.h>
 
 #include <state.h>
+#include <instance.h>
 
-#define ABS(x) ((x) < 0 ? -(x) : (x))
+#include <algorithms/line.h>
+#include <services/sensor.h>
 
-#define NUM_SENSORS 16
-#define NUM_POS_CANDIDATES 1000
-
-static double sensor_positions[NUM_SENSORS];
-static double candidate_positions[NUM_POS_CANDIDATES];
-
-static double line_mu(double distance)
-{
-  double mu = 1 - 3 * ABS(distance);
-  if (mu < 0)
-  {
-    mu = 0;
-  }
-  return mu;
-}
+static INSTANCE_LOCAL line_config_t config;
+static INSTANCE_LOCAL uint64_t position_timestamp;
 
 static void line_setup()
 {
-  for (int i = 0; i < NUM_POS_CANDIDATES; i++)
-  {
-    candidate_positions[i] = i * 2.0 / (NUM_POS_CANDIDATES - 1) - 1.0;
-  }
-  for (int i = 0; i < NUM_SENSORS; i++)
-  {
-    sensor_positions[i] = i * 2.0 / (NUM_SENSORS - 1) - 1.0;
-  }
+  line_config_init(&config);
+  position_timestamp = 0;
 }
 
 static void line_loop_weighted_sum()
 {
-  double weighted_sum = 0;
-  double weight_sum = 0;
-  double prev_position = state->position;
+  double position;
+  uint32_t used;
 
-  for (int i = 0; i < NUM_SENSORS; i++)
+  // Keep the previous position, and so its timestamp
+  if (!line_weighted_sum(&config, state->sensor_data, state->position, &position, &used))
   {
-    double weight = state->sensor_data[i];
-    if (ABS(sensor_positions[i] - prev_position) > 0.3)
-    {
-      weight = 0;
-    }
-    weighted_sum += weight * sensor_positions[i];
-    weight_sum += weight;
+    return;
   }
+  state->position = position;
 
-  if (weight_sum == 0)
+  // Only the sensors that contribute age the position
+  uint64_t oldest_timestamp = UINT64_MAX;
+  for (int i = 0; i < NUM_SENSORS; i++)
   {
-    state->position = prev_position;
-    return;
+    uint64_t timestamp = sensor_get_timestamp(i);
+    if ((used & (1u << i)) && timestamp < oldest_timestamp)
+    {
+      oldest_timestamp = timestamp;
+    }
   }
-
-  state->position = weighted_sum / weight_sum;
+  position_timestamp = oldest_timestamp;
 }
 
 static void line_loop_bayesian()
 {
-  double optimal_likelihood = 999999999;
-  double optimal_position = 0;
-  double prev_position = state->position;
+  state->position = line_bayesian(&config, state->sensor_data, state->position);
 
-  for (int i = 0; i < NUM_POS_CANDIDATES; i++)
+  // Every sensor is evidence
+  uint64_t oldest_timestamp = UINT64_MAX;
+  for (int i = 0; i < NUM_SENSORS; i++)
   {
-    double candidate_position = candidate_positions[i];
-    double likelihood = 0;
-
-    // Set the prior
-    double tmp = candidate_position - prev_position;
-    likelihood += 4 * tmp * tmp;
-
-    // Add evidence
-    for (int j = 0; j < NUM_SENSORS; j++)
+    uint64_t timestamp = sensor_get_timestamp(i);
+    if (timestamp < oldest_timestamp)
     {
-      double tmp = state->sensor_data[j] - line_mu(candidate_position - sensor_positions[j]);
-      // tmp is the difference between the predicted value and the actual value.
-      // Therefore, we need to find the place that minimizes this value.
-      likelihood += tmp * tmp;
-    }
-
-    // Check if this is the best position
-    if (likelihood < optimal_likelihood)
-    {
-      optimal_likelihood = likelihood;
-      optimal_position = candidate_position;
+      oldest_timestamp = timestamp;
     }
   }
+  position_timestamp = oldest_timestamp;
+}
 
-  state->position = optimal_position;
+uint64_t line_get_timestamp()
+{
+  return position_timestamp;
 }
 
 em_service_t service_line = {
+    .name = "line",
     .state_mask = EM_STATE_ALL,
     .setup = line_setup,
     .loop = line_loop_weighted_sum,
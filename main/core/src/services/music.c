@@ -5,14 +5,16 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <fcntl.h>
-#include <stdlib.h>
 #include <unistd.h>
 
 #include <ports/dev.h>
+#include <ports/arena.h>
 #include <ports/log.h>
 #include <ports/motor.h>
 #include <ports/timer.h>
 
+#define MUSIC_MAX_SIZE (4 * 1024 * 1024) // About 95s at 44.1kHz
+
 float volume_gain = 0.98f;
 float irr_gain = 0.5f;
 float epsilon = 0.001;
@@ -28,6 +30,7 @@ static void music_setup()
     // Initialze filter
     filtered = 0;
     i = 0;
+    file_size = 0;
 
     // Open music file
     const char *music_file_path = "../assets/drip.raw";
@@ -42,8 +45,21 @@ static void music_setup()
     file_size = lseek(fd, 0, SEEK_END);
     lseek(fd, 0, SEEK_SET);
 
-    // Allocate memory for music data
-    music_data = (uint8_t *)malloc(file_size);
+    // Take the music data from the arena, setup runs on an RT thread
+    if (file_size > MUSIC_MAX_SIZE)
+    {
+        print("Music file is too large");
+        file_size = 0;
+        close(fd);
+        return;
+    }
+    music_data = ARENA_ALLOC("music", uint8_t, file_size);
+    if (music_data == NULL)
+    {
+        file_size = 0;
+        close(fd);
+        return;
+    }
 
     // Read music data
     if (read(fd, music_data, file_size) != file_size)
@@ -100,17 +116,16 @@ static void music_teardown()
     motor_set_velocity(0, 0);
     motor_enable(false);
 
-    // Free music data
-    if (music_data != NULL)
-    {
-        free(music_data);
-        music_data = NULL;
-    }
+    // Release music data
+    arena_reset("music");
+    music_data = NULL;
 }
 
 em_service_t service_music = {
+    .name = "music",
     .state_mask = EM_STATE_MUSIC,
     .setup = music_setup,
     .loop = music_play,
     .teardown = music_teardown,
+    .arena_size = MUSIC_MAX_SIZE,
 };
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include <services/publish.h>
+
+#include <string.h>
+
+#include <state.h>
+
+#include <ports/notify.h>
+#include <ports/timer.h>
+
+#define PUBLISH_DEFAULT_RATE_HZ 200
+
+static state_t snapshot;
+static loop_t loop_publish;
+static uint32_t publish_interval_ns = 1000000000 / PUBLISH_DEFAULT_RATE_HZ;
+static bool is_first_frame;
+static notify_t publish_notify = -1;
+
+void publish_set_max_rate(uint32_t rate_hz)
+{
+    if (rate_hz == 0)
+    {
+        return;
+    }
+    publish_interval_ns = 1000000000 / rate_hz;
+}
+
+void publish_set_notify(notify_t notify)
+{
+    publish_notify = notify;
+}
+
+static void publish_setup()
+{
+    is_first_frame = true;
+    loop_init(&loop_publish, publish_interval_ns);
+}
+
+static void publish_loop()
+{
+    // Rate limit the notifications so that the UI server never wakes up
+    // more often than the configured maximum.
+    uint32_t dt_ns;
+    if (!is_first_frame && !loop_update(&loop_publish, &dt_ns))
+    {
+        return;
+    }
+
+    // Only publish a frame if something has changed since the last one.
+    // Fields may be torn by the RT threads, which is acceptable for the UI.
+    if (!is_first_frame && memcmp(&snapshot, state, sizeof(state_t)) == 0)
+    {
+        return;
+    }
+    is_first_frame = false;
+
+    state->generation++;
+    memcpy(&snapshot, state, sizeof(state_t));
+    notify_signal(publish_notify);
+}
+
+em_service_t service_publish = {
+    .name = "publish",
+    .state_mask = EM_STATE_ALL,
+    .setup = publish_setup,
+    .loop = publish_loop,
+    .teardown = NULL,
+};
@@ -5,6 +5,8 @@
 #include <string.h>
 
 #include <state.h>
+#include <instance.h>
+#include <trace.h>
 
 #include <ports/dev.h>
 #include <ports/log.h>
@@ -19,7 +21,9 @@
 #define IR_S00 26
 #define IR_SEN 27
 
-static int spi_fd;
+static INSTANCE_LOCAL int spi_fd;
+static INSTANCE_LOCAL uint64_t sample_timestamps[NUM_SENSORS];
+static INSTANCE_LOCAL uint8_t sensor_index;
 
 typedef struct
 {
@@ -176,8 +180,12 @@ static uint16_t sensor_read_raw(uint8_t sensor_index)
     dev_gpio_set_pin(IR_SEN);
 
     // Read sensor data
+    TRACE_BEGIN("sensor_spi");
     dev_spi_transfer(tx, rx, sizeof(tx));
+    // The ADC samples at the start of the transfer that returns the data
+    sample_timestamps[sensor_index] = timer_get_timestamp_ns();
     dev_spi_transfer(tx, rx, sizeof(tx));
+    TRACE_END("sensor_spi");
 
     // Turn off IR LED
     dev_gpio_clear_pin(IR_SEN);
@@ -191,8 +199,6 @@ static uint16_t sensor_read_raw(uint8_t sensor_index)
 
 static void sensor_read_one()
 {
-    static uint8_t sensor_index = 0;
-
     // Read raw sensor data
     uint16_t data = sensor_read_raw(sensor_index);
     state->sensor_raw[sensor_index] = data;
@@ -231,6 +237,10 @@ static void sensor_setup()
     dev_gpio_set_mode(IR_S00, GPIO_FSEL_OUT);
     dev_gpio_set_mode(IR_SEN, GPIO_FSEL_OUT);
 
+    // Start the scan over, so that nothing depends on an earlier run
+    sensor_index = 0;
+    memset(sample_timestamps, 0, sizeof(sample_timestamps));
+
     sensor_load_calibration();
 }
 
@@ -284,7 +294,13 @@ static void sensor_teardown()
     sensor_save_calibration();
 }
 
+uint64_t sensor_get_timestamp(uint8_t sensor_index)
+{
+    return sample_timestamps[sensor_index];
+}
+
 em_service_t service_sensor = {
+    .name = "sensor",
     .state_mask = EM_STATE_ALL,
     .setup = sensor_setup,
     .loop = sensor_loop,
@@ -292,6 +308,7 @@ em_service_t service_sensor = {
 };
 
 em_service_t service_sensor_low = {
+    .name = "sensor_low",
     .state_mask = EM_STATE_CALI_LOW,
     .setup = sensor_setup_low,
     .loop = sensor_loop_low,
@@ -299,6 +316,7 @@ em_service_t service_sensor_low = {
 };
 
 em_service_t service_sensor_high = {
+    .name = "sensor_high",
     .state_mask = EM_STATE_CALI_HIGH,
     .setup = sensor_setup_high,
     .loop = sensor_loop_high,
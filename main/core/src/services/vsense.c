@@ -1,6 +1,7 @@
 #include <services/vsense.h>
 
 #include <state.h>
+#include <instance.h>
 
 #include <ports/dev.h>
 #include <ports/timer.h>
@@ -17,7 +18,7 @@ static float vsense_read()
     return adc * 0.01926f; // Experimentally determined constant
 }
 
-loop_t loop_vsense;
+INSTANCE_LOCAL loop_t loop_vsense;
 
 static void vsense_setup()
 {
@@ -38,6 +39,7 @@ static void vsense_loop()
 }
 
 em_service_t service_vsense = {
+    .name = "vsense",
     .state_mask = EM_STATE_ALL,
     .setup = vsense_setup,
     .loop = vsense_loop,
@@ -3,21 +3,384 @@
 #include "state.h"
 #include <stdio.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+_Static_assert(offsetof(state_t, state) == 0, "state_t.state offset mismatch");
+_Static_assert(offsetof(state_t, generation) == 4, "state_t.generation offset mismatch");
+_Static_assert(offsetof(state_t, boot_time_ms) == 8, "state_t.boot_time_ms offset mismatch");
+_Static_assert(offsetof(state_t, sensor_low) == 64, "state_t.sensor_low offset mismatch");
+_Static_assert(offsetof(state_t, sensor_high) == 96, "state_t.sensor_high offset mismatch");
+_Static_assert(offsetof(state_t, sensor_raw) == 128, "state_t.sensor_raw offset mismatch");
+_Static_assert(offsetof(state_t, sensor_data) == 160, "state_t.sensor_data offset mismatch");
+_Static_assert(offsetof(state_t, position) == 288, "state_t.position offset mismatch");
+_Static_assert(offsetof(state_t, speed) == 296, "state_t.speed offset mismatch");
+_Static_assert(offsetof(state_t, battery_voltage) == 304, "state_t.battery_voltage offset mismatch");
+_Static_assert(offsetof(state_t, track) == 312, "state_t.track offset mismatch");
+_Static_assert(offsetof(state_t, input_age_histogram) == 316, "state_t.input_age_histogram offset mismatch");
+_Static_assert(offsetof(state_t, input_age_max_us) == 380, "state_t.input_age_max_us offset mismatch");
+_Static_assert(offsetof(state_t, encoder_left) == 384, "state_t.encoder_left offset mismatch");
+_Static_assert(offsetof(state_t, encoder_right) == 388, "state_t.encoder_right offset mismatch");
+_Static_assert(offsetof(state_t, encoder_rate) == 392, "state_t.encoder_rate offset mismatch");
+_Static_assert(offsetof(state_t, health_minor_faults) == 448, "state_t.health_minor_faults offset mismatch");
+_Static_assert(offsetof(state_t, health_major_faults) == 480, "state_t.health_major_faults offset mismatch");
+_Static_assert(offsetof(state_t, health_voluntary_switches) == 512, "state_t.health_voluntary_switches offset mismatch");
+_Static_assert(offsetof(state_t, health_involuntary_switches) == 544, "state_t.health_involuntary_switches offset mismatch");
+_Static_assert(offsetof(state_t, health_migrations) == 576, "state_t.health_migrations offset mismatch");
+_Static_assert(offsetof(state_t, health_cpu_time_ms) == 608, "state_t.health_cpu_time_ms offset mismatch");
+_Static_assert(offsetof(state_t, health_names) == 640, "state_t.health_names offset mismatch");
+_Static_assert(sizeof(state_t) == 768, "state_t size mismatch");
+_Static_assert(offsetof(telemetry_record_t, timestamp) == 0, "telemetry_record_t.timestamp offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, input_timestamp) == 8, "telemetry_record_t.input_timestamp offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, sensor_raw) == 16, "telemetry_record_t.sensor_raw offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, sensor_data) == 48, "telemetry_record_t.sensor_data offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, position) == 176, "telemetry_record_t.position offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, speed) == 184, "telemetry_record_t.speed offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, encoder_left) == 192, "telemetry_record_t.encoder_left offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, encoder_right) == 196, "telemetry_record_t.encoder_right offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, pid_left_target) == 200, "telemetry_record_t.pid_left_target offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, pid_right_target) == 208, "telemetry_record_t.pid_right_target offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, pid_left_output) == 216, "telemetry_record_t.pid_left_output offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, pid_right_output) == 224, "telemetry_record_t.pid_right_output offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, motor_left) == 232, "telemetry_record_t.motor_left offset mismatch");
+_Static_assert(offsetof(telemetry_record_t, motor_right) == 240, "telemetry_record_t.motor_right offset mismatch");
+_Static_assert(sizeof(telemetry_record_t) == 248, "telemetry_record_t size mismatch");
+
+_Static_assert(sizeof(parameters_t) == PARAMETER_COUNT * sizeof(double), "parameters_t must be an array of doubles");
+
+const parameter_definition_t parameter_definitions[PARAMETER_COUNT] = {
+    {"drive_speed", 15.0, 0.0, 40.0},
+    {"drive_curvature", 1.5, 0.0, 5.0},
+    {"drive_acceleration", 20.0, 0.0, 100.0},
+    {"drive_brake_acceleration", 40.0, 0.0, 200.0},
+    {"drive_kp", 3.0, 0.0, 50.0},
+    {"drive_ki", 100.0, 0.0, 1000.0},
+    {"drive_kd", 0.0, 0.0, 10.0},
+    {"jitter_period_us", 1000.0, 50.0, 100000.0},
+    {"jitter_stress_threads", 0.0, 0.0, 8.0},
+    {"health_preemption_threshold", 10.0, 0.0, 1000.0},
+    {"health_warning_interval_s", 60.0, 0.0, 3600.0},
+};
+
+const char telemetry_schema[] = "{\"record\":\"telemetry_record_t\",\"size\":248,\"fields\":[[\"timestamp\",\"uint64\",1,0],[\"input_timestamp\",\"uint64\",1,8],[\"sensor_raw\",\"uint16\",16,16],[\"sensor_data\",\"double\",16,48],[\"position\",\"double\",1,176],[\"speed\",\"double\",1,184],[\"encoder_left\",\"int32\",1,192],[\"encoder_right\",\"int32\",1,196],[\"pid_left_target\",\"double\",1,200],[\"pid_right_target\",\"double\",1,208],[\"pid_left_output\",\"double\",1,216],[\"pid_right_output\",\"double\",1,224],[\"motor_left\",\"double\",1,232],[\"motor_right\",\"double\",1,240]]}";
 
 void state_print_offsets(state_t *state, char *buffer)
 {
   buffer += sprintf(buffer, "[");
   uint8_t* base_address = (uint8_t *)state;
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->state - base_address));
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->sensor_low - base_address));
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->sensor_high - base_address));
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->sensor_raw - base_address));
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->sensor_data - base_address));
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->position - base_address));
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->speed - base_address));
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->battery_voltage - base_address));
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->track - base_address));
-  buffer += sprintf(buffer, "%lu,", (uint64_t)(&state->encoder_left - base_address));
-  buffer += sprintf(buffer, "%lu", (uint64_t)(&state->encoder_right - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->state - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->generation - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->boot_time_ms - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->sensor_low - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->sensor_high - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->sensor_raw - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->sensor_data - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->position - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->speed - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->battery_voltage - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->track - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->input_age_histogram - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->input_age_max_us - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->encoder_left - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->encoder_right - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->encoder_rate - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->health_minor_faults - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->health_major_faults - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->health_voluntary_switches - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->health_involuntary_switches - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->health_migrations - base_address));
+  buffer += sprintf(buffer, "%lu,", (unsigned long)((uint8_t *)&state->health_cpu_time_ms - base_address));
+  buffer += sprintf(buffer, "%lu", (unsigned long)((uint8_t *)&state->health_names - base_address));
   buffer += sprintf(buffer, "]");
 }
+
+const char state_schema[] = "{\"version\": 3783565041, \"fields\": [[\"state\", \"uint32\", 1], [\"generation\", \"uint32\", 1], [\"boot_time_ms\", \"uint32\", 1], [\"sensor_low\", \"uint16\", 16], [\"sensor_high\", \"uint16\", 16], [\"sensor_raw\", \"uint16\", 16], [\"sensor_data\", \"double\", 16], [\"position\", \"double\", 1], [\"speed\", \"double\", 1], [\"battery_voltage\", \"double\", 1], [\"track\", \"uint8\", 1], [\"input_age_histogram\", \"uint32\", 16], [\"input_age_max_us\", \"uint32\", 1], [\"encoder_left\", \"int32\", 1], [\"encoder_right\", \"int32\", 1], [\"encoder_rate\", \"uint32\", 1], [\"health_minor_faults\", \"uint32\", 8], [\"health_major_faults\", \"uint32\", 8], [\"health_voluntary_switches\", \"uint32\", 8], [\"health_involuntary_switches\", \"uint32\", 8], [\"health_migrations\", \"uint32\", 8], [\"health_cpu_time_ms\", \"uint32\", 8], [\"health_names\", \"uint8\", 128]]}";
+
+// Values are copied in host order, the Pi and the browsers are little-endian
+#define STATE_DELTA_PUT(slot, value)                          \
+  do                                                          \
+  {                                                           \
+    uint16_t index = (slot);                                  \
+    memcpy(buffer + offset, &index, sizeof(index));           \
+    memcpy(buffer + offset + 2, &(value), sizeof(value));     \
+    offset += 2 + sizeof(value);                              \
+    count++;                                                  \
+  } while (0)
+
+size_t state_encode_delta(state_t *sent, const state_t *next, uint8_t *buffer)
+{
+  size_t offset = 3;
+  uint16_t count = 0;
+  {
+    uint32_t value = next->state;
+    if (sent == NULL || sent->state != value)
+    {
+      STATE_DELTA_PUT(0, value);
+      if (sent != NULL)
+      {
+        sent->state = value;
+      }
+    }
+  }
+  {
+    uint32_t value = next->generation;
+    if (sent == NULL || sent->generation != value)
+    {
+      STATE_DELTA_PUT(1, value);
+      if (sent != NULL)
+      {
+        sent->generation = value;
+      }
+    }
+  }
+  {
+    uint32_t value = next->boot_time_ms;
+    if (sent == NULL || sent->boot_time_ms != value)
+    {
+      STATE_DELTA_PUT(2, value);
+      if (sent != NULL)
+      {
+        sent->boot_time_ms = value;
+      }
+    }
+  }
+  for (int j = 0; j < 16; j++)
+  {
+    uint16_t value = next->sensor_low[j];
+    if (sent == NULL || sent->sensor_low[j] != value)
+    {
+      STATE_DELTA_PUT(3 + j, value);
+      if (sent != NULL)
+      {
+        sent->sensor_low[j] = value;
+      }
+    }
+  }
+  for (int j = 0; j < 16; j++)
+  {
+    uint16_t value = next->sensor_high[j];
+    if (sent == NULL || sent->sensor_high[j] != value)
+    {
+      STATE_DELTA_PUT(19 + j, value);
+      if (sent != NULL)
+      {
+        sent->sensor_high[j] = value;
+      }
+    }
+  }
+  for (int j = 0; j < 16; j++)
+  {
+    uint16_t value = next->sensor_raw[j];
+    if (sent == NULL || sent->sensor_raw[j] != value)
+    {
+      STATE_DELTA_PUT(35 + j, value);
+      if (sent != NULL)
+      {
+        sent->sensor_raw[j] = value;
+      }
+    }
+  }
+  for (int j = 0; j < 16; j++)
+  {
+    double value = next->sensor_data[j];
+    if (sent == NULL || sent->sensor_data[j] != value)
+    {
+      STATE_DELTA_PUT(51 + j, value);
+      if (sent != NULL)
+      {
+        sent->sensor_data[j] = value;
+      }
+    }
+  }
+  {
+    double value = next->position;
+    if (sent == NULL || sent->position != value)
+    {
+      STATE_DELTA_PUT(67, value);
+      if (sent != NULL)
+      {
+        sent->position = value;
+      }
+    }
+  }
+  {
+    double value = next->speed;
+    if (sent == NULL || sent->speed != value)
+    {
+      STATE_DELTA_PUT(68, value);
+      if (sent != NULL)
+      {
+        sent->speed = value;
+      }
+    }
+  }
+  {
+    double value = next->battery_voltage;
+    if (sent == NULL || sent->battery_voltage != value)
+    {
+      STATE_DELTA_PUT(69, value);
+      if (sent != NULL)
+      {
+        sent->battery_voltage = value;
+      }
+    }
+  }
+  {
+    uint8_t value = next->track;
+    if (sent == NULL || sent->track != value)
+    {
+      STATE_DELTA_PUT(70, value);
+      if (sent != NULL)
+      {
+        sent->track = value;
+      }
+    }
+  }
+  for (int j = 0; j < 16; j++)
+  {
+    uint32_t value = next->input_age_histogram[j];
+    if (sent == NULL || sent->input_age_histogram[j] != value)
+    {
+      STATE_DELTA_PUT(71 + j, value);
+      if (sent != NULL)
+      {
+        sent->input_age_histogram[j] = value;
+      }
+    }
+  }
+  {
+    uint32_t value = next->input_age_max_us;
+    if (sent == NULL || sent->input_age_max_us != value)
+    {
+      STATE_DELTA_PUT(87, value);
+      if (sent != NULL)
+      {
+        sent->input_age_max_us = value;
+      }
+    }
+  }
+  {
+    int32_t value = next->encoder_left;
+    if (sent == NULL || sent->encoder_left != value)
+    {
+      STATE_DELTA_PUT(88, value);
+      if (sent != NULL)
+      {
+        sent->encoder_left = value;
+      }
+    }
+  }
+  {
+    int32_t value = next->encoder_right;
+    if (sent == NULL || sent->encoder_right != value)
+    {
+      STATE_DELTA_PUT(89, value);
+      if (sent != NULL)
+      {
+        sent->encoder_right = value;
+      }
+    }
+  }
+  {
+    uint32_t value = next->encoder_rate;
+    if (sent == NULL || sent->encoder_rate != value)
+    {
+      STATE_DELTA_PUT(90, value);
+      if (sent != NULL)
+      {
+        sent->encoder_rate = value;
+      }
+    }
+  }
+  for (int j = 0; j < 8; j++)
+  {
+    uint32_t value = next->health_minor_faults[j];
+    if (sent == NULL || sent->health_minor_faults[j] != value)
+    {
+      STATE_DELTA_PUT(91 + j, value);
+      if (sent != NULL)
+      {
+        sent->health_minor_faults[j] = value;
+      }
+    }
+  }
+  for (int j = 0; j < 8; j++)
+  {
+    uint32_t value = next->health_major_faults[j];
+    if (sent == NULL || sent->health_major_faults[j] != value)
+    {
+      STATE_DELTA_PUT(99 + j, value);
+      if (sent != NULL)
+      {
+        sent->health_major_faults[j] = value;
+      }
+    }
+  }
+  for (int j = 0; j < 8; j++)
+  {
+    uint32_t value = next->health_voluntary_switches[j];
+    if (sent == NULL || sent->health_voluntary_switches[j] != value)
+    {
+      STATE_DELTA_PUT(107 + j, value);
+      if (sent != NULL)
+      {
+        sent->health_voluntary_switches[j] = value;
+      }
+    }
+  }
+  for (int j = 0; j < 8; j++)
+  {
+    uint32_t value = next->health_involuntary_switches[j];
+    if (sent == NULL || sent->health_involuntary_switches[j] != value)
+    {
+      STATE_DELTA_PUT(115 + j, value);
+      if (sent != NULL)
+      {
+        sent->health_involuntary_switches[j] = value;
+      }
+    }
+  }
+  for (int j = 0; j < 8; j++)
+  {
+    uint32_t value = next->health_migrations[j];
+    if (sent == NULL || sent->health_migrations[j] != value)
+    {
+      STATE_DELTA_PUT(123 + j, value);
+      if (sent != NULL)
+      {
+        sent->health_migrations[j] = value;
+      }
+    }
+  }
+  for (int j = 0; j < 8; j++)
+  {
+    uint32_t value = next->health_cpu_time_ms[j];
+    if (sent == NULL || sent->health_cpu_time_ms[j] != value)
+    {
+      STATE_DELTA_PUT(131 + j, value);
+      if (sent != NULL)
+      {
+        sent->health_cpu_time_ms[j] = value;
+      }
+    }
+  }
+  for (int j = 0; j < 128; j++)
+  {
+    uint8_t value = next->health_names[j];
+    if (sent == NULL || sent->health_names[j] != value)
+    {
+      STATE_DELTA_PUT(139 + j, value);
+      if (sent != NULL)
+      {
+        sent->health_names[j] = value;
+      }
+    }
+  }
+  if (count == 0)
+  {
+    return 0;
+  }
+  buffer[0] = STATE_MESSAGE_DELTA;
+  memcpy(buffer + 1, &count, sizeof(count));
+  return offset;
+}
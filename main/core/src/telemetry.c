@@ -0,0 +1,81 @@
+#include <telemetry.h>
+
+#include <stddef.h>
+#include <string.h>
+
+_Static_assert(offsetof(telemetry_t, head) == 16, "telemetry_t.head offset mismatch");
+_Static_assert(offsetof(telemetry_t, records) == 64, "telemetry_t.records offset mismatch");
+
+#define SLOT(index) ((index) & (TELEMETRY_CAPACITY - 1))
+
+void telemetry_init(telemetry_t *telemetry)
+{
+  telemetry->magic = TELEMETRY_MAGIC;
+  telemetry->record_size = sizeof(telemetry_record_t);
+  telemetry->capacity = TELEMETRY_CAPACITY;
+  telemetry->reserved = 0;
+  atomic_store_explicit(&telemetry->head, 0, memory_order_release);
+}
+
+void telemetry_push(const telemetry_record_t *record)
+{
+  if (telemetry == NULL)
+  {
+    return;
+  }
+
+  // Only the producer writes head, so a relaxed load is enough here
+  uint64_t head = atomic_load_explicit(&telemetry->head, memory_order_relaxed);
+  telemetry->records[SLOT(head)] = *record;
+  atomic_store_explicit(&telemetry->head, head + 1, memory_order_release);
+}
+
+void telemetry_reader_init(telemetry_reader_t *reader)
+{
+  // Start from the most recent record rather than replaying the history
+  reader->cursor = telemetry != NULL ? atomic_load_explicit(&telemetry->head, memory_order_acquire) : 0;
+  reader->overruns = 0;
+}
+
+uint32_t telemetry_read(telemetry_reader_t *reader, telemetry_record_t *records, uint32_t max_records)
+{
+  if (telemetry == NULL)
+  {
+    return 0;
+  }
+
+  // The slot of head - capacity may be being overwritten right now, so at
+  // most capacity - 1 records behind head are readable.
+  uint64_t head = atomic_load_explicit(&telemetry->head, memory_order_acquire);
+  if (head - reader->cursor > TELEMETRY_CAPACITY - 1)
+  {
+    uint64_t oldest = head - (TELEMETRY_CAPACITY - 1);
+    reader->overruns += oldest - reader->cursor;
+    reader->cursor = oldest;
+  }
+
+  uint32_t count = 0;
+  while (reader->cursor + count < head && count < max_records)
+  {
+    records[count] = telemetry->records[SLOT(reader->cursor + count)];
+    count++;
+  }
+
+  // Drop the records that were overwritten while they were being copied
+  atomic_thread_fence(memory_order_acquire);
+  uint64_t head_after = atomic_load_explicit(&telemetry->head, memory_order_relaxed);
+  uint32_t lapped = 0;
+  if (head_after - reader->cursor > TELEMETRY_CAPACITY - 1)
+  {
+    uint64_t oldest = head_after - (TELEMETRY_CAPACITY - 1);
+    lapped = oldest - reader->cursor > count ? count : (uint32_t)(oldest - reader->cursor);
+  }
+  if (lapped > 0)
+  {
+    memmove(records, records + lapped, (count - lapped) * sizeof(telemetry_record_t));
+    reader->overruns += lapped;
+  }
+
+  reader->cursor += count;
+  return count - lapped;
+}
@@ -0,0 +1,165 @@
+#include <topology.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ports/log.h>
+
+#define TOPOLOGY_FILE_SIZE 8192
+
+// Same as config/topology.conf
+const char topology_default[] =
+    "context thread_1 cpu=-1 priority=0 wait=sleep:1000\n"
+    "service clock\n"
+    "service publish\n"
+    "service health\n"
+    "context thread_2 cpu=2 priority=80 wait=spin\n"
+    "service encoder\n"
+    "service music\n"
+    "context thread_3 cpu=3 priority=80 wait=spin\n"
+    "service sensor\n"
+    "service sensor_low\n"
+    "service sensor_high\n"
+    "service line\n"
+    "service vsense\n"
+    "service drive\n";
+
+static bool topology_parse_option(topology_context_t *context, const char *option, uint32_t line_number)
+{
+  if (sscanf(option, "cpu=%d", &context->cpu) == 1)
+  {
+    return true;
+  }
+  if (sscanf(option, "priority=%d", &context->priority) == 1)
+  {
+    if (context->priority < 0 || context->priority > 99)
+    {
+      error("topology:%u: priority must be between 0 and 99", line_number);
+      return false;
+    }
+    return true;
+  }
+  if (strcmp(option, "wait=spin") == 0)
+  {
+    context->wait = TOPOLOGY_WAIT_SPIN;
+    return true;
+  }
+  if (strcmp(option, "wait=yield") == 0)
+  {
+    context->wait = TOPOLOGY_WAIT_YIELD;
+    return true;
+  }
+  if (sscanf(option, "wait=sleep:%u", &context->wait_us) == 1)
+  {
+    context->wait = TOPOLOGY_WAIT_SLEEP;
+    return true;
+  }
+  error("topology:%u: unknown option %s", line_number, option);
+  return false;
+}
+
+bool topology_parse(topology_t *topology, const char *text)
+{
+  memset(topology, 0, sizeof(topology_t));
+
+  char line[256];
+  uint32_t line_number = 0;
+  while (*text != '\0')
+  {
+    // Copy one line, without the comment
+    size_t length = strcspn(text, "\n");
+    size_t copy_length = length < sizeof(line) - 1 ? length : sizeof(line) - 1;
+    memcpy(line, text, copy_length);
+    line[copy_length] = '\0';
+    line[strcspn(line, "#")] = '\0';
+    text += length + (text[length] == '\n' ? 1 : 0);
+    line_number++;
+
+    char *save = NULL;
+    char *keyword = strtok_r(line, " \t\r", &save);
+    if (keyword == NULL)
+    {
+      continue;
+    }
+
+    char *name = strtok_r(NULL, " \t\r", &save);
+    if (name == NULL || strlen(name) >= TOPOLOGY_NAME_SIZE)
+    {
+      error("topology:%u: missing or too long name", line_number);
+      return false;
+    }
+
+    if (strcmp(keyword, "context") == 0)
+    {
+      if (topology->num_contexts >= TOPOLOGY_MAX_CONTEXTS)
+      {
+        error("topology:%u: too many contexts", line_number);
+        return false;
+      }
+      topology_context_t *context = &topology->contexts[topology->num_contexts++];
+      strcpy(context->name, name);
+      context->cpu = -1;
+      context->priority = 0;
+      context->wait = TOPOLOGY_WAIT_SPIN;
+
+      char *option;
+      while ((option = strtok_r(NULL, " \t\r", &save)) != NULL)
+      {
+        if (!topology_parse_option(context, option, line_number))
+        {
+          return false;
+        }
+      }
+    }
+    else if (strcmp(keyword, "service") == 0)
+    {
+      if (topology->num_contexts == 0)
+      {
+        error("topology:%u: service before the first context", line_number);
+        return false;
+      }
+      topology_context_t *context = &topology->contexts[topology->num_contexts - 1];
+      if (context->num_services >= EM_MAX_EXECUTION_CONTEXTS)
+      {
+        error("topology:%u: too many services", line_number);
+        return false;
+      }
+      strcpy(context->services[context->num_services++], name);
+    }
+    else
+    {
+      error("topology:%u: unknown keyword %s", line_number, keyword);
+      return false;
+    }
+  }
+
+  if (topology->num_contexts == 0)
+  {
+    error("topology: no context defined");
+    return false;
+  }
+  return true;
+}
+
+bool topology_load(topology_t *topology, const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+  {
+    warning("Failed to open topology file %s. Using the default topology.", path);
+    return topology_parse(topology, topology_default);
+  }
+
+  static char text[TOPOLOGY_FILE_SIZE];
+  size_t size = fread(text, 1, sizeof(text) - 1, file);
+  text[size] = '\0';
+  fclose(file);
+
+  if (!topology_parse(topology, text))
+  {
+    return false;
+  }
+  print("Topology loaded from %s", path);
+  return true;
+}
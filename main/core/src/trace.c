@@ -0,0 +1,154 @@
+#include <trace.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <ports/log.h>
+#include <ports/timer.h>
+
+// Written by the owning thread only
+typedef struct
+{
+  _Atomic uint32_t head;
+  uint32_t id;
+  const char *thread_name;
+  trace_event_t events[TRACE_BUFFER_CAPACITY];
+} trace_buffer_t;
+
+atomic_bool trace_enabled;
+
+static trace_buffer_t buffers[TRACE_BUFFER_COUNT];
+static _Atomic uint32_t buffers_claimed;
+static _Thread_local trace_buffer_t *buffer;
+static _Thread_local bool is_buffer_exhausted;
+
+static trace_buffer_t *trace_get_buffer()
+{
+  if (buffer != NULL || is_buffer_exhausted)
+  {
+    return buffer;
+  }
+
+  // Claim a buffer from the pool the first time this thread records
+  uint32_t index = atomic_fetch_add_explicit(&buffers_claimed, 1, memory_order_acq_rel);
+  if (index >= TRACE_BUFFER_COUNT)
+  {
+    is_buffer_exhausted = true;
+    return NULL;
+  }
+  buffer = &buffers[index];
+  buffer->id = index + 1;
+  return buffer;
+}
+
+void trace_init()
+{
+  // Prefault the buffers so that recording never page faults
+  memset(buffers, 0, sizeof(buffers));
+  atomic_store(&trace_enabled, false);
+}
+
+void trace_set_thread_name(const char *name)
+{
+  trace_buffer_t *b = trace_get_buffer();
+  if (b != NULL)
+  {
+    b->thread_name = name;
+  }
+}
+
+void trace_start()
+{
+  if (TRACE_IS_ENABLED())
+  {
+    return;
+  }
+
+  // Drop the events of the previous session
+  for (uint32_t i = 0; i < TRACE_BUFFER_COUNT; i++)
+  {
+    atomic_store_explicit(&buffers[i].head, 0, memory_order_relaxed);
+  }
+  atomic_store_explicit(&trace_enabled, true, memory_order_release);
+  print("Trace started");
+}
+
+void trace_stop()
+{
+  atomic_store_explicit(&trace_enabled, false, memory_order_release);
+  print("Trace stopped");
+}
+
+void trace_record(uint32_t phase, const char *name)
+{
+  trace_buffer_t *b = trace_get_buffer();
+  if (b == NULL)
+  {
+    return;
+  }
+
+  uint32_t head = atomic_load_explicit(&b->head, memory_order_relaxed);
+  trace_event_t *event = &b->events[head & (TRACE_BUFFER_CAPACITY - 1)];
+  event->timestamp_ns = timer_get_timestamp_ns();
+  event->name = name;
+  event->phase = phase;
+  atomic_store_explicit(&b->head, head + 1, memory_order_release);
+}
+
+bool trace_write(const char *path)
+{
+  if (TRACE_IS_ENABLED())
+  {
+    warning("Trace must be stopped before it is written");
+    return false;
+  }
+
+  FILE *file = fopen(path, "w");
+  if (file == NULL)
+  {
+    error("Failed to open trace file %s", path);
+    return false;
+  }
+
+  // Timestamps are relative to the oldest recorded event
+  uint64_t origin_ns = UINT64_MAX;
+  uint32_t claimed = atomic_load_explicit(&buffers_claimed, memory_order_acquire);
+  if (claimed > TRACE_BUFFER_COUNT)
+  {
+    claimed = TRACE_BUFFER_COUNT;
+  }
+  for (uint32_t i = 0; i < claimed; i++)
+  {
+    uint32_t head = atomic_load_explicit(&buffers[i].head, memory_order_acquire);
+    uint32_t first = head > TRACE_BUFFER_CAPACITY ? head - TRACE_BUFFER_CAPACITY : 0;
+    if (head > first && buffers[i].events[first & (TRACE_BUFFER_CAPACITY - 1)].timestamp_ns < origin_ns)
+    {
+      origin_ns = buffers[i].events[first & (TRACE_BUFFER_CAPACITY - 1)].timestamp_ns;
+    }
+  }
+
+  uint32_t count = 0;
+  fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  for (uint32_t i = 0; i < claimed; i++)
+  {
+    trace_buffer_t *b = &buffers[i];
+    fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            i == 0 ? "" : ",\n", b->id, b->thread_name != NULL ? b->thread_name : "unnamed");
+
+    uint32_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+    uint32_t first = head > TRACE_BUFFER_CAPACITY ? head - TRACE_BUFFER_CAPACITY : 0;
+    for (uint32_t j = first; j < head; j++)
+    {
+      trace_event_t *event = &b->events[j & (TRACE_BUFFER_CAPACITY - 1)];
+      fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u%s}",
+              event->name, (char)event->phase, (event->timestamp_ns - origin_ns) / 1000.0, b->id,
+              event->phase == TRACE_PHASE_INSTANT ? ",\"s\":\"t\"" : "");
+      count++;
+    }
+  }
+  fprintf(file, "\n]}\n");
+  fclose(file);
+
+  print("Trace with %u events written to %s", count, path);
+  return true;
+}
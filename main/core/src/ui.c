@@ -0,0 +1,425 @@
+#include <ui.h>
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+
+#include <state.h>
+#include <parameter.h>
+#include <ports/log.h>
+#include <ports/web.h>
+#include <ports/timer.h>
+
+#define UI_MESSAGE_SIZE 32768 // Largest JSON message, the escaped input history
+#define UI_LOG_CHUNK 4096
+#define UI_LABEL_SIZE 64
+#define UI_NAME_SIZE 48 // Leaves room for "=<value>" in a label
+#define UI_POLL_TIMEOUT_MS 1000
+
+typedef struct
+{
+  const char *name;
+  uint32_t type;
+  uint32_t id;
+} ui_text_command_t;
+
+// Same as textCommands in server/robot.js
+static const ui_text_command_t text_commands[] = {
+    {"idle", COMMAND_SET_STATE, EM_STATE_IDLE},
+    {"cali_low", COMMAND_SET_STATE, EM_STATE_CALI_LOW},
+    {"cali_high", COMMAND_SET_STATE, EM_STATE_CALI_HIGH},
+    {"cali_save", COMMAND_SET_STATE, EM_STATE_IDLE},
+    {"drive", COMMAND_SET_STATE, EM_STATE_DRIVE},
+    {"jitter", COMMAND_SET_STATE, EM_STATE_JITTER},
+    {"trace_start", COMMAND_START_TRACE, 0},
+    {"trace_stop", COMMAND_STOP_TRACE, 0},
+    {"profile_start", COMMAND_START_PROFILE, 0},
+    {"profile_stop", COMMAND_STOP_PROFILE, 0},
+    {"record_start", COMMAND_START_RECORDING, 0},
+    {"record_stop", COMMAND_STOP_RECORDING, 0},
+    {"quit", COMMAND_QUIT, 0},
+};
+
+static const ui_config_t *config;
+
+// State that was last broadcast, the base of the next delta
+static state_t sent_state;
+static bool is_state_sent;
+static uint32_t sent_generation;
+static uint8_t delta[STATE_DELTA_MAX_SIZE];
+
+static parameters_t parameter_values;
+static uint32_t parameter_sequence;
+
+static char input_history[UI_INPUT_HISTORY + 1];
+static size_t input_length;
+
+static uint32_t command_seq;
+static uint32_t ack_cursor;
+static char command_labels[COMMAND_CAPACITY][UI_LABEL_SIZE];
+
+static char message[UI_MESSAGE_SIZE];
+
+// Appends text as a JSON string, including the quotes
+static size_t ui_json_escape(char *buffer, size_t length, size_t size, const char *text, size_t text_length)
+{
+  static const char hex[] = "0123456789abcdef";
+  buffer[length++] = '"';
+  for (size_t i = 0; i < text_length && length + 8 < size; i++)
+  {
+    unsigned char c = text[i];
+    if (c == '"' || c == '\\')
+    {
+      buffer[length++] = '\\';
+      buffer[length++] = c;
+    }
+    else if (c == '\n')
+    {
+      buffer[length++] = '\\';
+      buffer[length++] = 'n';
+    }
+    else if (c < 0x20)
+    {
+      memcpy(buffer + length, "\\u00", 4);
+      buffer[length + 4] = hex[c >> 4];
+      buffer[length + 5] = hex[c & 0xF];
+      length += 6;
+    }
+    else
+    {
+      buffer[length++] = c;
+    }
+  }
+  buffer[length++] = '"';
+  return length;
+}
+
+static void ui_send_input(int32_t client, const char *text, size_t text_length)
+{
+  size_t length = sprintf(message, "{\"type\":\"input\",\"data\":");
+  length = ui_json_escape(message, length, sizeof(message) - 1, text, text_length);
+  message[length++] = '}';
+  web_send(client, false, message, length);
+}
+
+static void ui_send_parameters(int32_t client)
+{
+  const double *values = (const double *)&parameter_values;
+  size_t length = sprintf(message, "{\"type\":\"parameters\",\"data\":{\"definitions\":[");
+  for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+  {
+    const parameter_definition_t *definition = &parameter_definitions[i];
+    length += snprintf(message + length, sizeof(message) - length, "%s{\"name\":\"%s\",\"default\":%.15g,\"min\":%.15g,\"max\":%.15g}",
+                       i > 0 ? "," : "", definition->name, definition->default_value, definition->min, definition->max);
+  }
+  length += snprintf(message + length, sizeof(message) - length, "],\"values\":{");
+  for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+  {
+    length += snprintf(message + length, sizeof(message) - length, "%s\"%s\":%.15g", i > 0 ? "," : "", parameter_definitions[i].name, values[i]);
+  }
+  length += snprintf(message + length, sizeof(message) - length, "}}}");
+  web_send(client, false, message, length);
+}
+
+static void ui_handle_open(int32_t client)
+{
+  static const char status[] = "{\"type\":\"status\",\"data\":\"INITIALIZED\"}";
+  web_send(client, false, status, sizeof(status) - 1);
+
+  size_t length = snprintf(message, sizeof(message), "{\"type\":\"schema\",\"data\":%s}", state_schema);
+  web_send(client, false, message, length);
+
+  // The full state, as a delta from nothing
+  if (is_state_sent)
+  {
+    size_t delta_length = state_encode_delta(NULL, &sent_state, delta);
+    web_send(client, true, delta, delta_length);
+  }
+
+  ui_send_input(client, input_history, input_length);
+  ui_send_parameters(client);
+}
+
+static void ui_handle_state()
+{
+  // The publish service bumps the generation whenever it publishes a
+  // changed frame, so wakes for acknowledgements encode nothing
+  if (is_state_sent && state->generation == sent_generation)
+  {
+    return;
+  }
+  sent_generation = state->generation;
+
+  size_t length;
+  if (!is_state_sent)
+  {
+    memcpy(&sent_state, state, sizeof(state_t));
+    length = state_encode_delta(NULL, &sent_state, delta);
+    is_state_sent = true;
+  }
+  else
+  {
+    length = state_encode_delta(&sent_state, state, delta);
+  }
+  if (length > 0)
+  {
+    web_send(WEB_BROADCAST, true, delta, length);
+  }
+}
+
+static void ui_handle_acks()
+{
+  static const char *status_names[] = {"OK", "UNKNOWN", "UNSUPPORTED", "INVALID"};
+
+  command_ack_t ack;
+  while (command_poll_ack(config->commands, &ack_cursor, &ack))
+  {
+    const char *status_name = ack.status <= 0 && ack.status >= -3 ? status_names[-ack.status] : "ERROR";
+    print("Command %s: %s in %lluus", command_labels[ack.seq % COMMAND_CAPACITY], status_name, (unsigned long long)(ack.latency_ns / 1000));
+  }
+}
+
+static void ui_handle_parameters()
+{
+  if (!parameter_sync(&parameter_values, &parameter_sequence))
+  {
+    return;
+  }
+  ui_send_parameters(WEB_BROADCAST);
+}
+
+static void ui_handle_log()
+{
+  char chunk[UI_LOG_CHUNK];
+  ssize_t length = read(config->log_fd, chunk, sizeof(chunk));
+  if (length <= 0)
+  {
+    return;
+  }
+
+  // Keep the tail for clients that connect later
+  if ((size_t)length >= UI_INPUT_HISTORY)
+  {
+    memcpy(input_history, chunk + length - UI_INPUT_HISTORY, UI_INPUT_HISTORY);
+    input_length = UI_INPUT_HISTORY;
+  }
+  else
+  {
+    if (input_length + length > UI_INPUT_HISTORY)
+    {
+      size_t drop = input_length + length - UI_INPUT_HISTORY;
+      memmove(input_history, input_history + drop, input_length - drop);
+      input_length -= drop;
+    }
+    memcpy(input_history + input_length, chunk, length);
+    input_length += length;
+  }
+
+  // Still shown on the console, as with the Node server
+  write(config->console_fd, chunk, length);
+
+  ui_send_input(WEB_BROADCAST, chunk, length);
+}
+
+static void ui_send_command(const char *label, uint32_t type, uint32_t id, double value, uint64_t timestamp)
+{
+  command_t command = {
+      .seq = command_seq,
+      .type = type,
+      .id = id,
+      .reserved = 0,
+      .value = value,
+      .timestamp = timestamp,
+  };
+  // Reading the acks first frees their slots
+  ui_handle_acks();
+  if (!command_push(config->commands, ack_cursor, &command))
+  {
+    print("Command %s: queue is full", label);
+    return;
+  }
+  snprintf(command_labels[command_seq % COMMAND_CAPACITY], UI_LABEL_SIZE, "%s", label);
+  command_seq++;
+  notify_signal(config->command_notify);
+}
+
+// Finds "key": in a flat JSON object and returns what follows, or NULL
+static const char *ui_json_find(const char *json, const char *key)
+{
+  char pattern[UI_LABEL_SIZE];
+  snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+  const char *found = strstr(json, pattern);
+  if (found == NULL)
+  {
+    return NULL;
+  }
+  found += strlen(pattern);
+  while (*found == ' ' || *found == ':')
+  {
+    found++;
+  }
+  return found;
+}
+
+static bool ui_json_string(const char *json, const char *key, char *value, size_t size)
+{
+  const char *found = ui_json_find(json, key);
+  if (found == NULL || *found != '"')
+  {
+    return false;
+  }
+  found++;
+  size_t length = strcspn(found, "\"");
+  if (found[length] != '"' || length >= size)
+  {
+    return false;
+  }
+  memcpy(value, found, length);
+  value[length] = '\0';
+  return true;
+}
+
+static void ui_handle_message(const uint8_t *data, size_t length)
+{
+  // Timestamp on arrival, to measure the latency up to em_set_state()
+  uint64_t timestamp = timer_get_timestamp_ns();
+
+  char text[UI_MESSAGE_SIZE];
+  if (length >= sizeof(text))
+  {
+    return;
+  }
+  memcpy(text, data, length);
+  text[length] = '\0';
+
+  // Structured commands are JSON objects, mode changes are plain text
+  if (text[0] != '{')
+  {
+    for (uint32_t i = 0; i < sizeof(text_commands) / sizeof(text_commands[0]); i++)
+    {
+      if (strcmp(text, text_commands[i].name) == 0)
+      {
+        ui_send_command(text, text_commands[i].type, text_commands[i].id, 0, timestamp);
+        return;
+      }
+    }
+    print("Unknown command: %s", text);
+    return;
+  }
+
+  // Only the flat objects that the frontend sends are understood
+  char type[UI_LABEL_SIZE];
+  if (!ui_json_string(text, "type", type, sizeof(type)))
+  {
+    print("Invalid command: %s", text);
+    return;
+  }
+  if (strcmp(type, "save_parameters") == 0)
+  {
+    ui_send_command("save_parameters", COMMAND_SAVE_PARAMETERS, 0, 0, timestamp);
+    return;
+  }
+  if (strcmp(type, "set_parameter") != 0)
+  {
+    print("Unknown command type: %s", type);
+    return;
+  }
+
+  char name[UI_NAME_SIZE];
+  const char *value_text = ui_json_find(text, "value");
+  char *end = NULL;
+  double value = value_text != NULL ? strtod(value_text, &end) : 0;
+  if (!ui_json_string(text, "name", name, sizeof(name)) || end == value_text)
+  {
+    print("Invalid command: %s", text);
+    return;
+  }
+  for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+  {
+    if (strcmp(name, parameter_definitions[i].name) == 0)
+    {
+      char label[UI_LABEL_SIZE];
+      snprintf(label, sizeof(label), "%s=%g", name, value);
+      ui_send_command(label, COMMAND_SET_PARAMETER, i, value, timestamp);
+      return;
+    }
+  }
+  print("Invalid parameter: %s", name);
+}
+
+// Nothing drains the pipe once the server is gone, so stdout and stderr go
+// back to the console before writers block on a full pipe
+static void ui_restore_console()
+{
+  dup2(config->console_fd, 1);
+  dup2(config->console_fd, 2);
+
+  // Pass on what was written before
+  char chunk[UI_LOG_CHUNK];
+  ssize_t length;
+  while ((length = read(config->log_fd, chunk, sizeof(chunk))) > 0)
+  {
+    write(config->console_fd, chunk, length);
+  }
+  close(config->log_fd);
+}
+
+void *ui_run(void *arg)
+{
+  config = (const ui_config_t *)arg;
+
+  // Pick up wherever the queue and the parameter table are
+  command_seq = atomic_load_explicit(&config->commands->command_head, memory_order_relaxed);
+  ack_cursor = atomic_load_explicit(&config->commands->ack_head, memory_order_relaxed);
+  parameter_sequence = ~atomic_load_explicit(&parameters->sequence, memory_order_relaxed);
+  parameter_sync(&parameter_values, &parameter_sequence);
+
+  if (!web_open(config->port, config->root))
+  {
+    ui_restore_console();
+    error("UI server could not be started, logging to the console");
+    return NULL;
+  }
+  web_watch(config->state_notify);
+  web_watch(config->log_fd);
+
+  web_event_t event;
+  while (web_poll(&event, UI_POLL_TIMEOUT_MS))
+  {
+    switch (event.type)
+    {
+    case WEB_EVENT_OPEN:
+      ui_handle_open(event.client);
+      break;
+    case WEB_EVENT_MESSAGE:
+      if (!event.is_binary)
+      {
+        ui_handle_message(event.data, event.length);
+      }
+      break;
+    case WEB_EVENT_READABLE:
+      if (event.fd == config->state_notify)
+      {
+        notify_wait(config->state_notify);
+        ui_handle_state();
+        ui_handle_acks();
+        ui_handle_parameters();
+      }
+      else if (event.fd == config->log_fd)
+      {
+        ui_handle_log();
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  web_close();
+  ui_restore_console();
+  error("UI server stopped, logging to the console");
+  return NULL;
+}
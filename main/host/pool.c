@@ -0,0 +1,153 @@
+#include "pool.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint32_t begin; // Next index to run
+    uint32_t end;   // One past the last index of this share
+} pool_share_t;
+
+typedef struct
+{
+    pool_share_t shares[POOL_MAX_WORKERS];
+    uint32_t num_workers;
+    pool_task_t task;
+    void *context;
+} pool_t;
+
+typedef struct
+{
+    pool_t *pool;
+    uint32_t worker;
+} pool_worker_t;
+
+static bool pool_take(pool_share_t *share, uint32_t *index)
+{
+    pthread_mutex_lock(&share->lock);
+    bool is_taken = share->begin < share->end;
+    if (is_taken)
+    {
+        *index = share->begin++;
+    }
+    pthread_mutex_unlock(&share->lock);
+    return is_taken;
+}
+
+static bool pool_steal(pool_t *pool, uint32_t worker)
+{
+    // Victim with the most work left. The shares may change before the split
+    // below, which reads the victim again under its lock.
+    uint32_t victim = worker;
+    uint32_t most = 0;
+    for (uint32_t i = 0; i < pool->num_workers; i++)
+    {
+        pool_share_t *share = &pool->shares[i];
+        pthread_mutex_lock(&share->lock);
+        uint32_t left = share->end - share->begin;
+        pthread_mutex_unlock(&share->lock);
+        if (i != worker && left > most)
+        {
+            most = left;
+            victim = i;
+        }
+    }
+    if (victim == worker)
+    {
+        return false;
+    }
+
+    pool_share_t *share = &pool->shares[victim];
+    pool_share_t *own = &pool->shares[worker];
+    pthread_mutex_lock(&share->lock);
+    uint32_t left = share->end - share->begin;
+    uint32_t middle = share->end - (left + 1) / 2;
+    uint32_t end = share->end;
+    share->end = middle;
+    pthread_mutex_unlock(&share->lock);
+    if (middle == end)
+    {
+        return true; // Lost a race, look again
+    }
+
+    pthread_mutex_lock(&own->lock);
+    own->begin = middle;
+    own->end = end;
+    pthread_mutex_unlock(&own->lock);
+    return true;
+}
+
+static void *pool_worker(void *arg)
+{
+    pool_worker_t *worker = (pool_worker_t *)arg;
+    pool_t *pool = worker->pool;
+
+    while (true)
+    {
+        uint32_t index;
+        while (pool_take(&pool->shares[worker->worker], &index))
+        {
+            pool->task(index, worker->worker, pool->context);
+        }
+        if (!pool_steal(pool, worker->worker))
+        {
+            return NULL;
+        }
+    }
+}
+
+uint32_t pool_run(uint32_t num_tasks, uint32_t num_workers, pool_task_t task, void *context)
+{
+    static pool_t pool;
+    pool_worker_t workers[POOL_MAX_WORKERS];
+    pthread_t threads[POOL_MAX_WORKERS];
+
+    if (num_workers == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = cpus > 0 ? (uint32_t)cpus : 1;
+    }
+    if (num_workers > POOL_MAX_WORKERS)
+    {
+        num_workers = POOL_MAX_WORKERS;
+    }
+
+    pool.num_workers = num_workers;
+    pool.task = task;
+    pool.context = context;
+    for (uint32_t i = 0; i < num_workers; i++)
+    {
+        pthread_mutex_init(&pool.shares[i].lock, NULL);
+        pool.shares[i].begin = (uint32_t)((uint64_t)num_tasks * i / num_workers);
+        pool.shares[i].end = (uint32_t)((uint64_t)num_tasks * (i + 1) / num_workers);
+    }
+
+    // The calling thread is worker 0. The shares of workers that could not
+    // be started stay in the pool, so the others steal them.
+    uint32_t num_started = 1;
+    for (uint32_t i = 0; i < num_workers; i++)
+    {
+        workers[i] = (pool_worker_t){.pool = &pool, .worker = i};
+        if (i > 0 && pthread_create(&threads[i], NULL, pool_worker, &workers[i]) != 0)
+        {
+            fprintf(stderr, "Failed to create worker %u\n", i);
+            break;
+        }
+        num_started = i + 1;
+    }
+    pool_worker(&workers[0]);
+    for (uint32_t i = 1; i < num_started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (uint32_t i = 0; i < num_workers; i++)
+    {
+        pthread_mutex_destroy(&pool.shares[i].lock);
+    }
+    return num_started;
+}
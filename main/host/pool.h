@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+#define POOL_MAX_WORKERS 256
+
+typedef void (*pool_task_t)(uint32_t index, uint32_t worker, void *context);
+
+/*
+ * Runs task(index) for every index in [0, num_tasks) on num_workers threads
+ * (0 means one per online CPU) and returns when all are done.
+ *
+ * Work stealing: every worker starts with a contiguous share of the
+ * indices and takes them from the front. A worker that runs out steals the
+ * back half of the largest remaining share, so uneven task costs balance
+ * out without a shared queue being touched for every task.
+ */
+uint32_t pool_run(uint32_t num_tasks, uint32_t num_workers, pool_task_t task, void *context);
@@ -0,0 +1,277 @@
+/*
+ * Drives the robot around generated tracks in closed-loop simulation, see
+ * main/sim/sim.h, and reports the lap time and how closely the line was
+ * followed. Runs are deterministic: the same seed and parameters give the
+ * same lap.
+ *
+ * Usage: simulate [options]
+ *   --seed <n>            Track and sensor noise (default 1)
+ *   --laps <n>            Laps on tracks seed, seed + 1, ... (default 1)
+ *   --segments <n>        Curves per track (default 8)
+ *   --battery <volts>     (default 19.9, the voltage of the motor fit)
+ *   --noise <counts>      Sensor noise (default 20)
+ *   --grip <m/s^2>        Lateral acceleration before sliding (default 8)
+ *   --max-time <seconds>  Virtual time limit per lap (default 60)
+ *   --set <name>=<value>  Parameter from state-definition.json, repeatable
+ *   --dataset <prefix>    Write every lap as a labelled dataset for sweep
+ *   --verbose             Print the log of the services
+ *
+ * A dataset is <prefix>-<seed>.txt with the sensor values of every scan of
+ * the IR array, <prefix>-<seed>.txt.position with the true line position of
+ * every scan and <prefix>-<seed>.txt.marks with the scans that pass the end
+ * of a mark.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <state.h>
+
+#include <algorithms/mark.h>
+
+#include "../sim/sim.h"
+
+typedef struct
+{
+    FILE *frames;
+    FILE *positions;
+    FILE *marks;
+    uint32_t count;
+} dataset_t;
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool set_parameter(parameters_t *params, const char *assignment)
+{
+    const char *equals = strchr(assignment, '=');
+    if (equals == NULL)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+    {
+        const parameter_definition_t *definition = &parameter_definitions[i];
+        if (strlen(definition->name) == (size_t)(equals - assignment) && strncmp(definition->name, assignment, equals - assignment) == 0)
+        {
+            double value = strtod(equals + 1, NULL);
+            if (value < definition->min || value > definition->max)
+            {
+                fprintf(stderr, "Warning: %s=%g is outside [%g, %g]\n", definition->name, value, definition->min, definition->max);
+            }
+            ((double *)params)[i] = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static const char *mark_name(uint8_t mark)
+{
+    switch (mark)
+    {
+    case MARK_LEFT:
+        return "left";
+    case MARK_RIGHT:
+        return "right";
+    case MARK_BOTH:
+        return "both";
+    }
+    return "cross";
+}
+
+static void dataset_write(const sim_frame_t *frame, void *context)
+{
+    dataset_t *dataset = (dataset_t *)context;
+    for (int i = 0; i < SIM_NUM_SENSORS; i++)
+    {
+        fprintf(dataset->frames, i > 0 ? " %.4f" : "%.4f", frame->sensor_data[i]);
+    }
+    fputc('\n', dataset->frames);
+    fprintf(dataset->positions, "%.6f\n", frame->position);
+    if (frame->mark != MARK_NONE)
+    {
+        fprintf(dataset->marks, "%u %s\n", dataset->count, mark_name(frame->mark));
+    }
+    dataset->count++;
+}
+
+static bool dataset_open(dataset_t *dataset, const char *prefix, uint64_t seed)
+{
+    char path[4096];
+    *dataset = (dataset_t){0};
+    snprintf(path, sizeof(path), "%s-%llu.txt", prefix, (unsigned long long)seed);
+    dataset->frames = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s-%llu.txt.position", prefix, (unsigned long long)seed);
+    dataset->positions = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s-%llu.txt.marks", prefix, (unsigned long long)seed);
+    dataset->marks = fopen(path, "w");
+    if (dataset->frames == NULL || dataset->positions == NULL || dataset->marks == NULL)
+    {
+        perror(path);
+        return false;
+    }
+    return true;
+}
+
+static void dataset_close(dataset_t *dataset)
+{
+    if (dataset->frames != NULL)
+    {
+        fclose(dataset->frames);
+    }
+    if (dataset->positions != NULL)
+    {
+        fclose(dataset->positions);
+    }
+    if (dataset->marks != NULL)
+    {
+        fclose(dataset->marks);
+    }
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "Usage: simulate [options]\n"
+            "  --seed <n>            Track and sensor noise (default 1)\n"
+            "  --laps <n>            Laps on tracks seed, seed + 1, ... (default 1)\n"
+            "  --segments <n>        Curves per track (default 8)\n"
+            "  --battery <volts>     (default %g)\n"
+            "  --noise <counts>      Sensor noise (default 20)\n"
+            "  --grip <m/s^2>        Lateral acceleration before sliding (default 8)\n"
+            "  --max-time <seconds>  Virtual time limit per lap (default 60)\n"
+            "  --set <name>=<value>  Parameter from state-definition.json, repeatable\n"
+            "  --dataset <prefix>    Write every lap as a labelled dataset for sweep\n"
+            "  --verbose             Print the log of the services\n",
+            SIM_ARX_VOLTAGE);
+}
+
+int main(int argc, char **argv)
+{
+    sim_config_t config;
+    sim_config_init(&config);
+    parameters_t params;
+    for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+    {
+        ((double *)&params)[i] = parameter_definitions[i].default_value;
+    }
+    uint32_t laps = 1;
+    const char *dataset_prefix = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        if (strcmp(option, "--verbose") == 0)
+        {
+            config.is_verbose = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (strcmp(option, "--seed") == 0)
+        {
+            config.seed = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(option, "--laps") == 0)
+        {
+            laps = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if (strcmp(option, "--segments") == 0)
+        {
+            config.num_segments = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if (strcmp(option, "--battery") == 0)
+        {
+            config.battery_voltage = strtod(value, NULL);
+        }
+        else if (strcmp(option, "--noise") == 0)
+        {
+            config.sensor_noise = strtod(value, NULL);
+        }
+        else if (strcmp(option, "--grip") == 0)
+        {
+            config.grip = strtod(value, NULL);
+        }
+        else if (strcmp(option, "--max-time") == 0)
+        {
+            config.max_time_s = strtod(value, NULL);
+        }
+        else if (strcmp(option, "--dataset") == 0)
+        {
+            dataset_prefix = value;
+        }
+        else if (strcmp(option, "--set") == 0)
+        {
+            if (!set_parameter(&params, value))
+            {
+                fprintf(stderr, "Unknown parameter %s\n", value);
+                return 1;
+            }
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    uint64_t first_seed = config.seed;
+    uint32_t finished = 0;
+    double lap_time_sum = 0;
+    double virtual_s = 0;
+    double start = now_s();
+
+    printf("seed,finished,lap_time_s,length_m,rms_error_mm,max_error_mm,failure\n");
+    for (uint32_t lap = 0; lap < laps; lap++)
+    {
+        sim_result_t result;
+        dataset_t dataset;
+        config.seed = first_seed + lap;
+        if (dataset_prefix != NULL)
+        {
+            if (!dataset_open(&dataset, dataset_prefix, config.seed))
+            {
+                dataset_close(&dataset);
+                return 1;
+            }
+            config.on_frame = dataset_write;
+            config.frame_context = &dataset;
+        }
+        bool is_run = sim_run(&config, &params, &result);
+        if (dataset_prefix != NULL)
+        {
+            dataset_close(&dataset);
+        }
+        if (!is_run)
+        {
+            fprintf(stderr, "Failed to set up the simulation\n");
+            return 1;
+        }
+        printf("%llu,%d,%.3f,%.2f,%.2f,%.2f,%s\n", (unsigned long long)config.seed, result.is_finished,
+               result.lap_time_s, result.length_m, result.rms_error_m * 1e3, result.max_error_m * 1e3,
+               result.failure != NULL ? result.failure : "");
+        fflush(stdout);
+
+        virtual_s += result.time_s;
+        if (result.is_finished)
+        {
+            finished++;
+            lap_time_sum += result.lap_time_s;
+        }
+    }
+
+    double elapsed = now_s() - start;
+    fprintf(stderr, "%u/%u laps finished, mean lap %.3f s, %.1f s simulated in %.2f s (%.0fx real time)\n",
+            finished, laps, finished > 0 ? lap_time_sum / finished : 0, virtual_s, elapsed, virtual_s / elapsed);
+    return finished == laps ? 0 : 2;
+}
@@ -0,0 +1,721 @@
+/*
+ * Offline parameter sweep for the line and mark algorithms.
+ *
+ * Runs every combination of the given parameter ranges over every dataset
+ * on a pool of worker threads, and writes one CSV row per combination and
+ * dataset. Datasets are either sensor history text files (16 sensor values
+ * per line, as saved for analysis/sensor) or recordings (.rec, see
+ * ports/output.h), of which only sensor_data is used.
+ *
+ * Neither format has ground truth. Labels are read from next to the
+ * dataset when they exist: <dataset>.position with the true line position
+ * of every frame, one per line, and <dataset>.marks with one
+ * "<frame> left|right|both|cross" per line. simulate --dataset writes both
+ * for simulated laps. Without them the position error, and the matched,
+ * false and missed marks, are left empty; jitter and the number of marks
+ * found are always reported.
+ *
+ * Usage: sweep [options] <dataset>...
+ *   --estimator weighted|bayesian|both
+ *   --mark-threshold <range>
+ *   --side-margin <range>
+ *   --gate <range>           weighted sum only
+ *   --prior-weight <range>   Bayesian only
+ *   --workers <count>        0 for one per CPU
+ *   --output <file>          CSV, stdout by default
+ * A range is either a value or min:max:step.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <math.h>
+
+#include <state.h>
+#include <ports/output.h>
+#include <algorithms/line.h>
+#include <algorithms/mark.h>
+
+#include "pool.h"
+
+#define MARK_WINDOW 20 // Frames a mark may be off from its label
+
+#define ESTIMATOR_WEIGHTED 0x01
+#define ESTIMATOR_BAYESIAN 0x02
+
+typedef struct
+{
+    uint32_t frame;
+    uint8_t type;
+} sweep_mark_t;
+
+typedef struct
+{
+    const char *path;
+    double (*frames)[NUM_SENSORS];
+    uint32_t count;
+    double *positions; // True position of every frame, NULL without labels
+    sweep_mark_t *marks;
+    uint32_t num_marks;
+    bool has_marks;
+} dataset_t;
+
+typedef struct
+{
+    double min;
+    double max;
+    double step;
+} range_t;
+
+typedef struct
+{
+    uint8_t estimator;
+    line_config_t line;
+    double threshold;
+    double side_margin;
+} sweep_config_t;
+
+typedef struct
+{
+    double rms_error;
+    double jitter;
+    uint32_t num_marks;
+    uint32_t matched;
+    uint32_t false_marks;
+    uint32_t missed_marks;
+} sweep_result_t;
+
+typedef struct
+{
+    _Alignas(64) uint64_t frames;
+    double busy_s;
+} worker_stats_t;
+
+typedef struct
+{
+    dataset_t *datasets;
+    uint32_t num_datasets;
+    sweep_config_t *configs;
+    sweep_result_t *results;
+    worker_stats_t workers[POOL_MAX_WORKERS];
+} sweep_t;
+
+static double clock_s(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool dataset_append(dataset_t *dataset, uint32_t *capacity, const double *frame)
+{
+    if (dataset->count == *capacity)
+    {
+        uint32_t new_capacity = *capacity ? *capacity * 2 : 4096;
+        void *frames = realloc(dataset->frames, sizeof(*dataset->frames) * new_capacity);
+        if (frames == NULL)
+        {
+            return false;
+        }
+        dataset->frames = frames;
+        *capacity = new_capacity;
+    }
+    memcpy(dataset->frames[dataset->count++], frame, sizeof(*dataset->frames));
+    return true;
+}
+
+static bool dataset_load_text(dataset_t *dataset, FILE *file)
+{
+    uint32_t capacity = 0;
+    char *line = NULL;
+    size_t line_size = 0;
+    bool is_ok = true;
+
+    while (is_ok && getline(&line, &line_size, file) >= 0)
+    {
+        double frame[NUM_SENSORS];
+        char *cursor = line;
+        int i;
+        for (i = 0; i < NUM_SENSORS; i++)
+        {
+            char *end;
+            frame[i] = strtod(cursor, &end);
+            if (end == cursor)
+            {
+                break;
+            }
+            cursor = end;
+        }
+        // Skip headers and blank lines
+        if (i == NUM_SENSORS)
+        {
+            is_ok = dataset_append(dataset, &capacity, frame);
+        }
+    }
+
+    free(line);
+    return is_ok;
+}
+
+static bool dataset_load_recording(dataset_t *dataset, FILE *file)
+{
+    output_file_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, OUTPUT_FILE_MAGIC, sizeof(OUTPUT_FILE_MAGIC)) != 0)
+    {
+        fprintf(stderr, "%s: not a recording\n", dataset->path);
+        return false;
+    }
+    if (header.record_size != sizeof(telemetry_record_t))
+    {
+        fprintf(stderr, "%s: record size %u does not match this build (%zu)\n", dataset->path, header.record_size, sizeof(telemetry_record_t));
+        return false;
+    }
+
+    uint32_t capacity = 0;
+    long offset = header.header_size;
+    output_chunk_header_t chunk;
+    while (fseek(file, offset, SEEK_SET) == 0 && fread(&chunk, sizeof(chunk), 1, file) == 1)
+    {
+        if (chunk.magic != OUTPUT_CHUNK_MAGIC || chunk.size < sizeof(chunk))
+        {
+            break; // Truncated by a crash
+        }
+        if (chunk.type == OUTPUT_CHUNK_DATA)
+        {
+            for (uint32_t i = 0; i < chunk.count; i++)
+            {
+                telemetry_record_t record;
+                if (fread(&record, sizeof(record), 1, file) != 1)
+                {
+                    return true;
+                }
+                if (!dataset_append(dataset, &capacity, record.sensor_data))
+                {
+                    return false;
+                }
+            }
+        }
+        offset += chunk.size;
+    }
+    return true;
+}
+
+static uint8_t parse_mark(const char *name)
+{
+    if (strcmp(name, "left") == 0)
+    {
+        return MARK_LEFT;
+    }
+    if (strcmp(name, "right") == 0)
+    {
+        return MARK_RIGHT;
+    }
+    if (strcmp(name, "both") == 0)
+    {
+        return MARK_BOTH;
+    }
+    if (strcmp(name, "cross") == 0)
+    {
+        return MARK_CROSS;
+    }
+    return MARK_NONE;
+}
+
+static const char *mark_name(uint8_t mark)
+{
+    switch (mark)
+    {
+    case MARK_LEFT:
+        return "left";
+    case MARK_RIGHT:
+        return "right";
+    case MARK_BOTH:
+        return "both";
+    case MARK_CROSS:
+        return "cross";
+    }
+    return "none";
+}
+
+static bool dataset_load_positions(dataset_t *dataset)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.position", dataset->path);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        if (errno == ENOENT)
+        {
+            return true;
+        }
+        perror(path);
+        return false;
+    }
+
+    dataset->positions = malloc(sizeof(double) * dataset->count);
+    uint32_t count = 0;
+    double position;
+    while (dataset->positions != NULL && count < dataset->count && fscanf(file, "%lf", &position) == 1)
+    {
+        dataset->positions[count++] = position;
+    }
+    fclose(file);
+    if (count != dataset->count)
+    {
+        fprintf(stderr, "%s: %u positions for %u frames\n", path, count, dataset->count);
+        return false;
+    }
+    return true;
+}
+
+static bool dataset_load_marks(dataset_t *dataset)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s.marks", dataset->path);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        if (errno == ENOENT)
+        {
+            return true;
+        }
+        perror(path);
+        return false;
+    }
+
+    uint32_t capacity = 0;
+    unsigned frame;
+    char name[16];
+    while (fscanf(file, "%u %15s", &frame, name) == 2)
+    {
+        uint8_t type = parse_mark(name);
+        if (type == MARK_NONE)
+        {
+            fprintf(stderr, "%s: unknown mark %s\n", path, name);
+            continue;
+        }
+        if (dataset->num_marks == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            void *marks = realloc(dataset->marks, sizeof(*dataset->marks) * capacity);
+            if (marks == NULL)
+            {
+                fclose(file);
+                return false;
+            }
+            dataset->marks = marks;
+        }
+        dataset->marks[dataset->num_marks++] = (sweep_mark_t){.frame = frame, .type = type};
+    }
+    fclose(file);
+    dataset->has_marks = true;
+    return true;
+}
+
+static bool dataset_load(dataset_t *dataset, const char *path)
+{
+    *dataset = (dataset_t){.path = path};
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    size_t length = strlen(path);
+    bool is_ok;
+    if (length > 4 && strcmp(path + length - 4, ".rec") == 0)
+    {
+        is_ok = dataset_load_recording(dataset, file);
+    }
+    else
+    {
+        is_ok = dataset_load_text(dataset, file);
+    }
+    fclose(file);
+
+    if (is_ok && dataset->count == 0)
+    {
+        fprintf(stderr, "%s: no frames\n", path);
+        return false;
+    }
+    return is_ok && dataset_load_positions(dataset) && dataset_load_marks(dataset);
+}
+
+// Runs one configuration over a dataset. marks is filled with up to
+// max_marks detected marks when not NULL.
+static uint32_t sweep_evaluate(const sweep_config_t *config, const dataset_t *dataset, sweep_result_t *result, sweep_mark_t *marks, uint32_t max_marks)
+{
+    mark_t mark;
+    mark_init(&mark);
+    mark.threshold = config->threshold;
+    mark.side_margin = config->side_margin;
+
+    double position = 0;
+    double prev_position[2] = {0, 0};
+    double error_sum = 0;
+    double jitter_sum = 0;
+    uint32_t num_marks = 0;
+
+    for (uint32_t i = 0; i < dataset->count; i++)
+    {
+        double *frame = dataset->frames[i];
+        if (config->estimator == ESTIMATOR_WEIGHTED)
+        {
+            uint32_t used;
+            line_weighted_sum(&config->line, frame, position, &position, &used);
+        }
+        else
+        {
+            position = line_bayesian(&config->line, frame, position);
+        }
+
+        if (dataset->positions != NULL)
+        {
+            double error = position - dataset->positions[i];
+            error_sum += error * error;
+        }
+        if (i >= 2)
+        {
+            double acceleration = position - 2 * prev_position[0] + prev_position[1];
+            jitter_sum += acceleration * acceleration;
+        }
+        prev_position[1] = prev_position[0];
+        prev_position[0] = position;
+
+        uint8_t type = mark_state_machine(&mark, frame, position);
+        if (type != MARK_NONE)
+        {
+            if (num_marks < max_marks)
+            {
+                marks[num_marks] = (sweep_mark_t){.frame = i, .type = type};
+            }
+            num_marks++;
+        }
+    }
+
+    if (result != NULL)
+    {
+        result->rms_error = sqrt(error_sum / dataset->count);
+        result->jitter = dataset->count > 2 ? sqrt(jitter_sum / (dataset->count - 2)) : 0;
+        result->num_marks = num_marks;
+    }
+    return num_marks;
+}
+
+// Pairs each detected mark with the closest unpaired labelled mark of the
+// same type within MARK_WINDOW frames. Both lists are in frame order.
+static void sweep_match(const dataset_t *dataset, const sweep_mark_t *marks, uint32_t num_marks, sweep_result_t *result)
+{
+    bool *is_paired = calloc(dataset->num_marks + 1, sizeof(bool));
+    uint32_t first = 0;
+    result->matched = 0;
+
+    for (uint32_t i = 0; i < num_marks; i++)
+    {
+        while (first < dataset->num_marks && dataset->marks[first].frame + MARK_WINDOW < marks[i].frame)
+        {
+            first++;
+        }
+        int64_t best = -1;
+        uint32_t best_distance = MARK_WINDOW + 1;
+        for (uint32_t j = first; j < dataset->num_marks && dataset->marks[j].frame <= marks[i].frame + MARK_WINDOW; j++)
+        {
+            uint32_t distance = dataset->marks[j].frame > marks[i].frame ? dataset->marks[j].frame - marks[i].frame : marks[i].frame - dataset->marks[j].frame;
+            if (!is_paired[j] && dataset->marks[j].type == marks[i].type && distance < best_distance)
+            {
+                best = j;
+                best_distance = distance;
+            }
+        }
+        if (best >= 0)
+        {
+            is_paired[best] = true;
+            result->matched++;
+        }
+    }
+
+    result->false_marks = num_marks - result->matched;
+    result->missed_marks = dataset->num_marks - result->matched;
+    free(is_paired);
+}
+
+static void sweep_task(uint32_t index, uint32_t worker, void *context)
+{
+    sweep_t *sweep = (sweep_t *)context;
+    const sweep_config_t *config = &sweep->configs[index / sweep->num_datasets];
+    const dataset_t *dataset = &sweep->datasets[index % sweep->num_datasets];
+    sweep_result_t *result = &sweep->results[index];
+    // CPU time, so workers sharing a core are not charged for each other
+    double start = clock_s(CLOCK_THREAD_CPUTIME_ID);
+
+    // A mark takes at least two frames
+    uint32_t max_marks = dataset->count / 2 + 1;
+    sweep_mark_t *marks = malloc(sizeof(sweep_mark_t) * max_marks);
+    uint32_t num_marks = sweep_evaluate(config, dataset, result, marks, max_marks);
+    if (dataset->has_marks)
+    {
+        sweep_match(dataset, marks, num_marks < max_marks ? num_marks : max_marks, result);
+    }
+    free(marks);
+
+    sweep->workers[worker].frames += dataset->count;
+    sweep->workers[worker].busy_s += clock_s(CLOCK_THREAD_CPUTIME_ID) - start;
+}
+
+static bool parse_range(const char *text, range_t *range)
+{
+    char *end;
+    range->min = strtod(text, &end);
+    if (end == text)
+    {
+        return false;
+    }
+    if (*end == '\0')
+    {
+        range->max = range->min;
+        range->step = 1;
+        return true;
+    }
+    if (sscanf(end, ":%lf:%lf", &range->max, &range->step) != 2 || range->step <= 0 || range->max < range->min)
+    {
+        return false;
+    }
+    return true;
+}
+
+static uint32_t range_count(const range_t *range)
+{
+    return (uint32_t)floor((range->max - range->min) / range->step + 1e-9) + 1;
+}
+
+static double range_value(const range_t *range, uint32_t i)
+{
+    return range->min + range->step * i;
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "Usage: sweep [options] <dataset>...\n"
+            "  --estimator weighted|bayesian|both  (default weighted)\n"
+            "  --mark-threshold <range>            (default %g)\n"
+            "  --side-margin <range>               (default %g)\n"
+            "  --gate <range>                      (default %g, weighted sum only)\n"
+            "  --prior-weight <range>              (default %g, Bayesian only)\n"
+            "  --workers <count>                   (default 0, one per CPU)\n"
+            "  --output <file>                     (default stdout)\n"
+            "A range is either a value or min:max:step.\n",
+            MARK_DEFAULT_THRESHOLD, MARK_DEFAULT_SIDE_MARGIN, LINE_DEFAULT_GATE, LINE_DEFAULT_PRIOR_WEIGHT);
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t estimators = ESTIMATOR_WEIGHTED;
+    range_t threshold = {MARK_DEFAULT_THRESHOLD, MARK_DEFAULT_THRESHOLD, 1};
+    range_t side_margin = {MARK_DEFAULT_SIDE_MARGIN, MARK_DEFAULT_SIDE_MARGIN, 1};
+    range_t gate = {LINE_DEFAULT_GATE, LINE_DEFAULT_GATE, 1};
+    range_t prior_weight = {LINE_DEFAULT_PRIOR_WEIGHT, LINE_DEFAULT_PRIOR_WEIGHT, 1};
+    uint32_t num_workers = 0;
+    const char *output = NULL;
+    const char **paths = calloc(argc, sizeof(char *));
+    uint32_t num_paths = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        if (strncmp(option, "--", 2) != 0)
+        {
+            paths[num_paths++] = option;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        const char *value = argv[++i];
+        bool is_ok = true;
+        if (strcmp(option, "--estimator") == 0)
+        {
+            estimators = strcmp(value, "weighted") == 0   ? ESTIMATOR_WEIGHTED
+                         : strcmp(value, "bayesian") == 0 ? ESTIMATOR_BAYESIAN
+                         : strcmp(value, "both") == 0     ? ESTIMATOR_WEIGHTED | ESTIMATOR_BAYESIAN
+                                                          : 0;
+            is_ok = estimators != 0;
+        }
+        else if (strcmp(option, "--mark-threshold") == 0)
+        {
+            is_ok = parse_range(value, &threshold);
+        }
+        else if (strcmp(option, "--side-margin") == 0)
+        {
+            is_ok = parse_range(value, &side_margin);
+        }
+        else if (strcmp(option, "--gate") == 0)
+        {
+            is_ok = parse_range(value, &gate);
+        }
+        else if (strcmp(option, "--prior-weight") == 0)
+        {
+            is_ok = parse_range(value, &prior_weight);
+        }
+        else if (strcmp(option, "--workers") == 0)
+        {
+            num_workers = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if (strcmp(option, "--output") == 0)
+        {
+            output = value;
+        }
+        else
+        {
+            is_ok = false;
+        }
+        if (!is_ok)
+        {
+            fprintf(stderr, "Invalid option %s %s\n", option, value);
+            usage();
+            return 1;
+        }
+    }
+    if (num_paths == 0)
+    {
+        usage();
+        return 1;
+    }
+
+    static sweep_t sweep;
+    sweep.num_datasets = num_paths;
+    sweep.datasets = calloc(num_paths, sizeof(dataset_t));
+    uint64_t total_frames = 0;
+    for (uint32_t i = 0; i < num_paths; i++)
+    {
+        if (!dataset_load(&sweep.datasets[i], paths[i]))
+        {
+            return 1;
+        }
+        total_frames += sweep.datasets[i].count;
+    }
+
+    // Every combination, the estimator parameter depends on the estimator
+    uint32_t marks_count = range_count(&threshold) * range_count(&side_margin);
+    uint32_t num_configs = 0;
+    if (estimators & ESTIMATOR_WEIGHTED)
+    {
+        num_configs += marks_count * range_count(&gate);
+    }
+    if (estimators & ESTIMATOR_BAYESIAN)
+    {
+        num_configs += marks_count * range_count(&prior_weight);
+    }
+    sweep.configs = calloc(num_configs, sizeof(sweep_config_t));
+    sweep.results = calloc((size_t)num_configs * num_paths, sizeof(sweep_result_t));
+    if (sweep.configs == NULL || sweep.results == NULL)
+    {
+        fprintf(stderr, "Too many combinations: %u\n", num_configs);
+        return 1;
+    }
+
+    uint32_t c = 0;
+    for (uint8_t estimator = ESTIMATOR_WEIGHTED; estimator <= ESTIMATOR_BAYESIAN; estimator <<= 1)
+    {
+        if (!(estimators & estimator))
+        {
+            continue;
+        }
+        const range_t *line_range = estimator == ESTIMATOR_WEIGHTED ? &gate : &prior_weight;
+        for (uint32_t l = 0; l < range_count(line_range); l++)
+        {
+            for (uint32_t t = 0; t < range_count(&threshold); t++)
+            {
+                for (uint32_t m = 0; m < range_count(&side_margin); m++)
+                {
+                    sweep_config_t *config = &sweep.configs[c++];
+                    config->estimator = estimator;
+                    line_config_init(&config->line);
+                    if (estimator == ESTIMATOR_WEIGHTED)
+                    {
+                        config->line.gate = range_value(line_range, l);
+                    }
+                    else
+                    {
+                        config->line.prior_weight = range_value(line_range, l);
+                    }
+                    config->threshold = range_value(&threshold, t);
+                    config->side_margin = range_value(&side_margin, m);
+                }
+            }
+        }
+    }
+
+    double start = clock_s(CLOCK_MONOTONIC);
+    num_workers = pool_run(num_configs * num_paths, num_workers, sweep_task, &sweep);
+    double elapsed = clock_s(CLOCK_MONOTONIC) - start;
+
+    FILE *file = output ? fopen(output, "w") : stdout;
+    if (file == NULL)
+    {
+        perror(output);
+        return 1;
+    }
+    fprintf(file, "estimator,gate,prior_weight,mark_threshold,side_margin,dataset,frames,rms_error,jitter,marks,matched,false_marks,missed_marks\n");
+    for (uint32_t i = 0; i < num_configs * num_paths; i++)
+    {
+        const sweep_config_t *config = &sweep.configs[i / num_paths];
+        const dataset_t *dataset = &sweep.datasets[i % num_paths];
+        const sweep_result_t *result = &sweep.results[i];
+        fprintf(file, "%s,%g,%g,%g,%g,%s,%u,",
+                config->estimator == ESTIMATOR_WEIGHTED ? "weighted" : "bayesian",
+                config->line.gate, config->line.prior_weight, config->threshold, config->side_margin,
+                dataset->path, dataset->count);
+        // Columns that need labels are left empty without them
+        if (dataset->positions != NULL)
+        {
+            fprintf(file, "%.6f", result->rms_error);
+        }
+        fprintf(file, ",%.6f,%u,", result->jitter, result->num_marks);
+        if (dataset->has_marks)
+        {
+            fprintf(file, "%u,%u,%u", result->matched, result->false_marks, result->missed_marks);
+        }
+        else
+        {
+            fprintf(file, ",,");
+        }
+        fprintf(file, "\n");
+    }
+    if (file != stdout)
+    {
+        fclose(file);
+    }
+
+    for (uint32_t i = 0; i < num_paths; i++)
+    {
+        const dataset_t *dataset = &sweep.datasets[i];
+        fprintf(stderr, "%s: %u frames, %s", dataset->path, dataset->count, dataset->positions != NULL ? "labelled positions" : "no positions");
+        if (!dataset->has_marks)
+        {
+            fprintf(stderr, ", no marks");
+        }
+        else
+        {
+            fprintf(stderr, ", %u labelled marks", dataset->num_marks);
+        }
+        if (dataset->num_marks > 0)
+        {
+            fprintf(stderr, ", first %s at %u", mark_name(dataset->marks[0].type), dataset->marks[0].frame);
+        }
+        fprintf(stderr, "\n");
+    }
+    fprintf(stderr, "%u combinations x %u datasets, sweep %.2f s, %.0f frames/s\n",
+            num_configs, num_paths, elapsed, total_frames * num_configs / elapsed);
+    for (uint32_t i = 0; i < num_workers; i++)
+    {
+        const worker_stats_t *stats = &sweep.workers[i];
+        fprintf(stderr, "  worker %u: %llu frames, busy %.0f%%, %.0f frames/s\n", i, (unsigned long long)stats->frames,
+                100 * stats->busy_s / elapsed, stats->busy_s > 0 ? stats->frames / stats->busy_s : 0);
+    }
+    return 0;
+}
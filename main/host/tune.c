@@ -0,0 +1,423 @@
+/*
+ * Tunes the drive parameters in closed-loop simulation, see main/sim/sim.h.
+ *
+ * Minimizes the mean lap time over a set of generated tracks with
+ * Nelder-Mead, subject to a bound on the RMS distance of the sensor array
+ * from the line. Every candidate is run on every track, and all laps of a
+ * step run concurrently on a pool of worker threads: the reflection,
+ * expansion and both contractions of a step are evaluated together rather
+ * than one after the other, which keeps the workers busy at the cost of
+ * laps that the step ends up not needing.
+ *
+ * The search runs in coordinates scaled to [0, 1] by the bounds of
+ * state-definition.json, so that a step means the same for every parameter.
+ * The best parameters are printed as name=value, for simulate --set.
+ *
+ * Usage: tune [options]
+ *   --tune <name>[,<name>...]  Parameters to tune (default drive_speed,
+ *                              drive_curvature, drive_acceleration, drive_kp,
+ *                              drive_ki)
+ *   --set <name>=<value>       Starting point or fixed value, repeatable
+ *   --tracks <n>               Tracks seed, seed + 1, ... (default 8)
+ *   --seed <n>                 (default 1)
+ *   --segments <n>             Curves per track (default 8)
+ *   --max-rms-error <mm>       Tracking error bound (default 5)
+ *   --iterations <n>           (default 60)
+ *   --workers <count>          0 for one per CPU (default)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <state.h>
+
+#include "pool.h"
+#include "../sim/sim.h"
+
+#define MAX_DIMENSIONS PARAMETER_COUNT
+#define MAX_POINTS (MAX_DIMENSIONS + 1)
+#define INITIAL_STEP 0.1  // Size of the starting simplex, in scaled coordinates
+#define PENALTY_S 10.0    // Cost per multiple of the error bound exceeded
+#define CONVERGED_S 0.001 // Spread of the simplex costs to stop at
+
+// Nelder-Mead coefficients
+#define REFLECT 1.0
+#define EXPAND 2.0
+#define CONTRACT 0.5
+#define SHRINK 0.5
+
+typedef struct
+{
+    double x[MAX_DIMENSIONS]; // Scaled to [0, 1]
+    double cost;
+    double lap_time_s; // Mean of the finished laps
+    double rms_error_m; // Worst of the finished laps
+    uint32_t finished;
+} point_t;
+
+typedef struct
+{
+    sim_config_t config;
+    parameters_t base; // Values of the parameters that are not tuned
+    uint32_t indices[MAX_DIMENSIONS];
+    uint32_t dimensions;
+    uint32_t num_tracks;
+    uint64_t first_seed;
+    double max_rms_error_m;
+    uint32_t num_workers;
+
+    // The batch being evaluated
+    point_t *points[MAX_POINTS];
+    uint32_t num_points;
+    sim_result_t *results; // num_points * num_tracks
+    uint64_t laps;
+    double virtual_s;
+} tune_t;
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int32_t parameter_find(const char *name, size_t length)
+{
+    for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+    {
+        if (strlen(parameter_definitions[i].name) == length && strncmp(parameter_definitions[i].name, name, length) == 0)
+        {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+static double clamp(double value, double min, double max)
+{
+    return value < min ? min : value > max ? max : value;
+}
+
+static void tune_decode(const tune_t *tune, const point_t *point, parameters_t *params)
+{
+    *params = tune->base;
+    for (uint32_t i = 0; i < tune->dimensions; i++)
+    {
+        const parameter_definition_t *definition = &parameter_definitions[tune->indices[i]];
+        ((double *)params)[tune->indices[i]] = definition->min + point->x[i] * (definition->max - definition->min);
+    }
+}
+
+static void tune_task(uint32_t index, uint32_t worker, void *context)
+{
+    tune_t *tune = context;
+    (void)worker;
+
+    parameters_t params;
+    tune_decode(tune, tune->points[index / tune->num_tracks], &params);
+    sim_config_t config = tune->config;
+    config.seed = tune->first_seed + index % tune->num_tracks;
+    if (!sim_run(&config, &params, &tune->results[index]))
+    {
+        tune->results[index] = (sim_result_t){.failure = "set up failed"};
+    }
+}
+
+// Runs every point of the batch on every track and scores it. A lap that
+// does not finish costs as much as the time limit, and the error bound is a
+// penalty rather than a wall, so that the search can find its way back.
+static void tune_evaluate(tune_t *tune, point_t **points, uint32_t num_points)
+{
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        for (uint32_t j = 0; j < tune->dimensions; j++)
+        {
+            points[i]->x[j] = clamp(points[i]->x[j], 0, 1);
+        }
+        tune->points[i] = points[i];
+    }
+    tune->num_points = num_points;
+    pool_run(num_points * tune->num_tracks, tune->num_workers, tune_task, tune);
+
+    for (uint32_t i = 0; i < num_points; i++)
+    {
+        point_t *point = points[i];
+        double cost = 0;
+        double lap_time_sum = 0;
+        point->finished = 0;
+        point->rms_error_m = 0;
+        for (uint32_t j = 0; j < tune->num_tracks; j++)
+        {
+            const sim_result_t *result = &tune->results[i * tune->num_tracks + j];
+            tune->laps++;
+            tune->virtual_s += result->time_s;
+            if (!result->is_finished)
+            {
+                cost += tune->config.max_time_s;
+                continue;
+            }
+            double excess = (result->rms_error_m - tune->max_rms_error_m) / tune->max_rms_error_m;
+            cost += result->lap_time_s + (excess > 0 ? PENALTY_S * excess : 0);
+            lap_time_sum += result->lap_time_s;
+            point->finished++;
+            if (result->rms_error_m > point->rms_error_m)
+            {
+                point->rms_error_m = result->rms_error_m;
+            }
+        }
+        point->cost = cost / tune->num_tracks;
+        point->lap_time_s = point->finished > 0 ? lap_time_sum / point->finished : 0;
+    }
+}
+
+static int point_compare(const void *a, const void *b)
+{
+    const point_t *pa = a;
+    const point_t *pb = b;
+    return pa->cost < pb->cost ? -1 : pa->cost > pb->cost ? 1 : 0;
+}
+
+// centroid + coefficient * (centroid - worst)
+static void point_along(const tune_t *tune, const double *centroid, const point_t *worst, double coefficient, point_t *point)
+{
+    for (uint32_t i = 0; i < tune->dimensions; i++)
+    {
+        point->x[i] = centroid[i] + coefficient * (centroid[i] - worst->x[i]);
+    }
+}
+
+static void tune_print(const tune_t *tune, const point_t *point, FILE *file)
+{
+    parameters_t params;
+    tune_decode(tune, point, &params);
+    for (uint32_t i = 0; i < tune->dimensions; i++)
+    {
+        fprintf(file, "%s=%g\n", parameter_definitions[tune->indices[i]].name, ((double *)&params)[tune->indices[i]]);
+    }
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "Usage: tune [options]\n"
+            "  --tune <name>[,<name>...]  Parameters to tune (default drive_speed,\n"
+            "                             drive_curvature, drive_acceleration, drive_kp,\n"
+            "                             drive_ki)\n"
+            "  --set <name>=<value>       Starting point or fixed value, repeatable\n"
+            "  --tracks <n>               Tracks seed, seed + 1, ... (default 8)\n"
+            "  --seed <n>                 (default 1)\n"
+            "  --segments <n>             Curves per track (default 8)\n"
+            "  --max-rms-error <mm>       Tracking error bound (default 5)\n"
+            "  --iterations <n>           (default 60)\n"
+            "  --workers <count>          0 for one per CPU (default)\n");
+}
+
+static bool tune_parse_names(tune_t *tune, const char *names)
+{
+    tune->dimensions = 0;
+    while (*names != '\0')
+    {
+        size_t length = strcspn(names, ",");
+        int32_t index = parameter_find(names, length);
+        if (index < 0 || tune->dimensions >= MAX_DIMENSIONS)
+        {
+            fprintf(stderr, "Unknown parameter %.*s\n", (int)length, names);
+            return false;
+        }
+        tune->indices[tune->dimensions++] = (uint32_t)index;
+        names += length;
+        if (*names == ',')
+        {
+            names++;
+        }
+    }
+    return tune->dimensions > 0;
+}
+
+int main(int argc, char **argv)
+{
+    static tune_t tune;
+    sim_config_init(&tune.config);
+    for (uint32_t i = 0; i < PARAMETER_COUNT; i++)
+    {
+        ((double *)&tune.base)[i] = parameter_definitions[i].default_value;
+    }
+    tune.num_tracks = 8;
+    tune.first_seed = 1;
+    tune.max_rms_error_m = 0.005;
+    uint32_t iterations = 60;
+    const char *names = "drive_speed,drive_curvature,drive_acceleration,drive_kp,drive_ki";
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (strcmp(option, "--tune") == 0)
+        {
+            names = value;
+        }
+        else if (strcmp(option, "--set") == 0)
+        {
+            const char *equals = strchr(value, '=');
+            int32_t index = equals != NULL ? parameter_find(value, equals - value) : -1;
+            if (index < 0)
+            {
+                fprintf(stderr, "Unknown parameter %s\n", value);
+                return 1;
+            }
+            ((double *)&tune.base)[index] = strtod(equals + 1, NULL);
+        }
+        else if (strcmp(option, "--tracks") == 0)
+        {
+            tune.num_tracks = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if (strcmp(option, "--seed") == 0)
+        {
+            tune.first_seed = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(option, "--segments") == 0)
+        {
+            tune.config.num_segments = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if (strcmp(option, "--max-rms-error") == 0)
+        {
+            tune.max_rms_error_m = strtod(value, NULL) / 1e3;
+        }
+        else if (strcmp(option, "--iterations") == 0)
+        {
+            iterations = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else if (strcmp(option, "--workers") == 0)
+        {
+            tune.num_workers = (uint32_t)strtoul(value, NULL, 10);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (!tune_parse_names(&tune, names) || tune.num_tracks == 0 || tune.max_rms_error_m <= 0)
+    {
+        usage();
+        return 1;
+    }
+
+    uint32_t dimensions = tune.dimensions;
+    tune.results = malloc(sizeof(sim_result_t) * MAX_POINTS * tune.num_tracks);
+    if (tune.results == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    // Starting simplex: the defaults, and a step along every axis, inwards
+    // where the step would leave the bounds
+    point_t simplex[MAX_POINTS];
+    point_t *batch[MAX_POINTS];
+    for (uint32_t i = 0; i < dimensions; i++)
+    {
+        const parameter_definition_t *definition = &parameter_definitions[tune.indices[i]];
+        double value = ((double *)&tune.base)[tune.indices[i]];
+        simplex[0].x[i] = (value - definition->min) / (definition->max - definition->min);
+    }
+    for (uint32_t i = 0; i <= dimensions; i++)
+    {
+        simplex[i] = simplex[0];
+        if (i > 0)
+        {
+            double *x = &simplex[i].x[i - 1];
+            *x += *x + INITIAL_STEP <= 1 ? INITIAL_STEP : -INITIAL_STEP;
+        }
+        batch[i] = &simplex[i];
+    }
+
+    double start = now_s();
+    tune_evaluate(&tune, batch, dimensions + 1);
+
+    for (uint32_t iteration = 1; iteration <= iterations; iteration++)
+    {
+        qsort(simplex, dimensions + 1, sizeof(point_t), point_compare);
+        point_t *best = &simplex[0];
+        point_t *worst = &simplex[dimensions];
+
+        double elapsed = now_s() - start;
+        fprintf(stderr, "%3u: cost %.3f s, lap %.3f s, %u/%u finished, rms error %.2f mm, %.1f laps/s\n", iteration - 1,
+                best->cost, best->lap_time_s, best->finished, tune.num_tracks, best->rms_error_m * 1e3,
+                tune.laps / elapsed);
+        if (worst->cost - best->cost < CONVERGED_S)
+        {
+            break;
+        }
+
+        double centroid[MAX_DIMENSIONS] = {0};
+        for (uint32_t i = 0; i < dimensions; i++)
+        {
+            for (uint32_t j = 0; j < dimensions; j++)
+            {
+                centroid[j] += simplex[i].x[j] / dimensions;
+            }
+        }
+
+        // All candidates of the step at once
+        point_t reflected, expanded, outside, inside;
+        point_along(&tune, centroid, worst, REFLECT, &reflected);
+        point_along(&tune, centroid, worst, EXPAND, &expanded);
+        point_along(&tune, centroid, worst, CONTRACT, &outside);
+        point_along(&tune, centroid, worst, -CONTRACT, &inside);
+        point_t *candidates[4] = {&reflected, &expanded, &outside, &inside};
+        tune_evaluate(&tune, candidates, 4);
+
+        const point_t *next;
+        if (reflected.cost < best->cost)
+        {
+            next = expanded.cost < reflected.cost ? &expanded : &reflected;
+        }
+        else if (reflected.cost < simplex[dimensions - 1].cost)
+        {
+            next = &reflected;
+        }
+        else if (reflected.cost < worst->cost)
+        {
+            next = outside.cost <= reflected.cost ? &outside : NULL;
+        }
+        else
+        {
+            next = inside.cost < worst->cost ? &inside : NULL;
+        }
+
+        if (next != NULL)
+        {
+            *worst = *next;
+            continue;
+        }
+
+        // Shrink towards the best point
+        for (uint32_t i = 1; i <= dimensions; i++)
+        {
+            for (uint32_t j = 0; j < dimensions; j++)
+            {
+                simplex[i].x[j] = best->x[j] + SHRINK * (simplex[i].x[j] - best->x[j]);
+            }
+            batch[i - 1] = &simplex[i];
+        }
+        tune_evaluate(&tune, batch, dimensions);
+    }
+
+    qsort(simplex, dimensions + 1, sizeof(point_t), point_compare);
+    double elapsed = now_s() - start;
+    tune_print(&tune, &simplex[0], stdout);
+    fprintf(stderr, "Best: lap %.3f s, %u/%u finished, rms error %.2f mm\n", simplex[0].lap_time_s, simplex[0].finished,
+            tune.num_tracks, simplex[0].rms_error_m * 1e3);
+    fprintf(stderr, "%llu laps, %.1f s simulated in %.2f s: %.1f laps/s (%.0fx real time)\n",
+            (unsigned long long)tune.laps, tune.virtual_s, elapsed, tune.laps / elapsed, tune.virtual_s / elapsed);
+
+    free(tune.results);
+    return simplex[0].finished == tune.num_tracks ? 0 : 2;
+}
@@ -0,0 +1,218 @@
+#define _GNU_SOURCE
+
+#include <ports/arena.h>
+#include <ports/log.h>
+
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+#define ARENA_HUGEPAGE_SIZE (2 * 1024 * 1024)
+#define ALIGN_UP(x, a) (((x) + (a) - 1) / (a) * (a))
+
+typedef struct
+{
+    const char *owner;
+    size_t quota;
+    size_t used;
+    uint8_t *base;
+} arena_pool_t;
+
+static arena_pool_t pools[ARENA_MAX_POOLS];
+static uint32_t num_pools;
+static uint8_t *region;
+static size_t region_size;
+
+static atomic_bool is_audit_enabled;
+static _Thread_local bool is_rt_thread;
+
+static arena_pool_t *arena_find_pool(const char *owner)
+{
+    for (uint32_t i = 0; i < num_pools; i++)
+    {
+        if (strcmp(pools[i].owner, owner) == 0)
+        {
+            return &pools[i];
+        }
+    }
+    return NULL;
+}
+
+bool arena_declare(const char *owner, size_t quota)
+{
+    if (region != NULL)
+    {
+        error("Arena quota for %s declared after arena_init()", owner);
+        return false;
+    }
+
+    arena_pool_t *pool = arena_find_pool(owner);
+    if (pool == NULL)
+    {
+        if (num_pools >= ARENA_MAX_POOLS)
+        {
+            error("Too many arena pools");
+            return false;
+        }
+        pool = &pools[num_pools++];
+        pool->owner = owner;
+        pool->quota = 0;
+    }
+    pool->quota += ALIGN_UP(quota, ARENA_ALIGNMENT);
+    return true;
+}
+
+bool arena_init(bool use_hugepages)
+{
+    size_t total = 0;
+    for (uint32_t i = 0; i < num_pools; i++)
+    {
+        total += pools[i].quota;
+    }
+    if (total == 0)
+    {
+        return true;
+    }
+
+    // Huge pages save TLB misses on large buffers, but need to be reserved
+    // through vm.nr_hugepages, so fall back to normal pages
+    region = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (use_hugepages)
+    {
+        region_size = ALIGN_UP(total, ARENA_HUGEPAGE_SIZE);
+        region = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (region == MAP_FAILED)
+        {
+            print("Huge pages are not available for the arena, using normal pages");
+        }
+    }
+#endif
+    if (region == MAP_FAILED)
+    {
+        region_size = ALIGN_UP(total, (size_t)sysconf(_SC_PAGESIZE));
+        region = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (region == MAP_FAILED)
+    {
+        region = NULL;
+        error("Failed to map the arena: %s", strerror(errno));
+        return false;
+    }
+
+    // Lock and prefault, so that no allocation ever page faults
+    if (mlock(region, region_size) != 0)
+    {
+        warning("Failed to lock the arena: %s", strerror(errno));
+    }
+    memset(region, 0, region_size);
+
+    uint8_t *base = region;
+    for (uint32_t i = 0; i < num_pools; i++)
+    {
+        pools[i].base = base;
+        pools[i].used = 0;
+        base += pools[i].quota;
+        print("Arena pool %s: %zu kB", pools[i].owner, (pools[i].quota + 1023) / 1024);
+    }
+    return true;
+}
+
+void *arena_alloc(const char *owner, size_t size)
+{
+    arena_pool_t *pool = arena_find_pool(owner);
+    if (pool == NULL || pool->base == NULL)
+    {
+        error("No arena pool for %s", owner);
+        return NULL;
+    }
+
+    size = ALIGN_UP(size, ARENA_ALIGNMENT);
+    if (pool->used + size > pool->quota)
+    {
+        error("Arena quota of %s exceeded (%zu of %zu bytes used, %zu requested)", owner, pool->used, pool->quota, size);
+        return NULL;
+    }
+
+    void *pointer = pool->base + pool->used;
+    pool->used += size;
+    return pointer;
+}
+
+void arena_reset(const char *owner)
+{
+    arena_pool_t *pool = arena_find_pool(owner);
+    if (pool != NULL)
+    {
+        pool->used = 0;
+    }
+}
+
+void arena_mark_rt_thread()
+{
+    is_rt_thread = true;
+}
+
+void arena_audit_start()
+{
+    atomic_store(&is_audit_enabled, true);
+}
+
+#ifdef ARENA_AUDIT
+
+// Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free.
+// Only calls from the application objects are wrapped, not from libc.
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+void __real_free(void *pointer);
+
+static _Thread_local bool is_reporting;
+
+static void arena_audit(const char *function)
+{
+    if (!is_rt_thread || is_reporting || !atomic_load_explicit(&is_audit_enabled, memory_order_relaxed))
+    {
+        return;
+    }
+
+    is_reporting = true;
+#if ARENA_AUDIT_ABORT
+    error("%s() called from an RT thread", function);
+    log_stop();
+    abort();
+#else
+    warning("%s() called from an RT thread", function);
+#endif
+    is_reporting = false;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    arena_audit("malloc");
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    arena_audit("calloc");
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    arena_audit("realloc");
+    return __real_realloc(pointer, size);
+}
+
+void __wrap_free(void *pointer)
+{
+    arena_audit("free");
+    __real_free(pointer);
+}
+
+#endif
@@ -1,53 +1,648 @@
 #include <stdio.h>
+#include <stddef.h>
 #include <stdarg.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdatomic.h>
 
-#include <services/clock.h>
 #include <ports/log.h>
 #include <ports/timer.h>
+#include <ports/rt.h>
 
-float start_time_s = -1;
+#define LOG_RING_COUNT 8         // Threads that can log without blocking
+#define LOG_RING_CAPACITY 128    // Must be a power of two
+#define LOG_RECORD_SIZE 256      //
+#define LOG_MAX_ARGS 8           // Arguments (including * widths) per call
+#define LOG_RATE_LIMIT 1000      // Records per second per thread
+#define LOG_SIGNATURE_COUNT 32   // Formats whose arguments a thread remembers
+#define LOG_POLL_INTERVAL_NS 1000000
+#define LOG_LINE_SIZE 1024
 
-void print(const char *format, ...)
+#define LOG_LEVEL_PRINT 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARNING 2
+
+typedef union
+{
+    int64_t i;
+    double d;
+    const void *p;
+} log_arg_t;
+
+typedef struct
+{
+    const char *format;
+    uint64_t timestamp_ns;
+    uint8_t level;
+    uint8_t reserved[7];
+    log_arg_t args[LOG_MAX_ARGS];
+    char strings[LOG_RECORD_SIZE - 24 - LOG_MAX_ARGS * sizeof(log_arg_t)];
+} log_record_t;
+
+_Static_assert(sizeof(log_record_t) == LOG_RECORD_SIZE, "log_record_t size mismatch");
+
+// Kind of the argument consumed by a conversion specification
+typedef enum
+{
+    LOG_KIND_NONE,
+    LOG_KIND_INT,
+    LOG_KIND_LONG,
+    LOG_KIND_LLONG,
+    LOG_KIND_SIZE,
+    LOG_KIND_INTMAX,
+    LOG_KIND_PTRDIFF,
+    LOG_KIND_DOUBLE,
+    LOG_KIND_LDOUBLE,
+    LOG_KIND_STRING,
+    LOG_KIND_POINTER,
+} log_kind_t;
+
+typedef struct
+{
+    log_kind_t kind;
+    uint32_t star_count;
+} log_spec_t;
+
+// Kinds of the arguments that a format consumes, * widths included
+typedef struct
+{
+    const char *format;
+    uint32_t count;
+    uint8_t kinds[LOG_MAX_ARGS];
+} log_signature_t;
+
+// Single producer (the owning thread), single consumer (the log thread)
+typedef struct
+{
+    _Alignas(64) _Atomic uint32_t head;
+    _Alignas(64) _Atomic uint32_t tail;
+    _Alignas(64) _Atomic uint32_t dropped;
+    _Atomic uint32_t rate_limited;
+    uint64_t window_start_ns;
+    uint32_t window_count;
+    log_signature_t signatures[LOG_SIGNATURE_COUNT];
+    log_record_t records[LOG_RING_CAPACITY];
+} log_ring_t;
+
+static log_ring_t rings[LOG_RING_COUNT];
+static _Atomic uint32_t rings_claimed;
+static _Thread_local log_ring_t *ring;
+static _Thread_local bool is_ring_exhausted;
+
+static atomic_bool is_running;
+static pthread_t log_thread;
+static pthread_mutex_t output_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t start_time_ns;
+
+// Parse the conversion specification after a '%'. Returns a pointer past the
+// conversion character.
+static const char *log_parse_spec(const char *p, log_spec_t *spec)
+{
+    spec->kind = LOG_KIND_NONE;
+    spec->star_count = 0;
+
+    // Flags
+    while (*p != '\0' && strchr("-+ #0", *p) != NULL)
+    {
+        p++;
+    }
+
+    // Width and precision
+    while ((*p >= '0' && *p <= '9') || *p == '.' || *p == '*')
+    {
+        if (*p == '*')
+        {
+            spec->star_count++;
+        }
+        p++;
+    }
+
+    // Length modifier
+    log_kind_t integer = LOG_KIND_INT;
+    bool is_long_double = false;
+    switch (*p)
+    {
+    case 'h':
+        p += p[1] == 'h' ? 2 : 1;
+        break;
+    case 'l':
+        integer = p[1] == 'l' ? LOG_KIND_LLONG : LOG_KIND_LONG;
+        p += p[1] == 'l' ? 2 : 1;
+        break;
+    case 'z':
+        integer = LOG_KIND_SIZE;
+        p++;
+        break;
+    case 'j':
+        integer = LOG_KIND_INTMAX;
+        p++;
+        break;
+    case 't':
+        integer = LOG_KIND_PTRDIFF;
+        p++;
+        break;
+    case 'L':
+        is_long_double = true;
+        p++;
+        break;
+    }
+
+    // Conversion
+    switch (*p)
+    {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+    case 'c':
+        spec->kind = integer;
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        spec->kind = is_long_double ? LOG_KIND_LDOUBLE : LOG_KIND_DOUBLE;
+        break;
+    case 's':
+        spec->kind = LOG_KIND_STRING;
+        break;
+    case 'p':
+        spec->kind = LOG_KIND_POINTER;
+        break;
+    case '\0':
+        return p;
+    }
+    return p + 1;
+}
+
+static void log_parse_signature(const char *format, log_signature_t *signature)
+{
+    signature->format = format;
+    signature->count = 0;
+
+    for (const char *p = format; *p != '\0';)
+    {
+        if (*p++ != '%')
+        {
+            continue;
+        }
+
+        log_spec_t spec;
+        p = log_parse_spec(p, &spec);
+
+        // Width and precision given as arguments
+        for (uint32_t i = 0; i < spec.star_count && signature->count < LOG_MAX_ARGS; i++)
+        {
+            signature->kinds[signature->count++] = LOG_KIND_INT;
+        }
+
+        if (spec.kind == LOG_KIND_NONE)
+        {
+            continue;
+        }
+        if (signature->count >= LOG_MAX_ARGS)
+        {
+            break;
+        }
+        signature->kinds[signature->count++] = spec.kind;
+    }
+}
+
+// Formats are string literals that every call passes again, so a thread
+// parses each one on its first call only and looks it up by address after
+static const log_signature_t *log_get_signature(log_ring_t *r, const char *format)
+{
+    log_signature_t *signature = &r->signatures[((uintptr_t)format >> 3) % LOG_SIGNATURE_COUNT];
+    if (signature->format != format)
+    {
+        log_parse_signature(format, signature);
+    }
+    return signature;
+}
+
+// Copy the arguments described by the signature into the record
+static void log_capture(log_record_t *record, const log_signature_t *signature, va_list args)
+{
+    uint32_t string_size = 0;
+
+    for (uint32_t i = 0; i < signature->count; i++)
+    {
+        log_arg_t *arg = &record->args[i];
+        switch (signature->kinds[i])
+        {
+        case LOG_KIND_INT:
+            arg->i = va_arg(args, int);
+            break;
+        case LOG_KIND_LONG:
+            arg->i = va_arg(args, long);
+            break;
+        case LOG_KIND_LLONG:
+            arg->i = va_arg(args, long long);
+            break;
+        case LOG_KIND_SIZE:
+            arg->i = (int64_t)va_arg(args, size_t);
+            break;
+        case LOG_KIND_INTMAX:
+            arg->i = va_arg(args, intmax_t);
+            break;
+        case LOG_KIND_PTRDIFF:
+            arg->i = va_arg(args, ptrdiff_t);
+            break;
+        case LOG_KIND_DOUBLE:
+            arg->d = va_arg(args, double);
+            break;
+        case LOG_KIND_LDOUBLE:
+            arg->d = (double)va_arg(args, long double);
+            break;
+        case LOG_KIND_POINTER:
+            arg->p = va_arg(args, void *);
+            break;
+        case LOG_KIND_STRING:
+        {
+            // Strings are copied, truncated to what is left in the record
+            const char *string = va_arg(args, const char *);
+            if (string == NULL)
+            {
+                string = "(null)";
+            }
+            uint32_t available = sizeof(record->strings) - string_size;
+            if (available == 0)
+            {
+                // Point at the terminator of the last copied string
+                arg->i = sizeof(record->strings) - 1;
+                break;
+            }
+            uint32_t length = strnlen(string, available - 1);
+            memcpy(&record->strings[string_size], string, length);
+            record->strings[string_size + length] = '\0';
+            arg->i = string_size;
+            string_size += length + 1;
+            break;
+        }
+        case LOG_KIND_NONE:
+            break;
+        }
+    }
+}
+
+// Format a captured record, one conversion specification at a time
+static int log_format(char *buf, size_t size, const log_record_t *record)
+{
+    size_t length = 0;
+    uint32_t arg_count = 0;
+
+    for (const char *p = record->format; *p != '\0' && length + 1 < size;)
+    {
+        if (*p != '%')
+        {
+            buf[length++] = *p++;
+            continue;
+        }
+
+        const char *start = p;
+        log_spec_t spec;
+        p = log_parse_spec(p + 1, &spec);
+
+        char conversion[32];
+        size_t conversion_length = p - start;
+        if (conversion_length >= sizeof(conversion) || arg_count + spec.star_count + 1 > LOG_MAX_ARGS)
+        {
+            break;
+        }
+        memcpy(conversion, start, conversion_length);
+        conversion[conversion_length] = '\0';
+
+        int stars[2] = {0, 0};
+        for (uint32_t i = 0; i < spec.star_count && i < 2; i++)
+        {
+            stars[i] = (int)record->args[arg_count++].i;
+        }
+
+        if (spec.kind == LOG_KIND_NONE)
+        {
+            // Only "%%" is expected here
+            if (conversion_length == 2 && start[1] == '%')
+            {
+                buf[length++] = '%';
+            }
+            continue;
+        }
+
+        const log_arg_t *arg = &record->args[arg_count++];
+        char *out = buf + length;
+        size_t remaining = size - length;
+        int written = 0;
+
+#define LOG_SNPRINTF(value)                                                                \
+    (spec.star_count == 0   ? snprintf(out, remaining, conversion, value)                  \
+     : spec.star_count == 1 ? snprintf(out, remaining, conversion, stars[0], value)        \
+                            : snprintf(out, remaining, conversion, stars[0], stars[1], value))
+
+        switch (spec.kind)
+        {
+        case LOG_KIND_INT:
+            written = LOG_SNPRINTF((int)arg->i);
+            break;
+        case LOG_KIND_LONG:
+            written = LOG_SNPRINTF((long)arg->i);
+            break;
+        case LOG_KIND_LLONG:
+            written = LOG_SNPRINTF((long long)arg->i);
+            break;
+        case LOG_KIND_SIZE:
+            written = LOG_SNPRINTF((size_t)arg->i);
+            break;
+        case LOG_KIND_INTMAX:
+            written = LOG_SNPRINTF((intmax_t)arg->i);
+            break;
+        case LOG_KIND_PTRDIFF:
+            written = LOG_SNPRINTF((ptrdiff_t)arg->i);
+            break;
+        case LOG_KIND_DOUBLE:
+            written = LOG_SNPRINTF(arg->d);
+            break;
+        case LOG_KIND_LDOUBLE:
+            written = LOG_SNPRINTF((long double)arg->d);
+            break;
+        case LOG_KIND_POINTER:
+            written = LOG_SNPRINTF(arg->p);
+            break;
+        case LOG_KIND_STRING:
+            written = LOG_SNPRINTF(&record->strings[arg->i]);
+            break;
+        case LOG_KIND_NONE:
+            break;
+        }
+
+#undef LOG_SNPRINTF
+
+        if (written < 0)
+        {
+            break;
+        }
+        length += (size_t)written < remaining ? (size_t)written : remaining - 1;
+    }
+
+    buf[length] = '\0';
+    return length;
+}
+
+// Write one formatted line. Must be called with output_mutex held.
+static void log_write(const log_record_t *record)
 {
-    // Get current seconds in float
-    float s = timer_get_ns() / 1000000000.f + clock_get_s();
+    // Time is relative to the first log record
+    if (start_time_ns == 0)
+    {
+        start_time_ns = record->timestamp_ns;
+    }
+    double s = (record->timestamp_ns - start_time_ns) / 1e9;
+
+    char buf[LOG_LINE_SIZE];
+    log_format(buf, sizeof(buf), record);
 
-    // Initialize start_time_s if it is not initialized
-    if (start_time_s < 0)
+    switch (record->level)
     {
-        // Skip initialization if timer is not initialized
-        if (s > 0)
+    case LOG_LEVEL_ERROR:
+        printf("\033[31m[%07.3f] %s\r\n\033[0m", s, buf);
+        break;
+    case LOG_LEVEL_WARNING:
+        printf("\033[33m[%07.3f] %s\r\n\033[0m", s, buf);
+        break;
+    default:
+        printf("[%07.3f] %s\r\n", s, buf);
+        break;
+    }
+}
+
+// Write every pending record in timestamp order. Must be called with
+// output_mutex held.
+static uint32_t log_drain()
+{
+    uint32_t count = 0;
+    while (true)
+    {
+        log_ring_t *oldest = NULL;
+        uint32_t claimed = atomic_load_explicit(&rings_claimed, memory_order_acquire);
+        for (uint32_t i = 0; i < claimed && i < LOG_RING_COUNT; i++)
+        {
+            log_ring_t *r = &rings[i];
+            uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+            if (atomic_load_explicit(&r->head, memory_order_acquire) == tail)
+            {
+                continue;
+            }
+            if (oldest == NULL || r->records[tail % LOG_RING_CAPACITY].timestamp_ns < oldest->records[atomic_load_explicit(&oldest->tail, memory_order_relaxed) % LOG_RING_CAPACITY].timestamp_ns)
+            {
+                oldest = r;
+            }
+        }
+        if (oldest == NULL)
         {
-            start_time_s = s;
+            break;
         }
+
+        uint32_t tail = atomic_load_explicit(&oldest->tail, memory_order_relaxed);
+        log_write(&oldest->records[tail % LOG_RING_CAPACITY]);
+        atomic_store_explicit(&oldest->tail, tail + 1, memory_order_release);
+        count++;
     }
 
-    char buf[1024];
+    if (count > 0)
+    {
+        fflush(stdout);
+    }
+    return count;
+}
+
+static void log_report_drops()
+{
+    uint32_t dropped = 0;
+    uint32_t rate_limited = 0;
+    for (uint32_t i = 0; i < LOG_RING_COUNT; i++)
+    {
+        dropped += atomic_exchange_explicit(&rings[i].dropped, 0, memory_order_relaxed);
+        rate_limited += atomic_exchange_explicit(&rings[i].rate_limited, 0, memory_order_relaxed);
+    }
+    if (dropped == 0 && rate_limited == 0)
+    {
+        return;
+    }
+
+    log_record_t record;
+    record.format = "Log dropped %u records (ring full), %u records (rate limited)";
+    record.timestamp_ns = timer_get_timestamp_ns();
+    record.level = LOG_LEVEL_WARNING;
+    record.args[0].i = dropped;
+    record.args[1].i = rate_limited;
+    log_write(&record);
+    fflush(stdout);
+}
+
+static void *log_thread_main(void *_)
+{
+    uint64_t last_report_ns = timer_get_timestamp_ns();
+    while (atomic_load_explicit(&is_running, memory_order_acquire))
+    {
+        pthread_mutex_lock(&output_mutex);
+        log_drain();
+        uint64_t now_ns = timer_get_timestamp_ns();
+        if (now_ns - last_report_ns >= 1000000000)
+        {
+            log_report_drops();
+            last_report_ns = now_ns;
+        }
+        pthread_mutex_unlock(&output_mutex);
+
+        struct timespec interval = {0, LOG_POLL_INTERVAL_NS};
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+static log_ring_t *log_get_ring()
+{
+    if (ring != NULL || is_ring_exhausted)
+    {
+        return ring;
+    }
+
+    // Claim a ring from the pool the first time this thread logs
+    uint32_t index = atomic_fetch_add_explicit(&rings_claimed, 1, memory_order_acq_rel);
+    if (index >= LOG_RING_COUNT)
+    {
+        is_ring_exhausted = true;
+        return NULL;
+    }
+    ring = &rings[index];
+    return ring;
+}
+
+static void log_push(uint8_t level, const char *format, va_list args)
+{
+    uint64_t timestamp_ns = timer_get_timestamp_ns();
+
+    // Synchronous output before the log thread is started, after it is
+    // stopped, and for threads that did not get a ring
+    log_ring_t *r = atomic_load_explicit(&is_running, memory_order_acquire) ? log_get_ring() : NULL;
+    if (r == NULL)
+    {
+        log_record_t record;
+        record.format = format;
+        record.timestamp_ns = timestamp_ns;
+        record.level = level;
+        log_signature_t signature;
+        log_parse_signature(format, &signature);
+        log_capture(&record, &signature, args);
+
+        pthread_mutex_lock(&output_mutex);
+        log_write(&record);
+        fflush(stdout);
+        pthread_mutex_unlock(&output_mutex);
+        return;
+    }
+
+    // Rate limit per thread over one second windows
+    if (timestamp_ns - r->window_start_ns >= 1000000000)
+    {
+        r->window_start_ns = timestamp_ns;
+        r->window_count = 0;
+    }
+    if (r->window_count >= LOG_RATE_LIMIT)
+    {
+        atomic_fetch_add_explicit(&r->rate_limited, 1, memory_order_relaxed);
+        return;
+    }
+    r->window_count++;
+
+    // Never wait for the log thread, drop the record instead
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&r->tail, memory_order_acquire) >= LOG_RING_CAPACITY)
+    {
+        atomic_fetch_add_explicit(&r->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    log_record_t *record = &r->records[head % LOG_RING_CAPACITY];
+    record->format = format;
+    record->timestamp_ns = timestamp_ns;
+    record->level = level;
+    log_capture(record, log_get_signature(r, format), args);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+void print(const char *format, ...)
+{
     va_list args;
     va_start(args, format);
-    vsnprintf(buf, sizeof(buf), format, args);
+    log_push(LOG_LEVEL_PRINT, format, args);
     va_end(args);
-
-    printf("[%07.3f] %s\r\n", (s - start_time_s), buf);
-    fflush(stdout);
 }
 
 void error(const char *format, ...)
 {
-    printf("\033[31m");
-    print(format);
-    printf("\033[0m");
+    va_list args;
+    va_start(args, format);
+    log_push(LOG_LEVEL_ERROR, format, args);
+    va_end(args);
 }
 
 void warning(const char *format, ...)
 {
-    printf("\033[33m");
-    print(format);
-    printf("\033[0m");
+    va_list args;
+    va_start(args, format);
+    log_push(LOG_LEVEL_WARNING, format, args);
+    va_end(args);
 }
 
 void clear()
 {
     printf("\033[H\033[J");
-}
\ No newline at end of file
+}
+
+void log_start()
+{
+    if (atomic_load(&is_running))
+    {
+        return;
+    }
+
+    // Prefault the rings so that the first log call of an RT thread does not
+    // page fault
+    memset(rings, 0, sizeof(rings));
+
+    atomic_store(&is_running, true);
+    if (pthread_create(&log_thread, rt_get_thread_attr(), log_thread_main, NULL) != 0)
+    {
+        atomic_store(&is_running, false);
+        error("Failed to start log thread, logging synchronously");
+    }
+}
+
+void log_stop()
+{
+    if (!atomic_exchange(&is_running, false))
+    {
+        return;
+    }
+
+    // The log thread drains once more when it sees is_running cleared. Stop
+    // is called on the main thread during shutdown, never from a signal
+    // handler, so it may join and lock.
+    pthread_join(log_thread, NULL);
+
+    // Flush whatever has been pushed since
+    pthread_mutex_lock(&output_mutex);
+    log_drain();
+    log_report_drops();
+    pthread_mutex_unlock(&output_mutex);
+}
@@ -0,0 +1,42 @@
+#include <ports/notify.h>
+
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+// Notifications are eventfds, intentionally created without EFD_CLOEXEC so
+// that the UI server inherits them across fork/exec. The descriptor number
+// doubles as the handle that is passed to the UI server.
+
+bool notify_create(notify_t *notify)
+{
+    *notify = eventfd(0, 0);
+    return *notify != -1;
+}
+
+void notify_signal(notify_t notify)
+{
+    if (notify == -1)
+    {
+        return;
+    }
+
+    // eventfd accumulates the counter, so a reader that is late wakes up
+    // once for any number of signals instead of once per signal.
+    uint64_t value = 1;
+    write(notify, &value, sizeof(value));
+}
+
+bool notify_wait(notify_t notify)
+{
+    uint64_t value;
+    while (read(notify, &value, sizeof(value)) != sizeof(value))
+    {
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+    return true;
+}
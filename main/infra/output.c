@@ -1,10 +1,64 @@
-#include "output.h"
+#include <ports/output.h>
+#include <ports/log.h>
+#include <ports/timer.h>
+#include <ports/rt.h>
 
+#include <time.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <errno.h>
+
+#define OUTPUT_BUFFER_COUNT 2
+#define OUTPUT_ALIGNMENT 4096
+#define OUTPUT_POLL_INTERVAL_NS 2000000
+
+#define OUTPUT_BUFFER_FREE 0
+#define OUTPUT_BUFFER_FILLING 1
+#define OUTPUT_BUFFER_FULL 2
+
+_Static_assert(sizeof(output_file_header_t) <= OUTPUT_HEADER_SIZE, "output_file_header_t too large");
+_Static_assert(sizeof(output_chunk_header_t) == 64, "output_chunk_header_t size mismatch");
+_Static_assert(OUTPUT_CHUNK_SIZE % OUTPUT_ALIGNMENT == 0, "OUTPUT_CHUNK_SIZE must be aligned");
+_Static_assert(sizeof(output_chunk_header_t) + OUTPUT_INDEX_INTERVAL * sizeof(output_index_entry_t) <= OUTPUT_ALIGNMENT, "Index does not fit in a block");
+
+typedef struct
+{
+  _Atomic uint32_t state;
+  uint32_t count;
+  uint32_t dropped;
+  _Alignas(OUTPUT_ALIGNMENT) uint8_t data[OUTPUT_CHUNK_SIZE];
+} output_buffer_t;
+
+static output_buffer_t buffers[OUTPUT_BUFFER_COUNT];
+static _Alignas(OUTPUT_ALIGNMENT) uint8_t header[OUTPUT_HEADER_SIZE];
+static _Alignas(OUTPUT_ALIGNMENT) uint8_t index_chunk[OUTPUT_ALIGNMENT];
+static output_index_entry_t index_entries[OUTPUT_INDEX_INTERVAL];
+static uint32_t index_count;
+
+static int fd = -1;
+static pthread_t writer_thread;
+static atomic_bool is_open;
+static atomic_bool is_writer_running;
+static atomic_bool is_producer_busy;
+
+// Producer side
+static uint32_t active;
+static uint32_t capacity;
+static uint32_t record_size;
+static uint32_t pending_dropped;
+
+// Writer side
+static uint32_t next;
+static uint32_t sequence;
+static uint64_t offset;
+static output_stats_t stats;
+static uint64_t start_ns;
 
 // Recursively create a directory
 int mkdir_recursive(const char *path, mode_t mode)
@@ -49,3 +103,275 @@ int mkdir_recursive(const char *path, mode_t mode)
 
   return 0;
 }
+
+static bool output_write_all(const void *data, size_t size)
+{
+  uint64_t begin_ns = timer_get_timestamp_ns();
+  const uint8_t *p = data;
+  while (size > 0)
+  {
+    ssize_t written = write(fd, p, size);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return false;
+    }
+    p += written;
+    size -= written;
+    offset += written;
+    stats.bytes_written += written;
+  }
+  stats.write_s += (timer_get_timestamp_ns() - begin_ns) / 1e9;
+  return true;
+}
+
+static void output_write_index()
+{
+  if (index_count == 0)
+  {
+    return;
+  }
+
+  output_chunk_header_t *chunk = (output_chunk_header_t *)index_chunk;
+  memset(index_chunk, 0, sizeof(index_chunk));
+  chunk->magic = OUTPUT_CHUNK_MAGIC;
+  chunk->type = OUTPUT_CHUNK_INDEX;
+  chunk->size = sizeof(index_chunk);
+  chunk->count = index_count;
+  chunk->first_timestamp_ns = index_entries[0].first_timestamp_ns;
+  chunk->last_timestamp_ns = index_entries[index_count - 1].last_timestamp_ns;
+  memcpy(index_chunk + sizeof(output_chunk_header_t), index_entries, index_count * sizeof(output_index_entry_t));
+
+  if (!output_write_all(index_chunk, sizeof(index_chunk)))
+  {
+    error("Failed to write recording index");
+  }
+  index_count = 0;
+}
+
+static void output_write_chunk(output_buffer_t *buffer)
+{
+  // Timestamps are the first field of every record
+  uint8_t *records = buffer->data + sizeof(output_chunk_header_t);
+  output_chunk_header_t *chunk = (output_chunk_header_t *)buffer->data;
+  memset(chunk, 0, sizeof(output_chunk_header_t));
+  chunk->magic = OUTPUT_CHUNK_MAGIC;
+  chunk->type = OUTPUT_CHUNK_DATA;
+  chunk->size = OUTPUT_CHUNK_SIZE;
+  chunk->count = buffer->count;
+  chunk->sequence = sequence++;
+  chunk->dropped = buffer->dropped;
+  memcpy(&chunk->first_timestamp_ns, records, sizeof(uint64_t));
+  memcpy(&chunk->last_timestamp_ns, records + (buffer->count - 1) * record_size, sizeof(uint64_t));
+
+  output_index_entry_t *entry = &index_entries[index_count++];
+  entry->offset = offset;
+  entry->first_timestamp_ns = chunk->first_timestamp_ns;
+  entry->last_timestamp_ns = chunk->last_timestamp_ns;
+
+  if (!output_write_all(buffer->data, OUTPUT_CHUNK_SIZE))
+  {
+    error("Failed to write recording chunk");
+  }
+  stats.record_count += buffer->count;
+  stats.dropped_count += buffer->dropped;
+
+  if (index_count == OUTPUT_INDEX_INTERVAL)
+  {
+    output_write_index();
+  }
+}
+
+// Write full buffers in the order in which they were filled
+static bool output_drain()
+{
+  bool is_written = false;
+  while (atomic_load_explicit(&buffers[next].state, memory_order_acquire) == OUTPUT_BUFFER_FULL)
+  {
+    output_write_chunk(&buffers[next]);
+    buffers[next].count = 0;
+    buffers[next].dropped = 0;
+    atomic_store_explicit(&buffers[next].state, OUTPUT_BUFFER_FREE, memory_order_release);
+    next = (next + 1) % OUTPUT_BUFFER_COUNT;
+    is_written = true;
+  }
+  return is_written;
+}
+
+static void *output_writer_main(void *_)
+{
+  while (atomic_load_explicit(&is_writer_running, memory_order_acquire))
+  {
+    if (!output_drain())
+    {
+      struct timespec interval = {0, OUTPUT_POLL_INTERVAL_NS};
+      nanosleep(&interval, NULL);
+    }
+  }
+  output_drain();
+  return NULL;
+}
+
+bool output_create(const char *filename, const char *schema, uint32_t size)
+{
+  if (atomic_load(&is_open))
+  {
+    warning("Recording is already running");
+    return false;
+  }
+
+  uint32_t schema_size = strlen(schema) + 1;
+  if (sizeof(output_file_header_t) + schema_size > OUTPUT_HEADER_SIZE || size < sizeof(uint64_t) || size > OUTPUT_CHUNK_SIZE - sizeof(output_chunk_header_t))
+  {
+    error("Invalid recording layout");
+    return false;
+  }
+
+  fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1)
+  {
+    error("Failed to open recording %s", filename);
+    return false;
+  }
+
+  // Reset and prefault the buffers before the producer can see them
+  memset(buffers, 0, sizeof(buffers));
+  record_size = size;
+  capacity = (OUTPUT_CHUNK_SIZE - sizeof(output_chunk_header_t)) / size;
+  active = 0;
+  pending_dropped = 0;
+  atomic_store(&buffers[0].state, OUTPUT_BUFFER_FILLING);
+
+  next = 0;
+  sequence = 0;
+  offset = 0;
+  index_count = 0;
+  memset(&stats, 0, sizeof(stats));
+  start_ns = timer_get_timestamp_ns();
+
+  output_file_header_t *file_header = (output_file_header_t *)header;
+  memset(header, 0, sizeof(header));
+  memcpy(file_header->magic, OUTPUT_FILE_MAGIC, sizeof(file_header->magic));
+  file_header->version = OUTPUT_FILE_VERSION;
+  file_header->header_size = OUTPUT_HEADER_SIZE;
+  file_header->chunk_size = OUTPUT_CHUNK_SIZE;
+  file_header->record_size = size;
+  file_header->index_interval = OUTPUT_INDEX_INTERVAL;
+  file_header->schema_size = schema_size;
+  file_header->start_timestamp_ns = start_ns;
+  memcpy(header + sizeof(output_file_header_t), schema, schema_size);
+  if (!output_write_all(header, sizeof(header)))
+  {
+    error("Failed to write recording header");
+    close(fd);
+    return false;
+  }
+
+  atomic_store(&is_writer_running, true);
+  if (pthread_create(&writer_thread, rt_get_thread_attr(), output_writer_main, NULL) != 0)
+  {
+    error("Failed to start recording writer");
+    close(fd);
+    return false;
+  }
+
+  atomic_store(&is_open, true);
+  print("Recording to %s", filename);
+  return true;
+}
+
+bool output_write(const void *record)
+{
+  if (!atomic_load_explicit(&is_open, memory_order_relaxed))
+  {
+    return false;
+  }
+
+  // Lets output_close() wait for a write in progress
+  atomic_store(&is_producer_busy, true);
+  if (!atomic_load(&is_open))
+  {
+    atomic_store(&is_producer_busy, false);
+    return false;
+  }
+
+  output_buffer_t *buffer = &buffers[active];
+  if (atomic_load_explicit(&buffer->state, memory_order_acquire) != OUTPUT_BUFFER_FILLING)
+  {
+    // The writer has not released this buffer yet
+    if (atomic_load_explicit(&buffer->state, memory_order_acquire) != OUTPUT_BUFFER_FREE)
+    {
+      pending_dropped++;
+      atomic_store(&is_producer_busy, false);
+      return false;
+    }
+    buffer->dropped = pending_dropped;
+    pending_dropped = 0;
+    atomic_store_explicit(&buffer->state, OUTPUT_BUFFER_FILLING, memory_order_relaxed);
+  }
+
+  memcpy(buffer->data + sizeof(output_chunk_header_t) + buffer->count * record_size, record, record_size);
+  buffer->count++;
+
+  // Hand full buffers over to the writer thread
+  if (buffer->count == capacity)
+  {
+    atomic_store_explicit(&buffer->state, OUTPUT_BUFFER_FULL, memory_order_release);
+    active = (active + 1) % OUTPUT_BUFFER_COUNT;
+  }
+
+  atomic_store(&is_producer_busy, false);
+  return true;
+}
+
+void output_close(output_stats_t *result)
+{
+  if (!atomic_exchange(&is_open, false))
+  {
+    return;
+  }
+
+  // Wait for a write in progress, then hand over the partial buffer
+  while (atomic_load(&is_producer_busy))
+    ;
+  output_buffer_t *buffer = &buffers[active];
+  if (atomic_load(&buffer->state) == OUTPUT_BUFFER_FILLING && buffer->count > 0)
+  {
+    atomic_store_explicit(&buffer->state, OUTPUT_BUFFER_FULL, memory_order_release);
+  }
+
+  atomic_store(&is_writer_running, false);
+  pthread_join(writer_thread, NULL);
+
+  // Flush the last index and complete the header
+  stats.dropped_count += pending_dropped;
+  output_write_index();
+  output_file_header_t *file_header = (output_file_header_t *)header;
+  file_header->record_count = stats.record_count;
+  file_header->dropped_count = stats.dropped_count;
+  if (pwrite(fd, header, sizeof(header), 0) != sizeof(header))
+  {
+    error("Failed to complete recording header");
+  }
+  close(fd);
+  fd = -1;
+
+  stats.elapsed_s = (timer_get_timestamp_ns() - start_ns) / 1e9;
+  print("Recording closed: %llu records, %llu dropped, %.2f MB in %.1f s (%.2f MB/s, disk %.1f MB/s)",
+        (unsigned long long)stats.record_count, (unsigned long long)stats.dropped_count,
+        stats.bytes_written / 1e6, stats.elapsed_s, stats.bytes_written / 1e6 / stats.elapsed_s,
+        stats.write_s > 0 ? stats.bytes_written / 1e6 / stats.write_s : 0.0);
+
+  if (result != NULL)
+  {
+    *result = stats;
+  }
+}
+
+bool output_is_open()
+{
+  return atomic_load_explicit(&is_open, memory_order_relaxed);
+}
@@ -0,0 +1,137 @@
+#define _GNU_SOURCE
+
+#include <ports/perf.h>
+#include <ports/log.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+const char *const perf_counter_names[PERF_NUM_COUNTERS] = {
+    "cycles",
+    "instructions",
+    "cache_misses",
+    "branch_misses",
+};
+
+#ifdef __linux__
+
+static const uint64_t perf_configs[PERF_NUM_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+static int perf_event_open(struct perf_event_attr *attr, int group_fd)
+{
+    // Calling thread, any CPU
+    return (int)syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0);
+}
+
+bool perf_open(perf_counters_t *counters)
+{
+    counters->group_fd = -1;
+    counters->num_open = 0;
+
+    int last_errno = 0;
+    for (uint32_t i = 0; i < PERF_NUM_COUNTERS; i++)
+    {
+        counters->fds[i] = -1;
+        counters->slots[i] = -1;
+
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = perf_configs[i];
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = counters->group_fd == -1; // The leader starts the group
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        int fd = perf_event_open(&attr, counters->group_fd);
+        if (fd == -1)
+        {
+            last_errno = errno;
+            continue;
+        }
+        if (counters->group_fd == -1)
+        {
+            counters->group_fd = fd;
+        }
+        counters->fds[i] = fd;
+        counters->slots[i] = (int32_t)counters->num_open++;
+    }
+
+    if (counters->group_fd == -1)
+    {
+        warning("Hardware counters are not available: %s", strerror(last_errno));
+        return false;
+    }
+
+    ioctl(counters->group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counters->group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+bool perf_read(const perf_counters_t *counters, perf_sample_t *sample)
+{
+    // PERF_FORMAT_GROUP: the number of counters, then their values
+    uint64_t buffer[1 + PERF_NUM_COUNTERS];
+    if (counters->group_fd == -1 || read(counters->group_fd, buffer, sizeof(buffer)) <= 0)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < PERF_NUM_COUNTERS; i++)
+    {
+        int32_t slot = counters->slots[i];
+        sample->values[i] = slot >= 0 && (uint64_t)slot < buffer[0] ? buffer[1 + slot] : 0;
+    }
+    return true;
+}
+
+void perf_close(perf_counters_t *counters)
+{
+    for (uint32_t i = 0; i < PERF_NUM_COUNTERS; i++)
+    {
+        if (counters->fds[i] != -1)
+        {
+            close(counters->fds[i]);
+        }
+        counters->fds[i] = -1;
+    }
+    counters->group_fd = -1;
+    counters->num_open = 0;
+}
+
+#else
+
+bool perf_open(perf_counters_t *counters)
+{
+    counters->group_fd = -1;
+    counters->num_open = 0;
+    warning("Hardware counters are not supported on this platform");
+    return false;
+}
+
+bool perf_read(const perf_counters_t *counters, perf_sample_t *sample)
+{
+    (void)counters;
+    (void)sample;
+    return false;
+}
+
+void perf_close(perf_counters_t *counters)
+{
+    counters->group_fd = -1;
+}
+
+#endif
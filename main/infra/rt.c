@@ -0,0 +1,347 @@
+#define _GNU_SOURCE
+
+#include <ports/rt.h>
+#include <ports/log.h>
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+#define RT_RUNTIME_PATH "/proc/sys/kernel/sched_rt_runtime_us"
+
+// Value before rt_disable_throttling(), empty when it did not change it
+static char saved_runtime[32];
+static size_t saved_runtime_length;
+
+static pthread_attr_t thread_attr;
+static pthread_once_t thread_attr_once = PTHREAD_ONCE_INIT;
+
+bool rt_lock_memory()
+{
+    // Keep every current and future page resident, so that the RT threads
+    // never take a major page fault
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        error("Failed to lock memory: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static void rt_init_thread_attr()
+{
+    pthread_attr_init(&thread_attr);
+    pthread_attr_setstacksize(&thread_attr, RT_THREAD_STACK_SIZE);
+}
+
+const pthread_attr_t *rt_get_thread_attr()
+{
+    pthread_once(&thread_attr_once, rt_init_thread_attr);
+    return &thread_attr;
+}
+
+bool rt_verify_memory()
+{
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    char line[128];
+    unsigned long locked_kb = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (sscanf(line, "VmLck: %lu kB", &locked_kb) == 1)
+        {
+            break;
+        }
+    }
+    fclose(file);
+
+    if (locked_kb == 0)
+    {
+        warning("Memory is not locked");
+        return false;
+    }
+    print("Memory locked: %lu kB", locked_kb);
+    return true;
+}
+
+bool rt_disable_throttling()
+{
+    // By default SCHED_FIFO threads may only run 950 ms of every second, so a
+    // spinning context would be stopped for 50 ms each second
+    char value[32] = "unknown";
+    int fd = open(RT_RUNTIME_PATH, O_RDONLY);
+    if (fd != -1)
+    {
+        ssize_t length = read(fd, value, sizeof(value) - 1);
+        value[length > 0 ? length : 0] = '\0';
+        value[strcspn(value, "\n")] = '\0';
+        close(fd);
+    }
+    if (strcmp(value, "-1") == 0)
+    {
+        return true;
+    }
+
+    fd = open(RT_RUNTIME_PATH, O_WRONLY);
+    if (fd != -1 && write(fd, "-1", 2) == 2)
+    {
+        close(fd);
+        if (strcmp(value, "unknown") != 0)
+        {
+            saved_runtime_length = strlen(value);
+            memcpy(saved_runtime, value, saved_runtime_length);
+        }
+        print("RT throttling disabled (sched_rt_runtime_us was %s)", value);
+        return true;
+    }
+    if (fd != -1)
+    {
+        close(fd);
+    }
+    warning("RT throttling is active (sched_rt_runtime_us=%s), spinning contexts will stall", value);
+    return false;
+}
+
+// Only open and write, so that it may be called from a signal handler
+bool rt_restore_throttling()
+{
+    if (saved_runtime_length == 0)
+    {
+        return true;
+    }
+    bool is_restored = false;
+    int fd = open(RT_RUNTIME_PATH, O_WRONLY);
+    if (fd != -1)
+    {
+        is_restored = write(fd, saved_runtime, saved_runtime_length) == (ssize_t)saved_runtime_length;
+        close(fd);
+    }
+    saved_runtime_length = 0;
+    return is_restored;
+}
+
+bool rt_set_affinity(int32_t cpu)
+{
+    if (cpu < 0)
+    {
+        return true;
+    }
+
+#ifdef __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    if (result != 0)
+    {
+        error("Failed to pin thread to CPU %d: %s", cpu, strerror(result));
+        return false;
+    }
+    return true;
+#else
+    warning("Pinning thread to CPU is not supported on this platform");
+    return false;
+#endif
+}
+
+bool rt_set_priority(int32_t priority)
+{
+    if (priority == 0)
+    {
+        return true;
+    }
+
+    struct sched_param param = {.sched_priority = priority};
+    int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (result != 0)
+    {
+        error("Failed to set SCHED_FIFO priority %d: %s", priority, strerror(result));
+        return false;
+    }
+    return true;
+}
+
+void rt_prefault_stack()
+{
+    // Touch one byte per page, the pages stay resident because of mlockall
+    volatile unsigned char stack[RT_STACK_PREFAULT_SIZE];
+    long page_size = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < sizeof(stack); i += page_size)
+    {
+        stack[i] = 0;
+    }
+}
+
+bool rt_verify_thread(int32_t cpu, int32_t priority)
+{
+    bool is_ok = true;
+
+    int policy;
+    struct sched_param param;
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    if (priority > 0 && (policy != SCHED_FIFO || param.sched_priority != priority))
+    {
+        warning("Thread runs with policy %d priority %d instead of SCHED_FIFO %d", policy, param.sched_priority, priority);
+        is_ok = false;
+    }
+
+#ifdef __linux__
+    if (cpu >= 0)
+    {
+        cpu_set_t cpuset;
+        pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        if (CPU_COUNT(&cpuset) != 1 || !CPU_ISSET(cpu, &cpuset))
+        {
+            warning("Thread is not pinned to CPU %d", cpu);
+            is_ok = false;
+        }
+        if (sched_getcpu() != cpu)
+        {
+            warning("Thread runs on CPU %d instead of %d", sched_getcpu(), cpu);
+            is_ok = false;
+        }
+    }
+#endif
+
+    return is_ok;
+}
+
+int32_t rt_get_thread_id()
+{
+    return (int32_t)syscall(SYS_gettid);
+}
+
+void rt_describe_kernel(char *buffer, size_t size)
+{
+    struct utsname name;
+    if (uname(&name) != 0)
+    {
+        snprintf(name.release, sizeof(name.release), "unknown");
+    }
+
+    char cmdline[512] = "unknown";
+    int fd = open("/proc/cmdline", O_RDONLY);
+    if (fd != -1)
+    {
+        ssize_t length = read(fd, cmdline, sizeof(cmdline) - 1);
+        cmdline[length > 0 ? length : 0] = '\0';
+        cmdline[strcspn(cmdline, "\n")] = '\0';
+        close(fd);
+    }
+    snprintf(buffer, size, "%s, cmdline: %s", name.release, cmdline);
+}
+
+static bool rt_read_task_file(int32_t thread_id, const char *name, char *buffer, size_t size)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/%s", thread_id, name);
+
+    // Plain read instead of stdio, so that sampling does not allocate
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+    ssize_t length = read(fd, buffer, size - 1);
+    close(fd);
+    if (length <= 0)
+    {
+        return false;
+    }
+    buffer[length] = '\0';
+    return true;
+}
+
+static uint64_t rt_find_counter(const char *buffer, const char *key)
+{
+    const char *line = strstr(buffer, key);
+    if (line == NULL)
+    {
+        return 0;
+    }
+    line += strlen(key);
+    while (*line == ' ' || *line == '\t' || *line == ':')
+    {
+        line++;
+    }
+    return strtoull(line, NULL, 10);
+}
+
+bool rt_read_thread_stats(int32_t thread_id, rt_thread_stats_t *stats)
+{
+    char buffer[4096];
+    memset(stats, 0, sizeof(rt_thread_stats_t));
+
+    // stat: the fields after the command name, which may contain spaces
+    if (!rt_read_task_file(thread_id, "stat", buffer, sizeof(buffer)))
+    {
+        return false;
+    }
+    char *field = strrchr(buffer, ')');
+    if (field == NULL)
+    {
+        return false;
+    }
+    uint64_t ticks = 0;
+    for (uint32_t index = 3; index <= 39; index++)
+    {
+        field = strchr(field + 1, ' ');
+        if (field == NULL)
+        {
+            break;
+        }
+        switch (index)
+        {
+        case 10:
+            stats->minor_faults = strtoull(field + 1, NULL, 10);
+            break;
+        case 12:
+            stats->major_faults = strtoull(field + 1, NULL, 10);
+            break;
+        case 14:
+        case 15:
+            ticks += strtoull(field + 1, NULL, 10);
+            break;
+        case 39:
+            stats->cpu = (int32_t)strtol(field + 1, NULL, 10);
+            break;
+        default:
+            break;
+        }
+    }
+    stats->cpu_time_ns = ticks * (1000000000 / sysconf(_SC_CLK_TCK));
+
+    if (rt_read_task_file(thread_id, "status", buffer, sizeof(buffer)))
+    {
+        stats->voluntary_switches = rt_find_counter(buffer, "\nvoluntary_ctxt_switches");
+        stats->involuntary_switches = rt_find_counter(buffer, "nonvoluntary_ctxt_switches");
+    }
+
+    // sched needs CONFIG_SCHED_DEBUG
+    if (rt_read_task_file(thread_id, "sched", buffer, sizeof(buffer)))
+    {
+        stats->migrations = rt_find_counter(buffer, "se.nr_migrations");
+    }
+
+    // schedstat has the CPU time in ns, more precise than the ticks of stat
+    unsigned long long run_ns, wait_ns;
+    if (rt_read_task_file(thread_id, "schedstat", buffer, sizeof(buffer)) &&
+        sscanf(buffer, "%llu %llu", &run_ns, &wait_ns) == 2)
+    {
+        stats->cpu_time_ns = run_ns;
+        stats->wait_time_ns = wait_ns;
+    }
+    return true;
+}
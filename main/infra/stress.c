@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+
+#include <ports/stress.h>
+#include <ports/log.h>
+#include <ports/rt.h>
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define STRESS_MEMORY_SIZE (16 * 1024 * 1024)
+#define STRESS_IO_SIZE (1024 * 1024)
+#define STRESS_FILE_FORMAT "stress-%u.tmp"
+
+#define STRESS_KIND_CPU 0
+#define STRESS_KIND_MEMORY 1
+#define STRESS_KIND_IO 2
+#define STRESS_NUM_KINDS 3
+
+static pthread_t threads[STRESS_MAX_THREADS];
+static uint32_t num_threads;
+static atomic_bool is_running;
+
+static void stress_cpu()
+{
+    volatile uint64_t x = 1;
+    while (atomic_load_explicit(&is_running, memory_order_relaxed))
+    {
+        for (uint32_t i = 0; i < 100000; i++)
+        {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+    }
+}
+
+static void stress_memory()
+{
+    uint8_t *buffer = malloc(STRESS_MEMORY_SIZE);
+    if (buffer == NULL)
+    {
+        return;
+    }
+    uint8_t value = 0;
+    while (atomic_load_explicit(&is_running, memory_order_relaxed))
+    {
+        memset(buffer, value++, STRESS_MEMORY_SIZE);
+    }
+    free(buffer);
+}
+
+static void stress_io(uint32_t index)
+{
+    char path[32];
+    snprintf(path, sizeof(path), STRESS_FILE_FORMAT, index);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        warning("Failed to open stress file %s", path);
+        return;
+    }
+
+    uint8_t *buffer = calloc(1, STRESS_IO_SIZE);
+    while (buffer != NULL && atomic_load_explicit(&is_running, memory_order_relaxed))
+    {
+        lseek(fd, 0, SEEK_SET);
+        if (write(fd, buffer, STRESS_IO_SIZE) != STRESS_IO_SIZE)
+        {
+            break;
+        }
+        fsync(fd);
+    }
+    free(buffer);
+    close(fd);
+    unlink(path);
+}
+
+static void *stress_run(void *arg)
+{
+    uint32_t index = (uint32_t)(uintptr_t)arg;
+    switch (index % STRESS_NUM_KINDS)
+    {
+    case STRESS_KIND_CPU:
+        stress_cpu();
+        break;
+    case STRESS_KIND_MEMORY:
+        stress_memory();
+        break;
+    default:
+        stress_io(index);
+        break;
+    }
+    return NULL;
+}
+
+bool stress_start(uint32_t count, const int32_t *excluded_cpus, uint32_t num_excluded)
+{
+    if (num_threads > 0 || count == 0)
+    {
+        return true;
+    }
+    if (count > STRESS_MAX_THREADS)
+    {
+        count = STRESS_MAX_THREADS;
+    }
+
+#ifdef __linux__
+    // Keep the load off the cores under test
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long cpu = 0; cpu < num_cpus && cpu < CPU_SETSIZE; cpu++)
+    {
+        CPU_SET(cpu, &cpuset);
+    }
+    for (uint32_t i = 0; i < num_excluded; i++)
+    {
+        if (excluded_cpus[i] >= 0 && excluded_cpus[i] < CPU_SETSIZE)
+        {
+            CPU_CLR(excluded_cpus[i], &cpuset);
+        }
+    }
+    if (CPU_COUNT(&cpuset) == 0)
+    {
+        warning("No CPU left for the stress threads, running them unpinned");
+    }
+#endif
+
+    atomic_store(&is_running, true);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (pthread_create(&threads[num_threads], rt_get_thread_attr(), stress_run, (void *)(uintptr_t)i) != 0)
+        {
+            error("Failed to create stress thread");
+            break;
+        }
+#ifdef __linux__
+        // The attributes are shared by every thread, so pin once created
+        if (CPU_COUNT(&cpuset) > 0)
+        {
+            pthread_setaffinity_np(threads[num_threads], sizeof(cpu_set_t), &cpuset);
+        }
+#endif
+        num_threads++;
+    }
+
+    print("Started %u stress threads", num_threads);
+    return num_threads == count;
+}
+
+void stress_stop()
+{
+    if (num_threads == 0)
+    {
+        return;
+    }
+
+    atomic_store(&is_running, false);
+    for (uint32_t i = 0; i < num_threads; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    print("Stopped %u stress threads", num_threads);
+    num_threads = 0;
+}
@@ -1,6 +1,8 @@
 #include <ports/timer.h>
 
 #include <time.h>
+#include <stdio.h>
+#include <unistd.h>
 
 bool timer_init()
 {
@@ -21,6 +23,40 @@ uint32_t timer_get_ns()
     return ts.tv_nsec;
 }
 
+uint64_t timer_get_timestamp_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t timer_get_uptime_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t timer_get_process_start_ns()
+{
+    // Field 22 of /proc/self/stat is the start time in clock ticks since boot
+    FILE *file = fopen("/proc/self/stat", "r");
+    if (file == NULL)
+    {
+        return timer_get_timestamp_ns();
+    }
+    unsigned long long start_ticks = 0;
+    int result = fscanf(file, "%*d (%*[^)]) %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu", &start_ticks);
+    fclose(file);
+    if (result != 1)
+    {
+        return timer_get_timestamp_ns();
+    }
+
+    uint64_t start_uptime_ns = start_ticks * (1000000000 / sysconf(_SC_CLK_TCK));
+    return timer_get_timestamp_ns() - (timer_get_uptime_ns() - start_uptime_ns);
+}
+
 void loop_init(loop_t *loop, uint32_t interval_ns)
 {
     loop->interval_ns = interval_ns;
@@ -0,0 +1,787 @@
+#include <ports/web.h>
+#include <ports/log.h>
+
+#include <poll.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define WEB_INPUT_SIZE 16384                // Request headers or one WebSocket frame
+#define WEB_OUTPUT_LIMIT (16 * 1024 * 1024) // Unsent data before a client is dropped
+#define WEB_PATH_SIZE 512
+#define WEB_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+#define WEB_OPCODE_CONTINUATION 0x0
+#define WEB_OPCODE_TEXT 0x1
+#define WEB_OPCODE_BINARY 0x2
+#define WEB_OPCODE_CLOSE 0x8
+#define WEB_OPCODE_PING 0x9
+#define WEB_OPCODE_PONG 0xA
+
+typedef struct
+{
+    int fd; // -1 if unused
+    bool is_websocket;
+    uint8_t input[WEB_INPUT_SIZE];
+    size_t input_length;
+    size_t input_consumed; // Handed out as an event, removed on the next poll
+    uint8_t *output;
+    size_t output_length;
+    size_t output_sent;
+    size_t output_capacity;
+} web_client_t;
+
+static int listen_fd = -1;
+static char root_path[WEB_PATH_SIZE];
+static int32_t watched[WEB_MAX_WATCHED];
+static uint32_t num_watched;
+static web_client_t clients[WEB_MAX_CLIENTS];
+
+// SHA-1 and base64, only used for the Sec-WebSocket-Accept header
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void web_sha1(const uint8_t *data, size_t length, uint8_t digest[20])
+{
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint64_t bit_length = (uint64_t)length * 8;
+    size_t padded_length = ((length + 8) / 64 + 1) * 64;
+
+    for (size_t chunk = 0; chunk < padded_length; chunk += 64)
+    {
+        uint32_t w[80];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint32_t word = 0;
+            for (uint32_t j = 0; j < 4; j++)
+            {
+                size_t index = chunk + i * 4 + j;
+                uint8_t byte = 0;
+                if (index < length)
+                {
+                    byte = data[index];
+                }
+                else if (index == length)
+                {
+                    byte = 0x80;
+                }
+                else if (index >= padded_length - 8)
+                {
+                    byte = (uint8_t)(bit_length >> ((padded_length - 1 - index) * 8));
+                }
+                word = (word << 8) | byte;
+            }
+            w[i] = word;
+        }
+        for (uint32_t i = 16; i < 80; i++)
+        {
+            w[i] = ROTL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (uint32_t i = 0; i < 80; i++)
+        {
+            uint32_t f, k;
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = ROTL(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = ROTL(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        digest[i] = (uint8_t)(h[i / 4] >> (24 - (i % 4) * 8));
+    }
+}
+
+static void web_base64(const uint8_t *data, size_t length, char *output)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t j = 0;
+    for (size_t i = 0; i < length; i += 3)
+    {
+        uint32_t triple = (uint32_t)data[i] << 16;
+        if (i + 1 < length)
+        {
+            triple |= (uint32_t)data[i + 1] << 8;
+        }
+        if (i + 2 < length)
+        {
+            triple |= data[i + 2];
+        }
+        output[j++] = alphabet[(triple >> 18) & 0x3F];
+        output[j++] = alphabet[(triple >> 12) & 0x3F];
+        output[j++] = i + 1 < length ? alphabet[(triple >> 6) & 0x3F] : '=';
+        output[j++] = i + 2 < length ? alphabet[triple & 0x3F] : '=';
+    }
+    output[j] = '\0';
+}
+
+// Client output
+
+static void web_drop(web_client_t *client)
+{
+    if (client->fd != -1)
+    {
+        close(client->fd);
+    }
+    free(client->output);
+    memset(client, 0, sizeof(web_client_t));
+    client->fd = -1;
+}
+
+static bool web_flush(web_client_t *client)
+{
+    while (client->output_sent < client->output_length)
+    {
+        ssize_t sent = send(client->fd, client->output + client->output_sent, client->output_length - client->output_sent, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return true;
+            }
+            return false;
+        }
+        client->output_sent += sent;
+    }
+    client->output_length = 0;
+    client->output_sent = 0;
+    return true;
+}
+
+static bool web_queue(web_client_t *client, const void *data, size_t length)
+{
+    // Compact what has been sent, then grow
+    if (client->output_sent > 0)
+    {
+        memmove(client->output, client->output + client->output_sent, client->output_length - client->output_sent);
+        client->output_length -= client->output_sent;
+        client->output_sent = 0;
+    }
+    if (client->output_length + length > WEB_OUTPUT_LIMIT)
+    {
+        warning("Web client is too slow, dropping it");
+        return false;
+    }
+    if (client->output_length + length > client->output_capacity)
+    {
+        size_t capacity = client->output_capacity > 0 ? client->output_capacity : 4096;
+        while (capacity < client->output_length + length)
+        {
+            capacity *= 2;
+        }
+        uint8_t *output = realloc(client->output, capacity);
+        if (output == NULL)
+        {
+            return false;
+        }
+        client->output = output;
+        client->output_capacity = capacity;
+    }
+    memcpy(client->output + client->output_length, data, length);
+    client->output_length += length;
+    return true;
+}
+
+static void web_send_frame(web_client_t *client, uint8_t opcode, const void *data, size_t length)
+{
+    // Server frames are never masked
+    uint8_t header[10];
+    size_t header_length = 2;
+    header[0] = 0x80 | opcode;
+    if (length < 126)
+    {
+        header[1] = (uint8_t)length;
+    }
+    else if (length < 65536)
+    {
+        header[1] = 126;
+        header[2] = (uint8_t)(length >> 8);
+        header[3] = (uint8_t)length;
+        header_length = 4;
+    }
+    else
+    {
+        header[1] = 127;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            header[2 + i] = (uint8_t)((uint64_t)length >> (56 - i * 8));
+        }
+        header_length = 10;
+    }
+
+    if (!web_queue(client, header, header_length) || !web_queue(client, data, length) || !web_flush(client))
+    {
+        web_drop(client);
+    }
+}
+
+void web_send(int32_t client, bool is_binary, const void *data, size_t length)
+{
+    uint8_t opcode = is_binary ? WEB_OPCODE_BINARY : WEB_OPCODE_TEXT;
+    if (client != WEB_BROADCAST)
+    {
+        if (client >= 0 && client < WEB_MAX_CLIENTS && clients[client].is_websocket)
+        {
+            web_send_frame(&clients[client], opcode, data, length);
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < WEB_MAX_CLIENTS; i++)
+    {
+        if (clients[i].fd != -1 && clients[i].is_websocket)
+        {
+            web_send_frame(&clients[i], opcode, data, length);
+        }
+    }
+}
+
+// HTTP
+
+static const char *web_content_type(const char *path)
+{
+    const char *extension = strrchr(path, '.');
+    if (extension == NULL)
+    {
+        return "application/octet-stream";
+    }
+    if (strcmp(extension, ".html") == 0)
+    {
+        return "text/html; charset=utf-8";
+    }
+    if (strcmp(extension, ".js") == 0)
+    {
+        return "text/javascript; charset=utf-8";
+    }
+    if (strcmp(extension, ".css") == 0)
+    {
+        return "text/css; charset=utf-8";
+    }
+    if (strcmp(extension, ".json") == 0)
+    {
+        return "application/json";
+    }
+    if (strcmp(extension, ".svg") == 0)
+    {
+        return "image/svg+xml";
+    }
+    if (strcmp(extension, ".png") == 0)
+    {
+        return "image/png";
+    }
+    if (strcmp(extension, ".ico") == 0)
+    {
+        return "image/x-icon";
+    }
+    if (strcmp(extension, ".woff2") == 0)
+    {
+        return "font/woff2";
+    }
+    return "application/octet-stream";
+}
+
+// Value of a request header, case-insensitive name, copied into value
+static bool web_header(const char *request, const char *name, char *value, size_t size)
+{
+    size_t name_length = strlen(name);
+    for (const char *line = strstr(request, "\r\n"); line != NULL; line = strstr(line, "\r\n"))
+    {
+        line += 2;
+        if (strncasecmp(line, name, name_length) == 0 && line[name_length] == ':')
+        {
+            const char *start = line + name_length + 1;
+            while (*start == ' ')
+            {
+                start++;
+            }
+            size_t length = strcspn(start, "\r\n");
+            if (length >= size)
+            {
+                length = size - 1;
+            }
+            memcpy(value, start, length);
+            value[length] = '\0';
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool web_respond_status(web_client_t *client, const char *status)
+{
+    char response[256];
+    int length = snprintf(response, sizeof(response), "HTTP/1.1 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", status);
+    web_queue(client, response, length);
+    web_flush(client);
+    return false;
+}
+
+static bool web_read_file(const char *path, uint8_t **data, size_t *length)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        close(fd);
+        return false;
+    }
+
+    *length = info.st_size;
+    *data = malloc(*length > 0 ? *length : 1);
+    size_t total = 0;
+    while (*data != NULL && total < *length)
+    {
+        ssize_t count = read(fd, *data + total, *length - total);
+        if (count <= 0)
+        {
+            break;
+        }
+        total += count;
+    }
+    close(fd);
+    if (*data == NULL || total != *length)
+    {
+        free(*data);
+        return false;
+    }
+    return true;
+}
+
+static bool web_serve_file(web_client_t *client, const char *request, const char *target)
+{
+    char path[WEB_PATH_SIZE + 16];
+    size_t target_length = strcspn(target, "? ");
+    if (target_length == 0 || target[0] != '/' || target_length >= WEB_PATH_SIZE || strstr(target, "..") != NULL)
+    {
+        return web_respond_status(client, "400 Bad Request");
+    }
+    snprintf(path, sizeof(path), "%s%.*s", root_path, (int)target_length, target);
+
+    struct stat info;
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode))
+    {
+        strncat(path, path[strlen(path) - 1] == '/' ? "index.html" : "/index.html", sizeof(path) - strlen(path) - 1);
+    }
+    if (stat(path, &info) != 0)
+    {
+        snprintf(path, sizeof(path), "%s/index.html", root_path);
+    }
+
+    // Prefer the precompressed variants that the client accepts
+    char accept_encoding[128] = "";
+    web_header(request, "Accept-Encoding", accept_encoding, sizeof(accept_encoding));
+    const char *encodings[] = {"br", "gzip"};
+    const char *extensions[] = {".br", ".gz"};
+    const char *encoding = NULL;
+    uint8_t *data = NULL;
+    size_t length = 0;
+    for (uint32_t i = 0; i < 2 && encoding == NULL; i++)
+    {
+        char compressed[sizeof(path) + 4];
+        snprintf(compressed, sizeof(compressed), "%s%s", path, extensions[i]);
+        if (strstr(accept_encoding, encodings[i]) != NULL && web_read_file(compressed, &data, &length))
+        {
+            encoding = encodings[i];
+        }
+    }
+    if (encoding == NULL && !web_read_file(path, &data, &length))
+    {
+        return web_respond_status(client, "404 Not Found");
+    }
+
+    char header[512];
+    int header_length = snprintf(header, sizeof(header),
+                                 "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s%s%sVary: Accept-Encoding\r\nCache-Control: no-cache\r\n\r\n",
+                                 web_content_type(path), length, encoding != NULL ? "Content-Encoding: " : "",
+                                 encoding != NULL ? encoding : "", encoding != NULL ? "\r\n" : "");
+    bool is_queued = web_queue(client, header, header_length) && web_queue(client, data, length);
+    free(data);
+    return is_queued && web_flush(client);
+}
+
+static bool web_upgrade(web_client_t *client, const char *request)
+{
+    char key[128];
+    if (!web_header(request, "Sec-WebSocket-Key", key, sizeof(key)))
+    {
+        return web_respond_status(client, "400 Bad Request");
+    }
+
+    char input[sizeof(key) + sizeof(WEB_GUID)];
+    uint8_t digest[20];
+    char accept[32];
+    int input_length = snprintf(input, sizeof(input), "%s%s", key, WEB_GUID);
+    web_sha1((const uint8_t *)input, input_length, digest);
+    web_base64(digest, sizeof(digest), accept);
+
+    char response[256];
+    int length = snprintf(response, sizeof(response),
+                          "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n",
+                          accept);
+    client->is_websocket = true;
+    return web_queue(client, response, length) && web_flush(client);
+}
+
+// Handle one complete request at the start of the input. Returns the
+// number of bytes consumed, 0 if incomplete, or -1 to drop the client.
+static ssize_t web_handle_request(web_client_t *client, web_event_t *event, int32_t index)
+{
+    client->input[client->input_length] = '\0';
+    char *end = strstr((char *)client->input, "\r\n\r\n");
+    if (end == NULL)
+    {
+        return client->input_length >= WEB_INPUT_SIZE - 1 ? -1 : 0;
+    }
+    *end = '\0';
+    ssize_t consumed = end + 4 - (char *)client->input;
+
+    char *request = (char *)client->input;
+    char upgrade[32] = "";
+    if (web_header(request, "Upgrade", upgrade, sizeof(upgrade)) && strcasecmp(upgrade, "websocket") == 0)
+    {
+        if (!web_upgrade(client, request))
+        {
+            return -1;
+        }
+        event->type = WEB_EVENT_OPEN;
+        event->client = index;
+        return consumed;
+    }
+
+    if (strncmp(request, "GET ", 4) != 0)
+    {
+        web_respond_status(client, "405 Method Not Allowed");
+        return -1;
+    }
+    return web_serve_file(client, request, request + 4) ? consumed : -1;
+}
+
+// Handle one complete frame at the start of the input, same return values
+static ssize_t web_handle_frame(web_client_t *client, web_event_t *event, int32_t index)
+{
+    uint8_t *input = client->input;
+    if (client->input_length < 2)
+    {
+        return 0;
+    }
+
+    uint8_t opcode = input[0] & 0x0F;
+    bool is_masked = (input[1] & 0x80) != 0;
+    uint64_t length = input[1] & 0x7F;
+    size_t header_length = 2;
+    if (length == 126)
+    {
+        header_length = 4;
+        if (client->input_length < header_length)
+        {
+            return 0;
+        }
+        length = ((uint64_t)input[2] << 8) | input[3];
+    }
+    else if (length == 127)
+    {
+        header_length = 10;
+        if (client->input_length < header_length)
+        {
+            return 0;
+        }
+        length = 0;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            length = (length << 8) | input[2 + i];
+        }
+    }
+
+    // Clients must mask, and fragmented messages are not used by the UI
+    if (!is_masked || (input[0] & 0x80) == 0 || length > WEB_INPUT_SIZE - header_length - 4)
+    {
+        return -1;
+    }
+    if (client->input_length < header_length + 4 + length)
+    {
+        return 0;
+    }
+
+    uint8_t *mask = input + header_length;
+    uint8_t *payload = mask + 4;
+    for (uint64_t i = 0; i < length; i++)
+    {
+        payload[i] ^= mask[i % 4];
+    }
+    ssize_t consumed = header_length + 4 + length;
+
+    switch (opcode)
+    {
+    case WEB_OPCODE_TEXT:
+    case WEB_OPCODE_BINARY:
+        event->type = WEB_EVENT_MESSAGE;
+        event->client = index;
+        event->is_binary = opcode == WEB_OPCODE_BINARY;
+        event->data = payload;
+        event->length = length;
+        return consumed;
+    case WEB_OPCODE_PING:
+        web_send_frame(client, WEB_OPCODE_PONG, payload, length);
+        return client->fd == -1 ? -1 : consumed;
+    case WEB_OPCODE_PONG:
+        return consumed;
+    case WEB_OPCODE_CLOSE:
+        web_send_frame(client, WEB_OPCODE_CLOSE, payload, length < 2 ? length : 2);
+        return -1;
+    default:
+        return -1;
+    }
+}
+
+// Handle buffered input of every client until one produces an event
+static bool web_process_input(web_event_t *event)
+{
+    for (int32_t i = 0; i < WEB_MAX_CLIENTS; i++)
+    {
+        web_client_t *client = &clients[i];
+        if (client->fd == -1)
+        {
+            continue;
+        }
+
+        // Drop what the previous event handed out
+        if (client->input_consumed > 0)
+        {
+            memmove(client->input, client->input + client->input_consumed, client->input_length - client->input_consumed);
+            client->input_length -= client->input_consumed;
+            client->input_consumed = 0;
+        }
+
+        while (client->fd != -1 && client->input_length > 0)
+        {
+            event->type = WEB_EVENT_TIMEOUT;
+            ssize_t consumed = client->is_websocket ? web_handle_frame(client, event, i) : web_handle_request(client, event, i);
+            if (consumed < 0)
+            {
+                web_drop(client);
+                break;
+            }
+            if (consumed == 0)
+            {
+                break;
+            }
+            if (event->type != WEB_EVENT_TIMEOUT)
+            {
+                client->input_consumed = consumed;
+                return true;
+            }
+            memmove(client->input, client->input + consumed, client->input_length - consumed);
+            client->input_length -= consumed;
+        }
+    }
+    return false;
+}
+
+static void web_accept()
+{
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd == -1)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < WEB_MAX_CLIENTS; i++)
+    {
+        if (clients[i].fd == -1)
+        {
+            // Messages are small and latency matters more than packet count
+            int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            clients[i].fd = fd;
+            return;
+        }
+    }
+    warning("Too many web clients");
+    close(fd);
+}
+
+bool web_open(uint16_t port, const char *root)
+{
+    for (uint32_t i = 0; i < WEB_MAX_CLIENTS; i++)
+    {
+        clients[i].fd = -1;
+    }
+    snprintf(root_path, sizeof(root_path), "%s", root);
+
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd == -1)
+    {
+        error("Failed to create web socket: %s", strerror(errno));
+        return false;
+    }
+    int enable = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listen_fd, 16) != 0)
+    {
+        error("Failed to listen on port %u: %s", port, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    print("Web server listening on port %u", port);
+    return true;
+}
+
+bool web_watch(int32_t fd)
+{
+    if (num_watched >= WEB_MAX_WATCHED)
+    {
+        return false;
+    }
+    watched[num_watched++] = fd;
+    return true;
+}
+
+bool web_poll(web_event_t *event, int32_t timeout_ms)
+{
+    memset(event, 0, sizeof(web_event_t));
+    if (listen_fd == -1)
+    {
+        return false;
+    }
+    if (web_process_input(event))
+    {
+        return true;
+    }
+
+    // Listener, watched descriptors, then clients
+    struct pollfd fds[1 + WEB_MAX_WATCHED + WEB_MAX_CLIENTS];
+    nfds_t num_fds = 0;
+    fds[num_fds++] = (struct pollfd){.fd = listen_fd, .events = POLLIN};
+    for (uint32_t i = 0; i < num_watched; i++)
+    {
+        fds[num_fds++] = (struct pollfd){.fd = watched[i], .events = POLLIN};
+    }
+    for (uint32_t i = 0; i < WEB_MAX_CLIENTS; i++)
+    {
+        short events = POLLIN;
+        if (clients[i].output_length > clients[i].output_sent)
+        {
+            events |= POLLOUT;
+        }
+        fds[num_fds++] = (struct pollfd){.fd = clients[i].fd, .events = events};
+    }
+
+    if (poll(fds, num_fds, timeout_ms) < 0)
+    {
+        return errno == EINTR;
+    }
+
+    if (fds[0].revents & POLLIN)
+    {
+        web_accept();
+    }
+    for (uint32_t i = 0; i < WEB_MAX_CLIENTS; i++)
+    {
+        web_client_t *client = &clients[i];
+        short revents = fds[1 + num_watched + i].revents;
+        if (client->fd == -1 || revents == 0)
+        {
+            continue;
+        }
+        if ((revents & POLLOUT) && !web_flush(client))
+        {
+            web_drop(client);
+            continue;
+        }
+        if (revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            ssize_t count = recv(client->fd, client->input + client->input_length, WEB_INPUT_SIZE - 1 - client->input_length, 0);
+            if (count <= 0 && !(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+            {
+                web_drop(client);
+                continue;
+            }
+            if (count > 0)
+            {
+                client->input_length += count;
+            }
+        }
+    }
+    if (web_process_input(event))
+    {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < num_watched; i++)
+    {
+        if (fds[1 + i].revents & POLLIN)
+        {
+            event->type = WEB_EVENT_READABLE;
+            event->fd = watched[i];
+            return true;
+        }
+    }
+    return true;
+}
+
+void web_close()
+{
+    for (uint32_t i = 0; i < WEB_MAX_CLIENTS; i++)
+    {
+        if (clients[i].fd != -1)
+        {
+            web_drop(&clients[i]);
+        }
+    }
+    if (listen_fd != -1)
+    {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+}
@@ -1,8 +1,10 @@
 #define _GNU_SOURCE
 
 #include <math.h>
+#include <time.h>
 #include <stdio.h>
 #include <sched.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <signal.h>
 #include <string.h>
@@ -14,67 +16,148 @@
 #include <sys/mman.h>
 
 #include <em.h>
+#include <boot.h>
 #include <state.h>
-
+#include <trace.h>
+#include <command.h>
+#include <parameter.h>
+#include <profile.h>
+#include <telemetry.h>
+#include <topology.h>
+#include <ui.h>
+
+#include <ports/rt.h>
 #include <ports/dev.h>
+#include <ports/arena.h>
 #include <ports/log.h>
 #include <ports/timer.h>
 #include <ports/motor.h>
+#include <ports/notify.h>
+#include <ports/output.h>
+#include <ports/stress.h>
 
 #include <services/imu.h>
 #include <services/line.h>
 #include <services/clock.h>
 #include <services/drive.h>
+#include <services/health.h>
+#include <services/jitter.h>
 #include <services/music.h>
 #include <services/vsense.h>
 #include <services/sensor.h>
+#include <services/publish.h>
 #include <services/encoder.h>
 
 #define SHM_NAME "/state"
 #define SHM_SIZE 4096
 
-state_t *state;
+#define TELEMETRY_SHM_NAME "/telemetry"
+#define COMMAND_SHM_NAME "/command"
+#define PARAMETER_SHM_NAME "/parameters"
+#define PARAMETER_FILE "parameters.txt"
+#define TRACE_FILE "trace.json"
+#define PROFILE_FILE "profile.csv"
+#define JITTER_REPORT_FILE "jitter-report.txt"
+#define RECORDING_DIRECTORY "recordings"
+#define TOPOLOGY_FILE "../config/topology.conf"
+#define BOOT_TIMEOUT_MS 10000
+#define UI_PORT 80
+#define UI_ROOT "../frontend/dist"
+
+#define STATE_PUBLISH_MAX_RATE_HZ 200
+
+INSTANCE_LOCAL state_t *state;
+INSTANCE_LOCAL telemetry_t *telemetry;
+command_queue_t *command_queue;
+INSTANCE_LOCAL parameter_table_t *parameters;
+
+notify_t state_notify;
+notify_t command_notify = -1;
+
+// The main thread reads parameters through a snapshot, as the services do.
+// An odd sequence is never a settled one, so the first sync copies.
+static parameters_t params;
+static uint32_t params_sequence = 1;
+
+// Set by the signal handler, which only wakes the main thread up. The
+// shutdown runs there, where it may take locks and join threads.
+static volatile sig_atomic_t is_exit_requested = 0;
 
 em_context_t em_context;
 
-em_local_context_t em_local_1;
-em_local_context_t em_local_2;
-em_local_context_t em_local_3;
-
-static void pin_thread_to_cpu(int cpu)
+topology_t topology;
+em_local_context_t em_locals[TOPOLOGY_MAX_CONTEXTS];
+
+// Services that the topology can place, looked up by name
+static em_service_t *services[] = {
+    &service_clock,
+    &service_publish,
+    &service_health,
+    &service_encoder,
+    &service_music,
+    &service_sensor,
+    &service_sensor_low,
+    &service_sensor_high,
+    &service_line,
+    &service_vsense,
+    &service_drive,
+};
+
+static void wait_context(const topology_context_t *context)
 {
-#ifdef __linux__
-    cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);
-    CPU_SET(cpu, &cpuset);
-    pthread_t thread = pthread_self();
-    pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
-#else
-    print("Warning: Pinning thread to CPU is not supported on this platform");
-#endif
+    switch (context->wait)
+    {
+    case TOPOLOGY_WAIT_SLEEP:
+        usleep(context->wait_us);
+        break;
+    case TOPOLOGY_WAIT_YIELD:
+        sched_yield();
+        break;
+    default:
+        break;
+    }
 }
 
-static void thread_1(void *_)
+static void *run_context(void *arg)
 {
-    while (em_update(&em_local_1))
+    uint32_t index = (uint32_t)(uintptr_t)arg;
+    const topology_context_t *context = &topology.contexts[index];
+    uint64_t begin_ns = timer_get_timestamp_ns();
+
+    // Apply and verify the scheduling before any service runs
+    rt_set_affinity(context->cpu);
+    rt_set_priority(context->priority);
+    rt_prefault_stack();
+    if (rt_verify_thread(context->cpu, context->priority))
     {
-        usleep(10000); // Sleep for 10ms
+        print("Context %s running (cpu %d, priority %d)", context->name, context->cpu, context->priority);
+    }
+    trace_set_thread_name(context->name);
+    profile_set_thread_name(context->name);
+    jitter_set_thread_name(context->name);
+    if (context->priority > 0)
+    {
+        arena_mark_rt_thread();
     }
-}
 
-static void thread_2(void *_)
-{
-    pin_thread_to_cpu(2);
-    EM_LOOP(&em_local_2);
-}
+    // The first update runs the setup phase, the next one is the first loop
+    em_update(&em_locals[index]);
+    boot_context_ready(context->name, begin_ns);
+    health_register_thread(index, context->name, context->cpu >= 0);
 
-static void thread_3(void *_)
-{
-    pin_thread_to_cpu(3);
-    EM_LOOP(&em_local_3);
+    if (context->wait == TOPOLOGY_WAIT_SPIN)
+    {
+        EM_LOOP(&em_locals[index]);
+        return NULL;
+    }
+    while (em_update(&em_locals[index]))
+    {
+        wait_context(context);
+    }
+    return NULL;
 }
 
-static void handle_exit()
+static void stop_devices()
 {
     // Disable motor
     motor_enable(false);
@@ -91,9 +174,33 @@ static void handle_exit()
     {
         dev_gpio_set_mode(i, GPIO_FSEL_IN);
     }
+}
+
+static void handle_exit(int number)
+{
+    (void)number;
+
+    // A second signal exits at once, in case the shutdown hangs
+    if (is_exit_requested)
+    {
+        stop_devices();
+        rt_restore_throttling();
+        _exit(1);
+    }
 
-    // Exit program
-    exit(0);
+    int saved_errno = errno;
+    is_exit_requested = 1;
+    notify_signal(command_notify);
+    errno = saved_errno;
+}
+
+// After a fault nothing can be shut down in order, only make the hardware
+// safe. The handler is reset on entry, so raising again terminates.
+static void handle_fault(int number)
+{
+    stop_devices();
+    rt_restore_throttling();
+    raise(number);
 }
 
 static void init_signal()
@@ -105,12 +212,15 @@ static void init_signal()
     sigaction(SIGHUP, &action, NULL);
     sigaction(SIGINT, &action, NULL);
     sigaction(SIGQUIT, &action, NULL);
+    sigaction(SIGPIPE, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    action.sa_handler = handle_fault;
+    action.sa_flags = SA_RESETHAND;
     sigaction(SIGILL, &action, NULL);
     sigaction(SIGABRT, &action, NULL);
     sigaction(SIGFPE, &action, NULL);
     sigaction(SIGSEGV, &action, NULL);
-    sigaction(SIGPIPE, &action, NULL);
-    sigaction(SIGTERM, &action, NULL);
 }
 
 static void init_ports()
@@ -154,25 +264,75 @@ static void init_cpu_governor()
     }
 }
 
+static em_service_t *find_service(const char *name)
+{
+    for (uint32_t i = 0; i < sizeof(services) / sizeof(services[0]); i++)
+    {
+        if (strcmp(services[i]->name, name) == 0)
+        {
+            return services[i];
+        }
+    }
+    return NULL;
+}
+
 static void init_em()
 {
+    trace_init();
     em_init_context(&em_context);
 
-    em_init_local_context(&em_local_1, &em_context); // Timer
-    em_init_local_context(&em_local_2, &em_context); // Encoder
-    em_init_local_context(&em_local_3, &em_context); // Sensor & Drive
+    if (!topology_load(&topology, TOPOLOGY_FILE))
+    {
+        error("Invalid topology");
+        exit(1);
+    }
+
+    for (uint32_t i = 0; i < topology.num_contexts; i++)
+    {
+        topology_context_t *context = &topology.contexts[i];
+        em_init_local_context(&em_locals[i], &em_context);
+        for (uint32_t j = 0; j < context->num_services; j++)
+        {
+            em_service_t *service = find_service(context->services[j]);
+            if (service == NULL)
+            {
+                error("Unknown service %s in context %s", context->services[j], context->name);
+                exit(1);
+            }
+            em_add_service(&em_locals[i], service);
+            if (service->arena_size > 0 && !arena_declare(service->name, service->arena_size))
+            {
+                exit(1);
+            }
+        }
 
-    em_add_service(&em_local_1, &service_clock);
+        // Every context measures its own jitter in the jitter mode
+        em_add_service(&em_locals[i], &service_jitter);
+    }
 
-    em_add_service(&em_local_2, &service_encoder);
-    em_add_service(&em_local_2, &service_music);
+    publish_set_max_rate(STATE_PUBLISH_MAX_RATE_HZ);
+}
 
-    em_add_service(&em_local_3, &service_sensor);
-    em_add_service(&em_local_3, &service_sensor_low);
-    em_add_service(&em_local_3, &service_sensor_high);
-    em_add_service(&em_local_3, &service_line);
-    em_add_service(&em_local_3, &service_vsense);
-    em_add_service(&em_local_3, &service_drive);
+static void init_arena()
+{
+    // Quotas were declared by the services placed in init_em()
+    if (!arena_init(true))
+    {
+        error("Error creating arena");
+        exit(1);
+    }
+}
+
+static void init_rt()
+{
+    // Lock before the big shared memory mappings, which are then locked too
+    if (rt_lock_memory())
+    {
+        rt_verify_memory();
+    }
+
+    // The spinning contexts never give up their cores
+    rt_disable_throttling();
 }
 
 static void init_state()
@@ -198,60 +358,195 @@ static void init_state()
 
     // Initialize state
     memset(state, 0, SHM_SIZE);
+    state->state = EM_STATE_IDLE;
+
+    // Create state change notification channel for the UI server
+    if (!notify_create(&state_notify))
+    {
+        error("Error creating state notification");
+        exit(1);
+    }
 
     print("State initialized");
 }
 
-static void init_ui_server(int *pipe_miso, int *pipe_simo, pid_t *pid)
+static void init_telemetry()
+{
+    // Open shared memory
+    int shm_fd = shm_open(TELEMETRY_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (shm_fd == -1)
+    {
+        error("Error creating telemetry shared memory");
+        exit(1);
+    }
+
+    // Truncate shared memory to size
+    ftruncate(shm_fd, sizeof(telemetry_t));
+
+    // Map shared memory to process
+    telemetry = (telemetry_t *)mmap(NULL, sizeof(telemetry_t), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (telemetry == MAP_FAILED)
+    {
+        error("Error mapping telemetry shared memory");
+        exit(1);
+    }
+
+    // Prefault the whole ring so that the RT services never page fault on it
+    memset(telemetry, 0, sizeof(telemetry_t));
+    telemetry_init(telemetry);
+
+    print("Telemetry initialized");
+}
+
+static void init_commands()
+{
+    // Open shared memory
+    int shm_fd = shm_open(COMMAND_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (shm_fd == -1)
+    {
+        error("Error creating command shared memory");
+        exit(1);
+    }
+
+    // Truncate shared memory to size
+    ftruncate(shm_fd, sizeof(command_queue_t));
+
+    // Map shared memory to process
+    command_queue = (command_queue_t *)mmap(NULL, sizeof(command_queue_t), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (command_queue == MAP_FAILED)
+    {
+        error("Error mapping command shared memory");
+        exit(1);
+    }
+
+    memset(command_queue, 0, sizeof(command_queue_t));
+    command_init(command_queue);
+
+    // The UI server signals this after it has pushed commands
+    if (!notify_create(&command_notify))
+    {
+        error("Error creating command notification");
+        exit(1);
+    }
+
+    print("Commands initialized");
+}
+
+static void init_parameters()
+{
+    // Open shared memory
+    int shm_fd = shm_open(PARAMETER_SHM_NAME, O_CREAT | O_RDWR, 0666);
+    if (shm_fd == -1)
+    {
+        error("Error creating parameter shared memory");
+        exit(1);
+    }
+
+    // Truncate shared memory to size
+    ftruncate(shm_fd, sizeof(parameter_table_t));
+
+    // Map shared memory to process
+    parameters = (parameter_table_t *)mmap(NULL, sizeof(parameter_table_t), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (parameters == MAP_FAILED)
+    {
+        error("Error mapping parameter shared memory");
+        exit(1);
+    }
+
+    memset(parameters, 0, sizeof(parameter_table_t));
+    parameter_init(parameters);
+
+    // Override the defaults with the last saved values, if any
+    parameter_load(PARAMETER_FILE);
+
+    print("Parameters initialized");
+}
+
+#ifdef UI_SERVER_NATIVE
+static ui_config_t ui_config;
+
+static void init_ui_server(pid_t *ui_pid)
+{
+    // [0] is read, [1] is write
+    int pipe_simo[2]; // log text to the server thread
+    pthread_t ui_thread;
+
+    // Create pipe, read by the server thread without blocking
+    pipe(pipe_simo);
+    int flags = fcntl(pipe_simo[0], F_GETFL, 0);
+    fcntl(pipe_simo[0], F_SETFL, flags | O_NONBLOCK);
+
+    ui_config = (ui_config_t){
+        .port = UI_PORT,
+        .root = UI_ROOT,
+        .log_fd = pipe_simo[0],
+        .console_fd = dup(1),
+        .state_notify = state_notify,
+        .command_notify = command_notify,
+        .commands = command_queue,
+    };
+
+    // Redirect stdout, stderr to pipe_simo[1]
+    dup2(pipe_simo[1], 1);
+    dup2(pipe_simo[1], 2);
+
+    // Default attributes, so the server is an ordinary thread that the
+    // scheduler keeps off the isolated cores
+    if (pthread_create(&ui_thread, rt_get_thread_attr(), ui_run, &ui_config) != 0)
+    {
+        error("Error starting UI server");
+        exit(1);
+    }
+    pthread_detach(ui_thread);
+
+    // Print state offsets, like for the Node server
+    char buffer[1024];
+    state_print_offsets(state, buffer);
+    print("%s", buffer);
+
+    // No process to kill on exit
+    *ui_pid = 0;
+}
+#else
+static void init_ui_server(pid_t *ui_pid)
 {
     // [0] is read, [1] is write
-    int pipe_miso[2]; // master in, slave out (read from server)
-    int pipe_simo[2]; // slave in, master out (write to server)
+    int pipe_simo[2]; // slave in, master out (log text to server)
     pid_t pid;
 
-    // Create pipes
-    pipe(pipe_miso);
+    // Create pipe
     pipe(pipe_simo);
 
     pid = fork();
     if (pid > 0)
     // Parent processs
     {
-        // Close unused pipe ends
+        // Close unused pipe end
         close(pipe_simo[0]); // slave in
-        close(pipe_miso[1]); // slave out
-
-        // Set blocking mode for read
-        int flags = fcntl(pipe_miso[0], F_GETFL, 0);
-        fcntl(pipe_miso[0], F_SETFL, flags & ~O_NONBLOCK);
 
-        // Redirect stdin, stdout, stderr to pipe_miso[0], pipe_simo[1], pipe_simo[1]
-        dup2(pipe_miso[0], 0);
+        // Redirect stdout, stderr to pipe_simo[1]
         dup2(pipe_simo[1], 1);
         dup2(pipe_simo[1], 2);
 
         // Print state offsets
         char buffer[1024];
         state_print_offsets(state, buffer);
-        print(buffer);
+        print("%s", buffer);
 
-        *pipe_miso = pipe_miso[0];
-        *pipe_simo = pipe_simo[1];
-        *pid = pid;
+        *ui_pid = pid;
     }
     else if (pid == 0)
     // Child process
     {
-        // Close unused pipe ends
-        close(pipe_miso[0]); // master in
+        // Close unused pipe end
         close(pipe_simo[1]); // master out
 
         // Set non-blocking mode for read
         int flags = fcntl(pipe_simo[0], F_GETFL, 0);
         fcntl(pipe_simo[0], F_SETFL, flags | O_NONBLOCK);
 
-        char fd_str[10];
-        sprintf(fd_str, "%d,%d", pipe_simo[0], pipe_miso[1]); // (read, write)
+        char fd_str[32];
+        sprintf(fd_str, "%d,%d,%d", pipe_simo[0], state_notify, command_notify); // (log, state, command)
 
         // Start UI server
         execlp("node", "node", "../server/app.js", fd_str, (char *)NULL);
@@ -265,119 +560,244 @@ static void init_ui_server(int *pipe_miso, int *pipe_simo, pid_t *pid)
         exit(1);
     }
 }
+#endif
+
+// Device setup does not depend on anything else, so it runs concurrently
+// with the rest of the initialisation
+static void *init_devices(void *_)
+{
+    BOOT_STEP("ports", init_ports());
+    BOOT_STEP("cpu_governor", init_cpu_governor());
+    return NULL;
+}
 
 static void init_threads(pthread_t *threads)
 {
-    if (pthread_create(&threads[0], NULL, (void *)thread_1, NULL) != 0)
+    // Larger stacks than the other threads, the services run on them. Still
+    // smaller than the default 8 MiB, as every page of them is locked in
+    // memory.
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, RT_STACK_SIZE);
+
+    for (uint32_t i = 0; i < topology.num_contexts; i++)
     {
-        print("Error creating thread 1");
-        exit(1);
-    }
-    if (pthread_create(&threads[1], NULL, (void *)thread_2, NULL) != 0)
-    {
-        print("Error creating thread 2");
-        exit(1);
-    }
-    if (pthread_create(&threads[2], NULL, (void *)thread_3, NULL) != 0)
-    {
-        print("Error creating thread 3");
-        exit(1);
+        if (pthread_create(&threads[i], &attr, run_context, (void *)(uintptr_t)i) != 0)
+        {
+            error("Error creating context %s", topology.contexts[i].name);
+            exit(1);
+        }
     }
+    pthread_attr_destroy(&attr);
 }
 
-static void handle_message(char *message)
+static bool start_recording()
 {
-    if (strcmp(message, "quit") == 0)
-    {
-        print("You cannot quit in this version.");
-    }
-    else if (strcmp(message, "cali_low") == 0)
-    {
-        em_set_state(&em_context, EM_STATE_CALI_LOW);
-    }
-    else if (strcmp(message, "cali_high") == 0)
+    if (mkdir_recursive(RECORDING_DIRECTORY, 0755) != 0)
     {
-        em_set_state(&em_context, EM_STATE_CALI_HIGH);
+        return false;
     }
-    else if (strcmp(message, "cali_save") == 0)
-    {
-        em_set_state(&em_context, EM_STATE_IDLE);
-    }
-    else if (strcmp(message, "drive") == 0)
+
+    // One file per recording, named after the local time
+    char filename[64];
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    strftime(filename, sizeof(filename), RECORDING_DIRECTORY "/%Y%m%d-%H%M%S.rec", &local);
+
+    return output_create(filename, telemetry_schema, sizeof(telemetry_record_t));
+}
+
+static void set_state(em_state_t new_state)
+{
+    em_state_t old_state = em_context.curr_state;
+    parameter_sync(&params, &params_sequence);
+    if (new_state == EM_STATE_JITTER && old_state != EM_STATE_JITTER)
     {
-        em_set_state(&em_context, EM_STATE_DRIVE);
+        // Load the other cores, the pinned ones are under test
+        int32_t pinned_cpus[TOPOLOGY_MAX_CONTEXTS];
+        for (uint32_t i = 0; i < topology.num_contexts; i++)
+        {
+            pinned_cpus[i] = topology.contexts[i].cpu;
+        }
+        stress_start((uint32_t)params.jitter_stress_threads, pinned_cpus, topology.num_contexts);
     }
-    else if (strcmp(message, "idle") == 0)
+
+    em_set_state(&em_context, new_state);
+    state->state = new_state;
+
+    if (old_state == EM_STATE_JITTER && new_state != EM_STATE_JITTER)
     {
-        em_set_state(&em_context, EM_STATE_IDLE);
+        stress_stop();
+        jitter_write_report(JITTER_REPORT_FILE, (uint32_t)params.jitter_stress_threads);
     }
-    else
+}
+
+static int32_t handle_command(command_t *command)
+{
+    switch (command->type)
     {
-        print("Unknown command: %s", message);
+    case COMMAND_SET_STATE:
+        // States are bit flags of the service masks: one at a time, and HALT
+        // only on shutdown
+        switch (command->id)
+        {
+        case EM_STATE_IDLE:
+        case EM_STATE_CALI_HIGH:
+        case EM_STATE_CALI_LOW:
+        case EM_STATE_DRIVE:
+        case EM_STATE_MUSIC:
+        case EM_STATE_JITTER:
+            set_state(command->id);
+            return COMMAND_OK;
+        default:
+            return COMMAND_ERROR_INVALID;
+        }
+    case COMMAND_QUIT:
+        print("You cannot quit in this version.");
+        return COMMAND_ERROR_UNSUPPORTED;
+    case COMMAND_SET_PARAMETER:
+        return parameter_set(command->id, command->value);
+    case COMMAND_SAVE_PARAMETERS:
+        return parameter_save(PARAMETER_FILE) ? COMMAND_OK : COMMAND_ERROR_INVALID;
+    case COMMAND_START_TRACE:
+        trace_start();
+        return COMMAND_OK;
+    case COMMAND_STOP_TRACE:
+        trace_stop();
+        return trace_write(TRACE_FILE) ? COMMAND_OK : COMMAND_ERROR_INVALID;
+    case COMMAND_START_PROFILE:
+        profile_start();
+        return COMMAND_OK;
+    case COMMAND_STOP_PROFILE:
+        profile_stop();
+        return profile_write(PROFILE_FILE) ? COMMAND_OK : COMMAND_ERROR_INVALID;
+    case COMMAND_START_RECORDING:
+        return start_recording() ? COMMAND_OK : COMMAND_ERROR_INVALID;
+    case COMMAND_STOP_RECORDING:
+        if (!output_is_open())
+        {
+            return COMMAND_ERROR_INVALID;
+        }
+        output_close(NULL);
+        return COMMAND_OK;
+    default:
+        print("Unknown command: %u", command->type);
+        return COMMAND_ERROR_UNKNOWN;
     }
 }
 
-static void receive_message(int pipe_miso)
+static void receive_commands()
 {
-    char buffer[1024];
-    uint16_t len = 0;
-    while (em_context.curr_state != EM_STATE_HALT)
+    while (!is_exit_requested)
     {
-        char c;
-        ssize_t bytes_read = read(pipe_miso, &c, 1);
-
-        // If no bytes read, continue
-        if (bytes_read == 0)
+        // Sleep until the UI server signals, then drain the whole queue
+        if (!notify_wait(command_notify))
         {
-            continue;
+            error("Failed to wait for commands");
+            return;
         }
 
-        // If not a newline, add character to buffer
-        if (c != '\n')
+        command_t command;
+        bool is_acked = false;
+        while (command_pop(command_queue, &command))
         {
-            buffer[len++] = c;
-            continue;
+            int32_t status = handle_command(&command);
+            uint64_t latency_ns = timer_get_timestamp_ns() - command.timestamp;
+            command_ack(command_queue, &command, status, latency_ns);
+            is_acked = true;
         }
 
-        // If newline, and if buffer is not empty, handle message
-        if (c == '\n' && len > 0)
+        // Wake the UI server up so that it picks up the acknowledgements
+        if (is_acked)
         {
-            buffer[len] = '\0';
-            handle_message(buffer);
-            len = 0;
+            notify_signal(state_notify);
         }
     }
 }
 
 int main()
 {
-    print("Program started");
-
-    int pipe_miso, pipe_simo;
     pid_t pid;
-    pthread_t threads[3];
+    pthread_t threads[TOPOLOGY_MAX_CONTEXTS];
+
+    boot_init();
+    print("Program started");
 
     init_signal();
-    init_ports();
-    init_cpu_governor();
-    init_em();
-    init_state();
-    init_ui_server(&pipe_miso, &pipe_simo, &pid);
-    init_threads(threads);
+    BOOT_STEP("rt", init_rt());
+
+    // Shared memory has to exist before the UI server starts, which then
+    // boots in parallel with the rest
+    BOOT_STEP("state", init_state());
+    BOOT_STEP("telemetry", init_telemetry());
+    BOOT_STEP("commands", init_commands());
+    BOOT_STEP("parameters", init_parameters());
+    BOOT_STEP("ui_server", init_ui_server(&pid));
+
+    pthread_t device_thread;
+    if (pthread_create(&device_thread, rt_get_thread_attr(), init_devices, NULL) != 0)
+    {
+        error("Error creating device initialisation thread");
+        exit(1);
+    }
+    BOOT_STEP("em", init_em());
+    BOOT_STEP("arena", init_arena());
+    pthread_join(device_thread, NULL);
+
+    publish_set_notify(state_notify);
+
+    // From here on, log calls are formatted on a background thread
+    log_start();
+    BOOT_STEP("threads", init_threads(threads));
+
+    if (boot_wait_ready(topology.num_contexts, BOOT_TIMEOUT_MS))
+    {
+        boot_report();
+    }
+    else
+    {
+        warning("Execution contexts did not finish their setup in time");
+    }
 
-    // Receive message from UI server, until program is halted
-    receive_message(pipe_miso);
+    // Control loops are running, heap use on RT threads is a bug from here
+    arena_audit_start();
+
+    // Receive commands from UI server, until a signal asks to exit
+    trace_set_thread_name("main");
+    receive_commands();
+
+    // Stop the motors first, then let every context run its teardown
+    print("Shutting down");
+    motor_enable(false);
+    set_state(EM_STATE_HALT);
 
     // Join threads
-    pthread_join(threads[0], NULL);
-    pthread_join(threads[1], NULL);
-    pthread_join(threads[2], NULL);
+    for (uint32_t i = 0; i < topology.num_contexts; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
     print("All threads joined");
 
     // Kill UI server
-    kill(pid, SIGKILL);
+    if (pid > 0)
+    {
+        kill(pid, SIGKILL);
+    }
+
+    stop_devices();
+
+    // The kernel setting outlives the process, and no RT thread is left
+    rt_restore_throttling();
+
+    // No producer is left, so the recording in progress can be completed
+    output_close(NULL);
+
+    // Remove the files of the jitter IO stress
+    stress_stop();
 
-    handle_exit();
+    // Flush deferred log records
+    log_stop();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include <ports/dev.h>
+
+#include "sim.h"
+
+// Pins used by sensor.c and encoder.c
+#define IR_S03 23
+#define IR_S02 24
+#define IR_S01 25
+#define IR_S00 26
+#define IR_SEN 27
+
+#define ENCODER_L_A 19
+#define ENCODER_L_B 20
+#define ENCODER_R_A 21
+#define ENCODER_R_B 22
+
+// ADC channel in bits 3..5 of the first byte, as sent by sensor.c and vsense.c
+#define ADC_CHANNEL_IR 0
+#define ADC_CHANNEL_VSENSE 1
+
+bool dev_init()
+{
+    return true;
+}
+
+void dev_gpio_set_mode(uint32_t pin, uint32_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+void dev_gpio_set_pull(uint32_t pin, uint32_t pull)
+{
+    (void)pin;
+    (void)pull;
+}
+
+void dev_gpio_set_mask(uint64_t mask)
+{
+    for (uint32_t pin = 0; pin < 64; pin++)
+    {
+        if (mask & ((uint64_t)1 << pin))
+        {
+            dev_gpio_set_pin(pin);
+        }
+    }
+}
+
+void dev_gpio_set_pin(uint32_t pin)
+{
+    switch (pin)
+    {
+    case IR_S00:
+        sim->mux |= 0x1;
+        break;
+    case IR_S01:
+        sim->mux |= 0x2;
+        break;
+    case IR_S02:
+        sim->mux |= 0x4;
+        break;
+    case IR_S03:
+        sim->mux |= 0x8;
+        break;
+    case IR_SEN:
+        sim->is_led_on = true;
+        break;
+    }
+}
+
+void dev_gpio_clear_mask(uint64_t mask)
+{
+    for (uint32_t pin = 0; pin < 64; pin++)
+    {
+        if (mask & ((uint64_t)1 << pin))
+        {
+            dev_gpio_clear_pin(pin);
+        }
+    }
+}
+
+void dev_gpio_clear_pin(uint32_t pin)
+{
+    switch (pin)
+    {
+    case IR_S00:
+        sim->mux &= ~0x1;
+        break;
+    case IR_S01:
+        sim->mux &= ~0x2;
+        break;
+    case IR_S02:
+        sim->mux &= ~0x4;
+        break;
+    case IR_S03:
+        sim->mux &= ~0x8;
+        break;
+    case IR_SEN:
+        sim->is_led_on = false;
+        break;
+    }
+}
+
+bool dev_gpio_get_pin(uint32_t pin)
+{
+    switch (pin)
+    {
+    case ENCODER_L_A:
+        return sim_plant_encoder_phase(true) >> 1;
+    case ENCODER_L_B:
+        return sim_plant_encoder_phase(true) & 1;
+    case ENCODER_R_A:
+        return sim_plant_encoder_phase(false) >> 1;
+    case ENCODER_R_B:
+        return sim_plant_encoder_phase(false) & 1;
+    }
+    return false;
+}
+
+void dev_pwm_enable(uint32_t channel, bool enable)
+{
+    (void)channel;
+    (void)enable;
+}
+
+void dev_pwm_set_range(uint32_t channel, uint32_t range)
+{
+    (void)channel;
+    (void)range;
+}
+
+void dev_pwm_set_data(uint32_t channel, uint32_t data)
+{
+    (void)channel;
+    (void)data;
+}
+
+void dev_gpclk_enable(uint32_t index, bool enable)
+{
+    (void)index;
+    (void)enable;
+}
+
+void dev_gpclk_set_divisor(uint32_t index, uint32_t integer, uint32_t fraction)
+{
+    (void)index;
+    (void)integer;
+    (void)fraction;
+}
+
+void dev_spi_enable(bool enable)
+{
+    (void)enable;
+}
+
+// Every transfer returns a fresh conversion of the channel in tx[0], and
+// takes SIM_SPI_TRANSFER_NS of virtual time
+void dev_spi_transfer(uint8_t *tx, uint8_t *rx, uint32_t len)
+{
+    uint16_t value = 0;
+    switch ((tx[0] >> 3) & 0x7)
+    {
+    case ADC_CHANNEL_IR:
+        value = sim_plant_read_ir();
+        break;
+    case ADC_CHANNEL_VSENSE:
+        value = sim_plant_read_vsense();
+        break;
+    }
+    sim->now_ns += SIM_SPI_TRANSFER_NS;
+
+    if (len >= 2)
+    {
+        rx[0] = (value >> 8) & 0x0F;
+        rx[1] = value & 0xFF;
+    }
+}
+
+void dev_i2c_enable(bool enable)
+{
+    (void)enable;
+}
+
+bool dev_i2c_read_register(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t len)
+{
+    (void)addr;
+    (void)reg;
+    (void)data;
+    (void)len;
+    return false;
+}
+
+bool dev_i2c_write_register(uint8_t addr, uint8_t reg, uint8_t *data, uint32_t len)
+{
+    (void)addr;
+    (void)reg;
+    (void)data;
+    (void)len;
+    return false;
+}
@@ -0,0 +1,55 @@
+#include <ports/log.h>
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "sim.h"
+
+// Synchronous, stamped with the virtual time, and quiet unless verbose
+
+static void log_write(const char *color, const char *format, va_list args)
+{
+    if (sim == NULL || !sim->config.is_verbose)
+    {
+        return;
+    }
+    char buffer[256];
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    fprintf(stderr, "%s[%07.3f] %s\n%s", color, sim->now_ns / 1e9, buffer, color[0] != '\0' ? "\033[0m" : "");
+}
+
+void print(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    log_write("", format, args);
+    va_end(args);
+}
+
+void error(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    log_write("\033[31m", format, args);
+    va_end(args);
+}
+
+void warning(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    log_write("\033[33m", format, args);
+    va_end(args);
+}
+
+void clear()
+{
+}
+
+void log_start()
+{
+}
+
+void log_stop()
+{
+}
@@ -0,0 +1,38 @@
+#include <ports/motor.h>
+
+#include "sim.h"
+
+bool motor_init()
+{
+    return true;
+}
+
+void motor_enable(bool enable)
+{
+    sim->is_motor_enabled = enable;
+}
+
+// Clipped like the PWM of the real port, applied at the next ARX step
+void motor_set_velocity(float vL, float vR)
+{
+    if (vL > 0.95f)
+    {
+        vL = 0.95f;
+    }
+    else if (vL < -0.95f)
+    {
+        vL = -0.95f;
+    }
+
+    if (vR > 0.95f)
+    {
+        vR = 0.95f;
+    }
+    else if (vR < -0.95f)
+    {
+        vR = -0.95f;
+    }
+
+    sim->left.command = vL;
+    sim->right.command = vR;
+}
@@ -0,0 +1,36 @@
+#include <ports/output.h>
+
+#include <sys/stat.h>
+
+// Nothing is recorded in the simulation
+
+int mkdir_recursive(const char *path, mode_t mode)
+{
+    (void)path;
+    (void)mode;
+    return 0;
+}
+
+bool output_create(const char *filename, const char *schema, uint32_t record_size)
+{
+    (void)filename;
+    (void)schema;
+    (void)record_size;
+    return false;
+}
+
+bool output_write(const void *record)
+{
+    (void)record;
+    return false;
+}
+
+void output_close(output_stats_t *stats)
+{
+    *stats = (output_stats_t){0};
+}
+
+bool output_is_open()
+{
+    return false;
+}
@@ -0,0 +1,222 @@
+#include "sim.h"
+
+#include <math.h>
+
+#define METERS_PER_TICK (SIM_WHEEL_CIRCUMFERENCE / SIM_TICKS_PER_REVOLUTION)
+#define VSENSE_VOLTS_PER_COUNT 0.01926 // Same as vsense.c
+
+void sim_plant_init()
+{
+    sim->step_ns = 0;
+    sim->x = 0;
+    sim->y = 0;
+    sim->heading = 0;
+    sim->left = (sim_wheel_t){0};
+    sim->right = (sim_wheel_t){0};
+    sim->is_motor_enabled = false;
+    sim->mux = 0;
+    sim->is_led_on = false;
+    sim->track_index = 0;
+    sim->is_scanned = false;
+    sim->frame_left_s = 0;
+    sim->frame_right_s = 0;
+    sim->is_phase_valid = false;
+}
+
+// Pose after the given share of the current step. The wheel speeds are held
+// over a step, so the robot moves on an arc, unless that takes more lateral
+// acceleration than the tires grip: then it turns less and the wheels slip.
+static void plant_pose(double share, double *x, double *y, double *heading)
+{
+    // The left motor is mirrored: forward is negative ticks
+    double left = -sim->left.y[0] * METERS_PER_TICK * share;
+    double right = sim->right.y[0] * METERS_PER_TICK * share;
+    double distance = (left + right) / 2;
+    double turn = (right - left) / SIM_TREAD;
+
+    // Lateral acceleration is speed times yaw rate
+    double dt = share * SIM_ARX_STEP_NS / 1e9;
+    if (fabs(distance) > 0 && fabs(distance * turn) > sim->config.grip * dt * dt)
+    {
+        turn = copysign(sim->config.grip * dt * dt / fabs(distance), turn);
+    }
+
+    *x = sim->x + distance * cos(sim->heading + turn / 2);
+    *y = sim->y + distance * sin(sim->heading + turn / 2);
+    *heading = sim->heading + turn;
+}
+
+static double plant_share(uint64_t now_ns)
+{
+    return (double)(now_ns - sim->step_ns) / SIM_ARX_STEP_NS;
+}
+
+static void plant_step_wheel(sim_wheel_t *wheel)
+{
+    double voltage = sim->config.battery_voltage;
+    double u = sim->is_motor_enabled ? wheel->command * voltage / SIM_ARX_VOLTAGE : 0;
+
+    wheel->ticks += wheel->y[0];
+    double y = SIM_ARX_A1 * wheel->y[0] + SIM_ARX_A2 * wheel->y[1] + SIM_ARX_B1 * wheel->u[0] + SIM_ARX_B2 * wheel->u[1];
+    wheel->y[1] = wheel->y[0];
+    wheel->y[0] = y;
+    wheel->u[1] = wheel->u[0];
+    wheel->u[0] = u; // Held over the next step
+}
+
+// Lap bookkeeping on the position of the sensor array, once per step
+static void plant_track()
+{
+    const sim_track_t *track = &sim->track;
+    double x = sim->x + cos(sim->heading) * SIM_SENSOR_OFFSET;
+    double y = sim->y + sin(sim->heading) * SIM_SENSOR_OFFSET;
+    double lateral;
+    sim->track_index = sim_track_locate(track, sim->track_index, x, y, &lateral);
+    double s = track->points[sim->track_index].s;
+
+    if (sim->start_ns == 0 && s >= track->start_s)
+    {
+        sim->start_ns = sim->step_ns;
+    }
+    if (sim->start_ns != 0 && sim->goal_ns == 0)
+    {
+        sim->error_sum += lateral * lateral;
+        sim->error_count++;
+        if (fabs(lateral) > sim->max_error)
+        {
+            sim->max_error = fabs(lateral);
+        }
+    }
+    if (sim->goal_ns == 0 && s >= track->goal_s)
+    {
+        sim->goal_ns = sim->step_ns;
+    }
+
+    if (sim->failure != NULL)
+    {
+        return;
+    }
+    if (fabs(lateral) > SIM_SENSOR_HALF_WIDTH)
+    {
+        sim->failure = "lost the line";
+    }
+    else if (sim->track_index + 1 >= track->num_points)
+    {
+        sim->failure = "ran off the end of the track";
+    }
+}
+
+void sim_plant_advance(uint64_t now_ns)
+{
+    while (now_ns >= sim->step_ns + SIM_ARX_STEP_NS)
+    {
+        plant_pose(1, &sim->x, &sim->y, &sim->heading);
+        plant_step_wheel(&sim->left);
+        plant_step_wheel(&sim->right);
+        sim->step_ns += SIM_ARX_STEP_NS;
+        plant_track();
+    }
+}
+
+void sim_plant_sensor_position(uint8_t sensor, double *x, double *y)
+{
+    double heading;
+    plant_pose(plant_share(sim->now_ns), x, y, &heading);
+
+    double lateral = SIM_SENSOR_HALF_WIDTH * (1 - 2.0 * sensor / (SIM_NUM_SENSORS - 1));
+    *x += cos(heading) * SIM_SENSOR_OFFSET - sin(heading) * lateral;
+    *y += sin(heading) * SIM_SENSOR_OFFSET + cos(heading) * lateral;
+}
+
+static uint16_t plant_adc(double value)
+{
+    if (value < 0)
+    {
+        return 0;
+    }
+    if (value > 4095)
+    {
+        return 4095;
+    }
+    return (uint16_t)(value + 0.5);
+}
+
+// Point of the sensor array at offset from its center, positive to the left
+static void plant_array_point(double x, double y, double heading, double offset, double *point_x, double *point_y)
+{
+    *point_x = x - sin(heading) * offset;
+    *point_y = y + cos(heading) * offset;
+}
+
+// Sensor 0 is on the left at -1 and the lateral offset is positive to the
+// left, so the line is at +1 when the array is HALF_WIDTH left of it. Along
+// the array, which is oblique to the line when the headings differ, and so
+// are the parts of it over the marks.
+void sim_plant_ground_truth(double *position, double *left_s, double *right_s)
+{
+    double x, y, heading;
+    plant_pose(plant_share(sim->now_ns), &x, &y, &heading);
+    x += cos(heading) * SIM_SENSOR_OFFSET;
+    y += sin(heading) * SIM_SENSOR_OFFSET;
+
+    double lateral;
+    uint32_t index = sim_track_locate(&sim->track, sim->track_index, x, y, &lateral);
+    *position = lateral / (SIM_SENSOR_HALF_WIDTH * cos(heading - sim->track.points[index].heading));
+
+    double line = -*position * SIM_SENSOR_HALF_WIDTH;
+    double band = (SIM_MARK_INNER + SIM_MARK_OUTER) / 2;
+    double point_x, point_y;
+    plant_array_point(x, y, heading, line + band, &point_x, &point_y);
+    *left_s = sim->track.points[sim_track_locate(&sim->track, index, point_x, point_y, &lateral)].s;
+    plant_array_point(x, y, heading, line - band, &point_x, &point_y);
+    *right_s = sim->track.points[sim_track_locate(&sim->track, index, point_x, point_y, &lateral)].s;
+}
+
+// The sensor selected by the multiplexer, lit only while the LED is on
+uint16_t sim_plant_read_ir()
+{
+    sim_plant_advance(sim->now_ns);
+
+    double reflectance = 0;
+    if (sim->is_led_on)
+    {
+        double x, y;
+        sim_plant_sensor_position(sim->mux, &x, &y);
+        reflectance = sim_track_reflectance(&sim->track, sim->track_index, x, y);
+    }
+    if (sim->mux == SIM_NUM_SENSORS - 1)
+    {
+        sim->is_scanned = true;
+    }
+    double value = SIM_ADC_BLACK + (SIM_ADC_WHITE - SIM_ADC_BLACK) * reflectance;
+    return plant_adc(value + sim->config.sensor_noise * sim_gaussian());
+}
+
+uint16_t sim_plant_read_vsense()
+{
+    return plant_adc(sim->config.battery_voltage / VSENSE_VOLTS_PER_COUNT);
+}
+
+static uint8_t plant_phase(const sim_wheel_t *wheel, double share)
+{
+    static const uint8_t phases[4] = {0x0, 0x1, 0x3, 0x2};
+    int64_t count = (int64_t)floor(wheel->ticks + wheel->y[0] * share);
+    return phases[count & 3];
+}
+
+// Quadrature state of a wheel: 00, 01, 11, 10 while counting up. The
+// encoder reads four pins per pass at the same virtual time, so both
+// wheels are computed once per time.
+uint8_t sim_plant_encoder_phase(bool is_left)
+{
+    if (sim->phase_ns != sim->now_ns || !sim->is_phase_valid)
+    {
+        sim_plant_advance(sim->now_ns);
+        double share = plant_share(sim->now_ns);
+        sim->left_phase = plant_phase(&sim->left, share);
+        sim->right_phase = plant_phase(&sim->right, share);
+        sim->phase_ns = sim->now_ns;
+        sim->is_phase_valid = true;
+    }
+    return is_left ? sim->left_phase : sim->right_phase;
+}
@@ -0,0 +1,217 @@
+#include "sim.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include <em.h>
+#include <parameter.h>
+#include <telemetry.h>
+#include <algorithms/mark.h>
+
+#include <services/drive.h>
+#include <services/encoder.h>
+#include <services/line.h>
+#include <services/sensor.h>
+#include <services/vsense.h>
+
+#define SIM_STOPPED_TICKS 1.0 // Wheel speed per step below which the robot has stopped
+
+// What the services and the ports of this run see
+INSTANCE_LOCAL sim_t *sim;
+INSTANCE_LOCAL state_t *state;
+INSTANCE_LOCAL telemetry_t *telemetry;
+INSTANCE_LOCAL parameter_table_t *parameters;
+
+void sim_config_init(sim_config_t *config)
+{
+    config->seed = 1;
+    config->num_segments = 8;
+    config->battery_voltage = SIM_ARX_VOLTAGE;
+    config->sensor_noise = 20;
+    config->grip = 8;
+    config->max_time_s = 60;
+    config->is_verbose = false;
+    config->on_frame = NULL;
+    config->frame_context = NULL;
+}
+
+// xorshift64*, seeded through splitmix64 so that any seed works
+uint64_t sim_random()
+{
+    uint64_t x = sim->random;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    sim->random = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static void sim_seed(uint64_t seed)
+{
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    sim->random = z != 0 ? z : 1;
+}
+
+double sim_uniform(double min, double max)
+{
+    return min + (max - min) * ((sim_random() >> 11) * 0x1.0p-53);
+}
+
+// Box-Muller, which gives two values per draw
+double sim_gaussian()
+{
+    if (sim->has_gaussian)
+    {
+        sim->has_gaussian = false;
+        return sim->gaussian;
+    }
+    double u1 = ((sim_random() >> 11) + 1) * 0x1.0p-53;
+    double u2 = (sim_random() >> 11) * 0x1.0p-53;
+    double radius = sqrt(-2 * log(u1));
+    double angle = 2 * 3.14159265358979323846 * u2;
+    sim->gaussian = radius * sin(angle);
+    sim->has_gaussian = true;
+    return radius * cos(angle);
+}
+
+static bool sim_is_done()
+{
+    if (sim->failure != NULL)
+    {
+        return true;
+    }
+    if (sim->now_ns >= sim->config.max_time_s * 1e9)
+    {
+        sim->failure = "timed out";
+        return true;
+    }
+
+    // Past the goal, and drive.c has brought the robot to a stop
+    return sim->goal_ns != 0 && state->speed == 0 &&
+           fabs(sim->left.y[0]) < SIM_STOPPED_TICKS && fabs(sim->right.y[0]) < SIM_STOPPED_TICKS;
+}
+
+static bool sim_is_passed(double prev_s, double s, double end)
+{
+    return prev_s < end && s >= end;
+}
+
+// After the control context has read the last sensor of a scan. A mark is
+// reported once the sensors over it have passed its end, where mark.c
+// reports it.
+static void sim_emit_frame()
+{
+    sim_frame_t frame = {.sensor_data = state->sensor_data, .mark = MARK_NONE};
+    double left_s, right_s;
+    sim_plant_ground_truth(&frame.position, &left_s, &right_s);
+    for (uint32_t i = 0; i < sim->track.num_marks; i++)
+    {
+        const sim_track_mark_t *mark = &sim->track.marks[i];
+        double end = mark->s + SIM_MARK_LENGTH;
+        bool is_left = sim_is_passed(sim->frame_left_s, left_s, end);
+        bool is_right = sim_is_passed(sim->frame_right_s, right_s, end);
+        bool is_both = sim_is_passed(fmin(sim->frame_left_s, sim->frame_right_s), fmin(left_s, right_s), end);
+        if ((mark->side == MARK_LEFT && is_left) || (mark->side == MARK_RIGHT && is_right) || (mark->side == MARK_BOTH && is_both))
+        {
+            frame.mark = mark->side;
+        }
+    }
+    sim->frame_left_s = left_s;
+    sim->frame_right_s = right_s;
+    sim->config.on_frame(&frame, sim->config.frame_context);
+}
+
+bool sim_run(const sim_config_t *config, const parameters_t *params, sim_result_t *result)
+{
+    sim_t instance = {0};
+    state_t local_state = {0};
+    parameter_table_t table;
+
+    sim = &instance;
+    state = &local_state;
+    telemetry = NULL;
+    parameters = &table;
+    parameter_init(&table);
+    if (params != NULL)
+    {
+        table.values = *params;
+    }
+
+    instance.config = *config;
+    sim_seed(config->seed);
+    if (!sim_track_generate(&instance.track, config->num_segments))
+    {
+        sim = NULL;
+        return false;
+    }
+    sim_plant_init();
+
+    // The contexts of the default topology that drive the robot
+    em_context_t context;
+    em_local_context_t control;
+    em_local_context_t encoder;
+    em_init_context(&context);
+    em_init_local_context(&control, &context);
+    em_add_service(&control, &service_sensor);
+    em_add_service(&control, &service_line);
+    em_add_service(&control, &service_vsense);
+    em_add_service(&control, &service_drive);
+    em_init_local_context(&encoder, &context);
+    em_add_service(&encoder, &service_encoder);
+
+    em_local_context_t *contexts[2] = {&control, &encoder};
+    const uint64_t costs[2] = {SIM_CONTROL_LOOP_NS, SIM_ENCODER_LOOP_NS};
+    uint64_t cursors[2] = {0, 0};
+
+    // Set up in IDLE, then replace whatever calibration.bin sensor.c found
+    // with the levels of the model
+    em_update(&control);
+    em_update(&encoder);
+    for (int i = 0; i < SIM_NUM_SENSORS; i++)
+    {
+        state->sensor_low[i] = SIM_ADC_BLACK;
+        state->sensor_high[i] = SIM_ADC_WHITE;
+    }
+    em_set_state(&context, EM_STATE_DRIVE);
+
+    // Run whichever context is furthest behind in virtual time
+    while (true)
+    {
+        uint32_t i = cursors[0] <= cursors[1] ? 0 : 1;
+        sim->now_ns = cursors[i];
+        sim_plant_advance(sim->now_ns);
+        if (sim_is_done())
+        {
+            break;
+        }
+        em_update(contexts[i]);
+        cursors[i] = sim->now_ns + costs[i];
+        if (sim->is_scanned)
+        {
+            sim->is_scanned = false;
+            if (config->on_frame != NULL)
+            {
+                sim_emit_frame();
+            }
+        }
+    }
+
+    *result = (sim_result_t){0};
+    result->failure = sim->failure;
+    result->is_finished = result->failure == NULL;
+    result->lap_time_s = sim->goal_ns != 0 ? (sim->goal_ns - sim->start_ns) / 1e9 : 0;
+    result->rms_error_m = sim->error_count > 0 ? sqrt(sim->error_sum / sim->error_count) : 0;
+    result->max_error_m = sim->max_error;
+    result->time_s = sim->now_ns / 1e9;
+    result->length_m = instance.track.goal_s - instance.track.start_s;
+
+    pthread_mutex_destroy(&context.mutex);
+    sim_track_free(&instance.track);
+    sim = NULL;
+    state = NULL;
+    parameters = NULL;
+    return true;
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <state.h>
+#include <instance.h>
+
+/*
+ * Closed-loop simulation of the robot on a generated track.
+ *
+ * The services in main/core run unmodified against the ports in this
+ * directory instead of main/infra: the timer is a virtual clock, the SPI
+ * ADC reads a model of the IR array and the battery, the encoder GPIOs
+ * follow the simulated wheels, and the motor port drives the wheels
+ * through the ARX model fitted in analysis/motor-tuning.
+ *
+ * The execution contexts of the real topology are interleaved on one
+ * thread in virtual time, so a run depends on nothing but its
+ * configuration and seed, and runs as fast as the CPU allows.
+ */
+
+#define SIM_NUM_SENSORS 16
+#define SIM_MAX_MARKS 128
+
+// ARX model of one wheel at SIM_ARX_VOLTAGE, fitted with
+// analysis/motor-tuning/motor-arx.py (ARX_ORDER = 2) on a 1 ms step:
+// y[t] = a1 y[t-1] + a2 y[t-2] + b1 u[t-1] + b2 u[t-2], y in ticks per step
+#define SIM_ARX_STEP_NS 1000000
+#define SIM_ARX_VOLTAGE 19.9
+#define SIM_ARX_A1 0.710274
+#define SIM_ARX_A2 0.237194
+#define SIM_ARX_B1 13.827339
+#define SIM_ARX_B2 6.999588
+
+// Geometry, in meters
+#define SIM_TICKS_PER_REVOLUTION 4096 // Same as drive.c
+#define SIM_WHEEL_CIRCUMFERENCE 0.075
+#define SIM_TREAD 0.1                // Distance between the wheels
+#define SIM_SENSOR_OFFSET 0.08       // Sensor array ahead of the axle
+#define SIM_SENSOR_HALF_WIDTH 0.06   // Sensor 0 on the left, 15 on the right
+#define SIM_SENSOR_SPOT 0.004        // Radius seen by one sensor
+#define SIM_LINE_WIDTH 0.019
+#define SIM_MARK_LENGTH 0.02
+#define SIM_MARK_INNER 0.0195 // Mark extent from the center of the line
+#define SIM_MARK_OUTER 0.0595
+
+// ADC levels of the IR array, 12 bit
+#define SIM_ADC_BLACK 300
+#define SIM_ADC_WHITE 3500
+
+// Virtual time taken by the hardware
+#define SIM_SPI_TRANSFER_NS 10000 // 2 bytes at 3.2MHz plus the ioctl
+#define SIM_CONTROL_LOOP_NS 2000  // One pass of the control context besides SPI
+#define SIM_ENCODER_LOOP_NS 1000  // One pass of the encoder context
+
+typedef struct
+{
+    double x;
+    double y;
+    double heading;
+    double s; // Distance along the track
+} sim_track_point_t;
+
+typedef struct
+{
+    double s;     // Start along the track
+    uint8_t side; // MARK_LEFT, MARK_RIGHT or MARK_BOTH
+} sim_track_mark_t;
+
+typedef struct
+{
+    sim_track_point_t *points; // Every SIM_TRACK_STEP meters
+    uint32_t num_points;
+    sim_track_mark_t marks[SIM_MAX_MARKS];
+    uint32_t num_marks;
+    double start_s;
+    double goal_s;
+} sim_track_t;
+
+typedef struct
+{
+    double y[2]; // Ticks per step, latest first
+    double u[2]; // Inputs, latest first
+    double ticks;
+    double command; // Last motor_set_velocity(), held until the next step
+} sim_wheel_t;
+
+// One scan of the IR array with what the line and mark algorithms should
+// find in it, for labelled datasets
+typedef struct
+{
+    const double *sensor_data; // SIM_NUM_SENSORS values, as the line service read them
+    double position;           // Of the line under the array, in the units of line.h
+    uint8_t mark;              // MARK_* whose end the array passed during the scan
+} sim_frame_t;
+
+typedef struct
+{
+    uint64_t seed;
+    uint32_t num_segments;  // Straights and curves between start and goal
+    double battery_voltage;
+    double sensor_noise;    // Standard deviation in ADC counts
+    double grip;            // Lateral acceleration the tires hold, m/s^2
+    double max_time_s;      // Virtual time limit
+    bool is_verbose;        // Print the log of the services
+    // Called after every scan of the IR array, when not NULL
+    void (*on_frame)(const sim_frame_t *frame, void *context);
+    void *frame_context;
+} sim_config_t;
+
+typedef struct
+{
+    bool is_finished;    // Crossed the goal and stopped on the track
+    const char *failure; // Why not, if not
+    double lap_time_s;   // Start to goal mark
+    double rms_error_m;  // Distance of the sensor array from the line
+    double max_error_m;
+    double time_s;       // Virtual time simulated
+    double length_m;     // Start to goal
+} sim_result_t;
+
+typedef struct
+{
+    sim_config_t config;
+    sim_track_t track;
+    uint64_t random;
+    double gaussian; // Second value of the last Box-Muller draw
+    bool has_gaussian;
+    uint64_t now_ns; // Virtual time
+
+    // Plant, as of the last ARX step
+    uint64_t step_ns;
+    double x;
+    double y;
+    double heading;
+    sim_wheel_t left;
+    sim_wheel_t right;
+    bool is_motor_enabled;
+
+    // Encoder, cached for one virtual time
+    uint64_t phase_ns;
+    bool is_phase_valid;
+    uint8_t left_phase;
+    uint8_t right_phase;
+
+    // IR array
+    uint8_t mux;
+    bool is_led_on;
+    uint32_t track_index; // Closest track point to the sensor array
+    bool is_scanned;      // Read the last sensor since the last frame
+    double frame_left_s;  // Distance along the track of the left marks at the last frame
+    double frame_right_s;
+
+    // Lap
+    uint64_t start_ns;
+    uint64_t goal_ns;
+    double error_sum;
+    uint64_t error_count;
+    double max_error;
+    const char *failure;
+} sim_t;
+
+extern INSTANCE_LOCAL sim_t *sim;
+
+void sim_config_init(sim_config_t *config);
+// Runs one lap. params may be NULL for the defaults of state-definition.json.
+// With INSTANCE_PER_THREAD, laps may run on several threads at once.
+bool sim_run(const sim_config_t *config, const parameters_t *params, sim_result_t *result);
+
+// Random numbers from the seed of the run
+uint64_t sim_random();
+double sim_uniform(double min, double max);
+double sim_gaussian();
+
+// Track
+#define SIM_TRACK_STEP 0.002
+bool sim_track_generate(sim_track_t *track, uint32_t num_segments);
+void sim_track_free(sim_track_t *track);
+// Closest point to (x, y) searched around hint. lateral is positive to the
+// left of the track.
+uint32_t sim_track_locate(const sim_track_t *track, uint32_t hint, double x, double y, double *lateral);
+double sim_track_reflectance(const sim_track_t *track, uint32_t hint, double x, double y);
+
+// Plant
+void sim_plant_init();
+void sim_plant_advance(uint64_t now_ns);
+void sim_plant_sensor_position(uint8_t sensor, double *x, double *y);
+// Line position under the sensor array now, and the distance along the
+// track of the parts of the array over the left and the right marks
+void sim_plant_ground_truth(double *position, double *left_s, double *right_s);
+uint16_t sim_plant_read_ir();
+uint16_t sim_plant_read_vsense();
+uint8_t sim_plant_encoder_phase(bool is_left);
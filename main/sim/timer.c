@@ -0,0 +1,53 @@
+#include <ports/timer.h>
+
+#include "sim.h"
+
+// Virtual time: it only moves when the simulation advances it
+
+bool timer_init()
+{
+    return true;
+}
+
+void timer_sleep_ns(uint32_t ns)
+{
+    sim->now_ns += ns;
+}
+
+uint32_t timer_get_ns()
+{
+    return sim->now_ns % TIMER_NS_MAX;
+}
+
+uint64_t timer_get_timestamp_ns()
+{
+    return sim->now_ns;
+}
+
+uint64_t timer_get_uptime_ns()
+{
+    return sim->now_ns;
+}
+
+uint64_t timer_get_process_start_ns()
+{
+    return 0;
+}
+
+void loop_init(loop_t *loop, uint32_t interval_ns)
+{
+    loop->interval_ns = interval_ns;
+    loop->last_time_ns = timer_get_ns();
+}
+
+bool loop_update(loop_t *loop, uint32_t *dt_ns)
+{
+    uint32_t current_time = timer_get_ns();
+    *dt_ns = DIFF(current_time, loop->last_time_ns);
+    if (*dt_ns >= loop->interval_ns)
+    {
+        loop->last_time_ns = current_time;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,175 @@
+#include "sim.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithms/mark.h>
+
+#define TRACK_LEAD_IN 0.5   // Straight before the start mark, which is at TRACK_START
+#define TRACK_START 0.3
+#define TRACK_RUN_OUT 2.0   // Straight after the goal mark to stop on
+#define TRACK_WINDOW 100    // Points walked from the hint at most
+#define TRACK_MAX_SEGMENTS 512
+#define TRACK_PI 3.14159265358979323846
+
+#define RAMP(x) ((x) < 0 ? 0 : (x) > 1 ? 1 : (x))
+
+typedef struct
+{
+    double length;
+    double curvature;
+} segment_t;
+
+static void track_add_mark(sim_track_t *track, double s, uint8_t side)
+{
+    if (track->num_marks < SIM_MAX_MARKS)
+    {
+        track->marks[track->num_marks++] = (sim_track_mark_t){.s = s - SIM_MARK_LENGTH / 2, .side = side};
+    }
+}
+
+// A course in the style of a line trace contest: straights and arcs, start
+// and goal marks on both sides, and a mark on the left wherever the
+// curvature changes. Crossings of the track with itself are not drawn.
+bool sim_track_generate(sim_track_t *track, uint32_t num_segments)
+{
+    segment_t segments[TRACK_MAX_SEGMENTS];
+    uint32_t count = 0;
+    double length = TRACK_LEAD_IN;
+
+    if (num_segments * 2 + 3 > TRACK_MAX_SEGMENTS)
+    {
+        return false;
+    }
+
+    *track = (sim_track_t){0};
+    track->start_s = TRACK_START;
+    track_add_mark(track, TRACK_START, MARK_BOTH);
+    segments[count++] = (segment_t){.length = TRACK_LEAD_IN, .curvature = 0};
+
+    for (uint32_t i = 0; i < num_segments; i++)
+    {
+        segments[count++] = (segment_t){.length = sim_uniform(0.3, 1.0), .curvature = 0};
+        length += segments[count - 1].length;
+        track_add_mark(track, length, MARK_LEFT);
+
+        double radius = sim_uniform(0.2, 0.8);
+        double angle = sim_uniform(TRACK_PI / 6, TRACK_PI);
+        double direction = sim_random() & 1 ? 1 : -1;
+        segments[count++] = (segment_t){.length = radius * angle, .curvature = direction / radius};
+        length += segments[count - 1].length;
+        track_add_mark(track, length, MARK_LEFT);
+    }
+
+    segments[count++] = (segment_t){.length = sim_uniform(0.5, 1.0), .curvature = 0};
+    length += segments[count - 1].length;
+    track->goal_s = length;
+    track_add_mark(track, length, MARK_BOTH);
+    segments[count++] = (segment_t){.length = TRACK_RUN_OUT, .curvature = 0};
+    length += TRACK_RUN_OUT;
+
+    // Walk the segments into a polyline
+    track->points = malloc(sizeof(sim_track_point_t) * ((uint32_t)(length / SIM_TRACK_STEP) + 2));
+    if (track->points == NULL)
+    {
+        return false;
+    }
+    sim_track_point_t point = {0};
+    track->points[track->num_points++] = point;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t steps = (uint32_t)(segments[i].length / SIM_TRACK_STEP + 0.5);
+        for (uint32_t j = 0; j < steps; j++)
+        {
+            double heading = point.heading + segments[i].curvature * SIM_TRACK_STEP / 2;
+            point.x += cos(heading) * SIM_TRACK_STEP;
+            point.y += sin(heading) * SIM_TRACK_STEP;
+            point.heading += segments[i].curvature * SIM_TRACK_STEP;
+            point.s += SIM_TRACK_STEP;
+            track->points[track->num_points++] = point;
+        }
+    }
+    return true;
+}
+
+void sim_track_free(sim_track_t *track)
+{
+    free(track->points);
+    track->points = NULL;
+    track->num_points = 0;
+}
+
+static double track_distance(const sim_track_t *track, uint32_t index, double x, double y)
+{
+    double dx = x - track->points[index].x;
+    double dy = y - track->points[index].y;
+    return dx * dx + dy * dy;
+}
+
+// Walks from the hint while the distance falls. Near the track the
+// distance has a single minimum within TRACK_WINDOW points, which holds for
+// the sensor array as long as it sees the line at all.
+uint32_t sim_track_locate(const sim_track_t *track, uint32_t hint, double x, double y, double *lateral)
+{
+    uint32_t closest = hint < track->num_points ? hint : track->num_points - 1;
+    double closest_distance = track_distance(track, closest, x, y);
+
+    for (int direction = -1; direction <= 1; direction += 2)
+    {
+        for (uint32_t i = 0; i < TRACK_WINDOW; i++)
+        {
+            int64_t next = (int64_t)closest + direction;
+            if (next < 0 || next >= track->num_points)
+            {
+                break;
+            }
+            double distance = track_distance(track, (uint32_t)next, x, y);
+            if (distance >= closest_distance)
+            {
+                break;
+            }
+            closest = (uint32_t)next;
+            closest_distance = distance;
+        }
+    }
+
+    const sim_track_point_t *point = &track->points[closest];
+    *lateral = -(x - point->x) * sin(point->heading) + (y - point->y) * cos(point->heading);
+    return closest;
+}
+
+// Share of the sensor spot on white: the line, and the marks beside it.
+// Edges are blurred linearly over the diameter of the spot.
+double sim_track_reflectance(const sim_track_t *track, uint32_t hint, double x, double y)
+{
+    double lateral;
+    uint32_t index = sim_track_locate(track, hint, x, y, &lateral);
+    const sim_track_point_t *point = &track->points[index];
+    double s = point->s + (x - point->x) * cos(point->heading) + (y - point->y) * sin(point->heading);
+
+    double reflectance = RAMP(0.5 + (SIM_LINE_WIDTH / 2 - fabs(lateral)) / (2 * SIM_SENSOR_SPOT));
+
+    double band_center = (SIM_MARK_INNER + SIM_MARK_OUTER) / 2;
+    double band_half = (SIM_MARK_OUTER - SIM_MARK_INNER) / 2;
+    for (uint32_t i = 0; i < track->num_marks; i++)
+    {
+        const sim_track_mark_t *mark = &track->marks[i];
+        double along = s - mark->s - SIM_MARK_LENGTH / 2;
+        if (fabs(along) > SIM_MARK_LENGTH / 2 + SIM_SENSOR_SPOT)
+        {
+            continue;
+        }
+        uint8_t side = lateral > 0 ? MARK_LEFT : MARK_RIGHT;
+        if (!(mark->side & side))
+        {
+            continue;
+        }
+        double across = RAMP(0.5 + (band_half - fabs(fabs(lateral) - band_center)) / (2 * SIM_SENSOR_SPOT));
+        double coverage = across * RAMP(0.5 + (SIM_MARK_LENGTH / 2 - fabs(along)) / (2 * SIM_SENSOR_SPOT));
+        if (coverage > reflectance)
+        {
+            reflectance = coverage;
+        }
+    }
+    return reflectance;
+}
@@ -4,14 +4,77 @@ const path = require("path");
 const express = require("express");
 const WebSocket = require("ws");
 const Robot = require("./robot");
+const Client = require("./client");
+const TelemetryReader = require("./telemetry");
+const { TelemetryPyramid } = require("./pyramid");
+const { SessionRecorder, listSessions, writeSessionRange, Replay } = require("./session");
+const stateCodec = require("./state-codec");
 
 const PORT = 80;
 const UI_PATH = path.join(__dirname, "..", "frontend", "dist");
+const FLUSH_INTERVAL = 50;
+const TELEMETRY_INTERVAL = 20;
+const TELEMETRY_DEFAULT_WINDOW = 10; // Seconds
+const TELEMETRY_MAX_POINTS = 4096;
 const app = express();
 
 // Serve static files from public directory
 app.use(express.static(UI_PATH));
 
+// Send budget and lag of every client
+app.get("/api/clients", (req, res) => {
+  res.json([...clients].map((client) => client.lag()));
+});
+
+// Decimated telemetry history, e.g.
+// /api/telemetry?signals=position,speed&start=12.5&end=22.5&points=800
+// Times are seconds of CLOCK_MONOTONIC on the robot, the window defaults to
+// the last TELEMETRY_DEFAULT_WINDOW seconds. Without signals, lists what
+// is available.
+app.get("/api/telemetry", (req, res) => {
+  if (req.query.signals === undefined) {
+    res.json(pyramid.describe());
+    return;
+  }
+  const latest = pyramid.latest === null ? 0 : pyramid.latest / 1e9;
+  const end = req.query.end !== undefined ? +req.query.end : latest;
+  const start = req.query.start !== undefined ? +req.query.start : end - TELEMETRY_DEFAULT_WINDOW;
+  const points = Math.min(TELEMETRY_MAX_POINTS, Math.floor(+(req.query.points || 1000)));
+  try {
+    const result = pyramid.query(req.query.signals.split(","), start * 1e9, end * 1e9, points);
+    res.json({ start, end, ...result });
+  } catch (err) {
+    res.status(400).json({ error: err.message });
+  }
+});
+
+// Recorded drive sessions, and the records of one of them in a time range
+// (ms since epoch) in the format of the session file
+app.get("/api/sessions", async (req, res) => {
+  try {
+    res.json(await listSessions());
+  } catch (err) {
+    res.status(500).json({ error: err.message });
+  }
+});
+
+app.get("/api/sessions/:name", async (req, res) => {
+  const start = req.query.start !== undefined ? +req.query.start : -Infinity;
+  const end = req.query.end !== undefined ? +req.query.end : Infinity;
+  // Streamed chunk by chunk. Until the first write nothing is sent, so a
+  // missing session can still be answered with an error.
+  res.type("application/octet-stream");
+  try {
+    await writeSessionRange(req.params.name, start, end, res);
+  } catch (err) {
+    if (res.headersSent) {
+      res.destroy(err);
+    } else {
+      res.status(404).json({ error: err.message });
+    }
+  }
+});
+
 // Fallback to index.html
 app.get("{*_}", (req, res) => {
   res.sendFile(path.join(UI_PATH, "index.html"));
@@ -22,22 +85,131 @@ const server = app.listen(PORT, () => {
   console.log(`Server listening on port ${PORT}`);
 });
 
+// Fold telemetry into the pyramid as it is produced
+const pyramid = new TelemetryPyramid();
+try {
+  const telemetry = new TelemetryReader();
+  setInterval(() => pyramid.add(telemetry.read()), TELEMETRY_INTERVAL);
+} catch (err) {
+  console.error(`Telemetry unavailable: ${err.message}`);
+}
+
 // Create WebSocket server and robot
 const wss = new WebSocket.Server({ server });
 const robot = new Robot();
 
-// Setup event handlers
-wss.on("connection", (ws) => {
-  function handleRobotEvent(event) {
-    ws.send(JSON.stringify(event));
+// State that was last broadcast, used as the base of the next delta
+let broadcastState = null;
+const clients = new Set();
+const recorder = new SessionRecorder();
+
+// Every drive session is recorded, from entering DRIVE until leaving it
+function recordSession(message, state) {
+  const isDriving = state.state === stateCodec.modes.DRIVE;
+  if (isDriving && !recorder.isRecording()) {
+    recorder.start(state);
+    return;
+  }
+  recorder.recordState(message, state);
+  if (!isDriving) recorder.stop();
+}
+
+// Serialise every robot event once and hand it to all clients. State
+// changes are sent as binary deltas, everything else as JSON.
+function handleRobotEvent(event) {
+  if (event.type === "state") {
+    const prevState = broadcastState;
+    const message = stateCodec.encode_state_delta(prevState, event.data);
+    broadcastState = event.data;
+    if (message !== null) {
+      recordSession(message, event.data);
+      clients.forEach((client) => client.sendState(message, prevState, event.data));
+    }
+    return;
   }
+  if (event.type === "input") recorder.recordInput(event.data);
+  const message = JSON.stringify(event);
+  clients.forEach((client) => client.send(event.type, message));
+}
+
+// Clients that fell behind catch up as their sockets drain
+setInterval(() => clients.forEach((client) => client.flush()), FLUSH_INTERVAL);
 
+robot.addListener(handleRobotEvent);
+
+// Setup event handlers
+wss.on("connection", (ws, req) => {
   function handleWebSocketMessage(message) {
+    // Timestamp on arrival, to measure the latency up to em_set_state()
+    const timestamp = process.hrtime.bigint();
     const command = message.toString();
-    robot.sendCommand(command);
+    recorder.recordCommand(command);
+
+    // Structured commands are JSON objects, mode changes are plain text
+    if (!command.startsWith("{")) {
+      robot.sendCommand(command, timestamp);
+      return;
+    }
+
+    let request;
+    try {
+      request = JSON.parse(command);
+    } catch (err) {
+      console.error(`Invalid command: ${command}`);
+      return;
+    }
+    switch (request.type) {
+      case "set_parameter":
+        robot.setParameter(request.name, request.value, timestamp);
+        break;
+      case "save_parameters":
+        robot.saveParameters(timestamp);
+        break;
+      case "replay":
+        startReplay(request.name, request.speed);
+        break;
+      case "replay_stop":
+        if (client.replay !== null) client.replay.stop();
+        break;
+      default:
+        console.error(`Unknown command type: ${request.type}`);
+    }
+  }
+
+  // Send the schema once, then the full state as a delta from nothing
+  ws.send(JSON.stringify({ type: "status", data: robot.status }));
+  ws.send(JSON.stringify({ type: "schema", data: stateCodec.schema }));
+  if (broadcastState !== null) {
+    ws.send(stateCodec.encode_state_delta(null, broadcastState));
+  }
+  if (robot.status === "INITIALIZED") {
+    ws.send(JSON.stringify({ type: "input", data: robot.inputBuffer }));
+    ws.send(
+      JSON.stringify({ type: "parameters", data: robot.parameterMessage() })
+    );
+  }
+
+  // Replays go to this client only, within its send budget. It gets the
+  // live state back after, while everything else goes on during the replay.
+  function startReplay(name, speed) {
+    if (client.replay !== null) client.replay.stop();
+    client.send("replay", JSON.stringify({ type: "replay", data: { name, active: true } }));
+    const replay = new Replay(name, speed, (message) => client.sendReplay(message), (err) => {
+      if (err !== null) console.error(`Replay of ${name} failed: ${err.message}`);
+      if (client.replay === replay) client.replay = null;
+      client.send("replay", JSON.stringify({ type: "replay", data: { name, active: false } }));
+      if (broadcastState !== null && client.replay === null) {
+        client.sendState(stateCodec.encode_state_delta(null, broadcastState), null, broadcastState);
+      }
+    });
+    client.replay = replay;
   }
 
-  robot.addListener(handleRobotEvent);
+  const client = new Client(ws, req.socket.remoteAddress);
+  clients.add(client);
+  ws.on("close", () => {
+    if (client.replay !== null) client.replay.stop();
+    clients.delete(client);
+  });
   ws.on("message", handleWebSocketMessage);
-  ws.on("close", () => robot.removeListener(handleRobotEvent));
 });
@@ -0,0 +1,141 @@
+const stateCodec = require("./state-codec");
+
+// Unsent bytes a client may have before it is considered behind
+const SEND_BUDGET = 64 * 1024;
+
+// Log text kept for a client that is behind, the oldest is dropped beyond it
+const QUEUE_LIMIT = 256 * 1024;
+
+// A connected WebSocket with a send budget. Messages are serialised once by
+// the caller and shared by all clients. While a client is behind, its state
+// deltas are coalesced into one delta to the latest state, log text is
+// queued up to QUEUE_LIMIT and other events only keep their latest message.
+class Client {
+  constructor(ws, address) {
+    this.ws = ws;
+    this.address = address;
+    this.connectedAt = Date.now();
+    this.behindSince = null;
+
+    // Last state the client was sent, only kept while behind
+    this.stateBase = undefined;
+    this.latestState = null;
+
+    this.queue = [];
+    this.queueBytes = 0;
+    this.latest = new Map();
+
+    // Live state is held off while a recorded session is replayed
+    this.replay = null;
+
+    this.coalescedStates = 0;
+    this.droppedMessages = 0;
+    this.droppedSinceBehind = 0;
+    this.maxBufferedAmount = 0;
+  }
+
+  isBehind() {
+    return this.behindSince !== null;
+  }
+
+  hasBudget() {
+    const bufferedAmount = this.ws.bufferedAmount;
+    this.maxBufferedAmount = Math.max(this.maxBufferedAmount, bufferedAmount);
+    return bufferedAmount < SEND_BUDGET;
+  }
+
+  // message is the delta from prevState to nextState
+  sendState(message, prevState, nextState) {
+    if (this.replay !== null) return;
+    if (!this.isBehind() && this.hasBudget()) {
+      this.ws.send(message);
+      return;
+    }
+    // A delta from nothing replaces whatever the client was sent before
+    if (this.stateBase === undefined || prevState === null) this.stateBase = prevState;
+    this.latestState = nextState;
+    this.coalescedStates++;
+    this.fallBehind();
+  }
+
+  send(type, message) {
+    if (!this.isBehind() && this.hasBudget()) {
+      this.ws.send(message);
+      return;
+    }
+    this.fallBehind();
+
+    if (type !== "input") {
+      this.latest.set(type, message);
+      return;
+    }
+    this.queue.push(message);
+    this.queueBytes += message.length;
+    while (this.queueBytes > QUEUE_LIMIT) {
+      this.queueBytes -= this.queue.shift().length;
+      this.droppedMessages++;
+      this.droppedSinceBehind++;
+    }
+  }
+
+  // Replayed messages are sent within the budget or not at all, the replay
+  // waits and tries again when this returns false
+  sendReplay(message) {
+    if (this.isBehind() || !this.hasBudget()) return false;
+    this.ws.send(message);
+    return true;
+  }
+
+  fallBehind() {
+    if (this.isBehind()) return;
+    this.behindSince = Date.now();
+    console.error(`Client ${this.address} is behind, coalescing its updates`);
+  }
+
+  // Sends what was held back, as far as the budget allows
+  flush() {
+    if (!this.isBehind()) return;
+
+    // Tell the terminal where the gap in the log is
+    if (this.droppedSinceBehind > 0 && this.hasBudget()) {
+      const notice = `\r\n[${this.droppedSinceBehind} log messages dropped]\r\n`;
+      this.ws.send(JSON.stringify({ type: "input", data: notice }));
+      this.droppedSinceBehind = 0;
+    }
+    while (this.queue.length > 0 && this.hasBudget()) {
+      const message = this.queue.shift();
+      this.queueBytes -= message.length;
+      this.ws.send(message);
+    }
+    if (this.queue.length > 0 || !this.hasBudget()) return;
+
+    this.latest.forEach((message) => this.ws.send(message));
+    this.latest.clear();
+    if (this.stateBase !== undefined) {
+      const message = stateCodec.encode_state_delta(this.stateBase, this.latestState);
+      if (message !== null) this.ws.send(message);
+      this.stateBase = undefined;
+      this.latestState = null;
+    }
+
+    console.log(`Client ${this.address} caught up after ${Date.now() - this.behindSince} ms`);
+    this.behindSince = null;
+  }
+
+  lag() {
+    return {
+      address: this.address,
+      connectedMs: Date.now() - this.connectedAt,
+      bufferedAmount: this.ws.bufferedAmount,
+      maxBufferedAmount: this.maxBufferedAmount,
+      behindMs: this.isBehind() ? Date.now() - this.behindSince : 0,
+      queuedMessages: this.queue.length,
+      queuedBytes: this.queueBytes,
+      isReplaying: this.replay !== null,
+      coalescedStates: this.coalescedStates,
+      droppedMessages: this.droppedMessages,
+    };
+  }
+}
+
+module.exports = Client;
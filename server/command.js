@@ -0,0 +1,148 @@
+const fs = require("fs");
+const { modes } = require("./state-codec.js");
+
+const sharedMemoryPath = "/dev/shm/command";
+
+// Must match command_queue_t in main/core/include/command.h
+const COMMAND_MAGIC = 0x444d4d43;
+const COMMAND_HEAD_OFFSET = 64;
+const COMMAND_TAIL_OFFSET = 128;
+const ACK_HEAD_OFFSET = 192;
+const COMMANDS_OFFSET = 256;
+const COMMAND_SIZE = 32;
+const ACK_SIZE = 16;
+
+const COMMAND_SET_STATE = 0x01;
+const COMMAND_SET_PARAMETER = 0x02;
+const COMMAND_START_RECORDING = 0x03;
+const COMMAND_STOP_RECORDING = 0x04;
+const COMMAND_QUIT = 0x05;
+const COMMAND_SAVE_PARAMETERS = 0x06;
+const COMMAND_START_TRACE = 0x07;
+const COMMAND_STOP_TRACE = 0x08;
+const COMMAND_START_PROFILE = 0x09;
+const COMMAND_STOP_PROFILE = 0x0a;
+
+const stateIds = new Set(Object.values(modes));
+
+const COMMAND_OK = 0;
+const statusNames = {
+  0: "OK",
+  [-1]: "UNKNOWN",
+  [-2]: "UNSUPPORTED",
+  [-3]: "INVALID",
+};
+
+class CommandQueue {
+  constructor(notifyFd) {
+    this.fd = fs.openSync(sharedMemoryPath, "r+");
+    this.notifyFd = notifyFd;
+    this.word = Buffer.alloc(4);
+    this.slot = Buffer.alloc(COMMAND_SIZE);
+    this.notifyBuffer = Buffer.alloc(8);
+    this.notifyBuffer.writeBigUInt64LE(1n);
+
+    if (this.readWord(0) !== COMMAND_MAGIC) {
+      throw new Error("Command queue layout mismatch");
+    }
+    this.capacity = this.readWord(4);
+    this.acksOffset = COMMANDS_OFFSET + this.capacity * COMMAND_SIZE;
+    this.ackBuffer = Buffer.alloc(this.capacity * ACK_SIZE);
+
+    // Only this process writes the command head, so it is cached locally
+    this.head = this.readWord(COMMAND_HEAD_OFFSET);
+    this.ackCursor = this.readWord(ACK_HEAD_OFFSET);
+    this.seq = 0;
+    this.pending = new Map();
+    this.latency = { count: 0, sum: 0, min: Infinity, max: 0 };
+  }
+
+  readWord(offset) {
+    fs.readSync(this.fd, this.word, 0, 4, offset);
+    return this.word.readUInt32LE(0);
+  }
+
+  writeWord(offset, value) {
+    this.word.writeUInt32LE(value >>> 0, 0);
+    fs.writeSync(this.fd, this.word, 0, 4, offset);
+  }
+
+  // Push a command and wake the main thread up. The returned promise
+  // resolves with the acknowledgement written back by the C side.
+  //
+  // A command stays in flight until its ack has been collected, and the ack
+  // ring has the same capacity as the command ring, so in-flight commands are
+  // bounded by the ack cursor rather than the command tail. Otherwise the C
+  // side could lap the ack ring and the overwritten promises would never
+  // settle.
+  send(type, id = 0, value = 0, timestamp = process.hrtime.bigint()) {
+    if (type === COMMAND_SET_STATE && !stateIds.has(id)) {
+      return Promise.reject(new Error(`Unknown state ${id}`));
+    }
+    this.pollAcks();
+    if (((this.head - this.ackCursor) >>> 0) >= this.capacity) {
+      return Promise.reject(new Error("Command queue is full"));
+    }
+
+    const seq = (this.seq = (this.seq + 1) >>> 0);
+    this.slot.writeUInt32LE(seq, 0);
+    this.slot.writeUInt32LE(type, 4);
+    this.slot.writeUInt32LE(id, 8);
+    this.slot.writeUInt32LE(0, 12);
+    this.slot.writeDoubleLE(value, 16);
+    this.slot.writeBigUInt64LE(timestamp, 24);
+
+    // Write the slot before publishing it by advancing the head
+    const slot = this.head % this.capacity;
+    fs.writeSync(this.fd, this.slot, 0, COMMAND_SIZE, COMMANDS_OFFSET + slot * COMMAND_SIZE);
+    this.head = (this.head + 1) >>> 0;
+    this.writeWord(COMMAND_HEAD_OFFSET, this.head);
+    fs.writeSync(this.notifyFd, this.notifyBuffer, 0, 8);
+
+    return new Promise((resolve) => this.pending.set(seq, resolve));
+  }
+
+  // Collect the acknowledgements written since the last call
+  pollAcks() {
+    const ackHead = this.readWord(ACK_HEAD_OFFSET);
+    const count = (ackHead - this.ackCursor) >>> 0;
+    if (count === 0) return;
+
+    fs.readSync(this.fd, this.ackBuffer, 0, this.capacity * ACK_SIZE, this.acksOffset);
+    for (let i = 0; i < count; i++) {
+      const base = ((this.ackCursor + i) % this.capacity) * ACK_SIZE;
+      const seq = this.ackBuffer.readUInt32LE(base);
+      const status = this.ackBuffer.readInt32LE(base + 4);
+      const latencyNs = Number(this.ackBuffer.readBigUInt64LE(base + 8));
+
+      if (status === COMMAND_OK) {
+        this.latency.count++;
+        this.latency.sum += latencyNs;
+        this.latency.min = Math.min(this.latency.min, latencyNs);
+        this.latency.max = Math.max(this.latency.max, latencyNs);
+      }
+
+      const resolve = this.pending.get(seq);
+      if (resolve) {
+        this.pending.delete(seq);
+        resolve({ seq, status, statusName: statusNames[status], latencyNs });
+      }
+    }
+    this.ackCursor = ackHead;
+  }
+}
+
+module.exports = {
+  CommandQueue,
+  COMMAND_SET_STATE,
+  COMMAND_SET_PARAMETER,
+  COMMAND_START_RECORDING,
+  COMMAND_STOP_RECORDING,
+  COMMAND_QUIT,
+  COMMAND_SAVE_PARAMETERS,
+  COMMAND_START_TRACE,
+  COMMAND_STOP_TRACE,
+  COMMAND_START_PROFILE,
+  COMMAND_STOP_PROFILE,
+  COMMAND_OK,
+};
@@ -0,0 +1,67 @@
+const fs = require("fs");
+const { parameters: definitions } = require("./state-codec.js");
+
+const sharedMemoryPath = "/dev/shm/parameters";
+
+// Must match parameter_table_t in main/core/include/parameter.h
+const PARAMETER_MAGIC = 0x41524150;
+const SEQUENCE_OFFSET = 8;
+const VALUES_OFFSET = 16;
+
+class ParameterTable {
+  constructor() {
+    this.fd = fs.openSync(sharedMemoryPath, "r");
+    this.size = VALUES_OFFSET + definitions.length * 12;
+    this.buffer = Buffer.alloc(this.size);
+    this.word = Buffer.alloc(4);
+
+    fs.readSync(this.fd, this.buffer, 0, this.size, 0);
+    if (
+      this.buffer.readUInt32LE(0) !== PARAMETER_MAGIC ||
+      this.buffer.readUInt32LE(4) !== definitions.length
+    ) {
+      throw new Error("Parameter layout mismatch, re-run state-gen");
+    }
+
+    this.sequence = -1;
+    this.values = {};
+  }
+
+  readSequence() {
+    fs.readSync(this.fd, this.word, 0, 4, SEQUENCE_OFFSET);
+    return this.word.readUInt32LE(0);
+  }
+
+  // Re-read the table if it changed since the last call. Returns true when
+  // this.values has been updated.
+  update() {
+    if (this.readSequence() === this.sequence) return false;
+
+    // Same sequence lock protocol as parameter_sync() on the C side
+    for (;;) {
+      fs.readSync(this.fd, this.buffer, 0, this.size, 0);
+      const before = this.buffer.readUInt32LE(SEQUENCE_OFFSET);
+      if (before % 2 === 0 && this.readSequence() === before) {
+        this.sequence = before;
+        break;
+      }
+    }
+
+    const values = {};
+    definitions.forEach(({ name }, i) => {
+      values[name] = this.buffer.readDoubleLE(VALUES_OFFSET + i * 8);
+    });
+    this.values = values;
+    return true;
+  }
+
+  indexOf(name) {
+    return definitions.findIndex((definition) => definition.name === name);
+  }
+
+  close() {
+    fs.closeSync(this.fd);
+  }
+}
+
+module.exports = { ParameterTable, definitions };
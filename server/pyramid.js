@@ -0,0 +1,174 @@
+// Multi-resolution min/max/mean history of high-rate telemetry signals.
+//
+// Every level is a ring of time-aligned buckets, each LEVEL_FACTOR times
+// wider than the one below, so a query for any window is answered from
+// the coarsest level that still has at least one bucket per point, and
+// spikes stay visible as min/max at any zoom level. Rings have a fixed
+// capacity, so the finest level covers seconds and the coarsest hours,
+// with memory bounded up front.
+
+const SIGNALS = [
+  "position",
+  "speed",
+  "encoder_left",
+  "encoder_right",
+  ...Array.from({ length: 16 }, (_, i) => `sensor_data_${i}`),
+];
+
+const BASE_WIDTH_NS = 1e6; // 1 ms, the rate of the drive loop
+const LEVEL_FACTOR = 4;
+const NUM_LEVELS = 7; // Up to 4.096 s buckets
+const LEVEL_CAPACITY = 8192; // Buckets per level
+
+function signalValues(record, values) {
+  values[0] = record.position;
+  values[1] = record.speed;
+  values[2] = record.encoder_left;
+  values[3] = record.encoder_right;
+  for (let i = 0; i < 16; i++) values[4 + i] = record.sensor_data[i];
+}
+
+class Level {
+  constructor(widthNs) {
+    const size = LEVEL_CAPACITY * SIGNALS.length;
+    this.widthNs = widthNs;
+    this.buckets = new Float64Array(LEVEL_CAPACITY).fill(-1); // Bucket number held by each slot
+    this.counts = new Uint32Array(LEVEL_CAPACITY);
+    this.min = new Float32Array(size);
+    this.max = new Float32Array(size);
+    this.sum = new Float64Array(size);
+    this.first = Infinity; // Oldest bucket number that is still held
+    this.last = -1;
+  }
+
+  add(timestamp, values) {
+    const bucket = Math.floor(timestamp / this.widthNs);
+    const slot = bucket % LEVEL_CAPACITY;
+    const base = slot * SIGNALS.length;
+
+    if (this.buckets[slot] !== bucket) {
+      this.buckets[slot] = bucket;
+      this.counts[slot] = 0;
+      for (let i = 0; i < SIGNALS.length; i++) {
+        this.min[base + i] = Infinity;
+        this.max[base + i] = -Infinity;
+        this.sum[base + i] = 0;
+      }
+    }
+
+    this.counts[slot]++;
+    for (let i = 0; i < SIGNALS.length; i++) {
+      const value = values[i];
+      if (value < this.min[base + i]) this.min[base + i] = value;
+      if (value > this.max[base + i]) this.max[base + i] = value;
+      this.sum[base + i] += value;
+    }
+
+    this.last = Math.max(this.last, bucket);
+    this.first = Math.max(Math.min(this.first, bucket), this.last - LEVEL_CAPACITY + 1);
+  }
+
+  covers(startNs) {
+    return this.last >= 0 && Math.floor(startNs / this.widthNs) >= this.first;
+  }
+}
+
+class TelemetryPyramid {
+  constructor() {
+    this.levels = [];
+    for (let i = 0, width = BASE_WIDTH_NS; i < NUM_LEVELS; i++, width *= LEVEL_FACTOR) {
+      this.levels.push(new Level(width));
+    }
+    this.values = new Float64Array(SIGNALS.length);
+    this.latest = null;
+    this.records = 0;
+  }
+
+  add(records) {
+    for (const record of records) {
+      signalValues(record, this.values);
+      for (const level of this.levels) level.add(record.timestamp, this.values);
+      this.latest = record.timestamp;
+      this.records++;
+    }
+  }
+
+  // Min, max and mean of the signals over [startNs, endNs), merged into at
+  // most points bins. Bins without data are left out.
+  query(signals, startNs, endNs, points) {
+    const indices = signals.map((name) => SIGNALS.indexOf(name));
+    if (indices.includes(-1)) throw new Error(`Unknown signal in ${signals.join(",")}`);
+    if (!(endNs > startNs) || !(points >= 1)) throw new Error("Invalid range");
+
+    // The coarsest level with a bucket per bin, or else the finest that
+    // still holds the start of the window
+    const binWidthNs = (endNs - startNs) / points;
+    let level = this.levels.find((level) => level.covers(startNs)) || this.levels[this.levels.length - 1];
+    for (const candidate of this.levels) {
+      if (candidate.widthNs <= binWidthNs && candidate.covers(startNs)) level = candidate;
+    }
+
+    const result = { widthNs: level.widthNs, t: [], signals: {} };
+    const bins = signals.map((name) => (result.signals[name] = { min: [], max: [], mean: [] }));
+
+    const firstBucket = Math.max(Math.floor(startNs / level.widthNs), level.first);
+    const lastBucket = Math.min(Math.floor((endNs - 1) / level.widthNs), level.last);
+    let currentBin = -1;
+    let count = 0;
+    let min = new Float64Array(indices.length);
+    let max = new Float64Array(indices.length);
+    let sum = new Float64Array(indices.length);
+
+    const emit = () => {
+      if (count === 0) return;
+      result.t.push((startNs + (currentBin + 0.5) * binWidthNs) / 1e9);
+      indices.forEach((_, j) => {
+        bins[j].min.push(min[j]);
+        bins[j].max.push(max[j]);
+        bins[j].mean.push(sum[j] / count);
+      });
+    };
+
+    for (let bucket = firstBucket; bucket <= lastBucket; bucket++) {
+      const slot = bucket % LEVEL_CAPACITY;
+      if (level.buckets[slot] !== bucket) continue;
+
+      const offsetNs = bucket * level.widthNs - startNs;
+      const bin = Math.max(0, Math.min(points - 1, Math.floor(offsetNs / binWidthNs)));
+      if (bin !== currentBin) {
+        emit();
+        currentBin = bin;
+        count = 0;
+        min.fill(Infinity);
+        max.fill(-Infinity);
+        sum.fill(0);
+      }
+
+      const base = slot * SIGNALS.length;
+      const bucketCount = level.counts[slot];
+      indices.forEach((index, j) => {
+        min[j] = Math.min(min[j], level.min[base + index]);
+        max[j] = Math.max(max[j], level.max[base + index]);
+        sum[j] += level.sum[base + index];
+      });
+      count += bucketCount;
+    }
+    emit();
+
+    return result;
+  }
+
+  describe() {
+    return {
+      signals: SIGNALS,
+      latest: this.latest === null ? null : this.latest / 1e9,
+      records: this.records,
+      levels: this.levels.map((level) => ({
+        widthMs: level.widthNs / 1e6,
+        start: level.last < 0 ? null : (level.first * level.widthNs) / 1e9,
+      })),
+    };
+  }
+}
+
+module.exports = { TelemetryPyramid, SIGNALS };
@@ -1,13 +1,48 @@
 const fs = require("fs");
 const readState = require("./state-reader.js");
+const { modes } = require("./state-codec.js");
+const {
+  CommandQueue,
+  COMMAND_SET_STATE,
+  COMMAND_SET_PARAMETER,
+  COMMAND_SAVE_PARAMETERS,
+  COMMAND_START_TRACE,
+  COMMAND_STOP_TRACE,
+  COMMAND_START_PROFILE,
+  COMMAND_STOP_PROFILE,
+  COMMAND_START_RECORDING,
+  COMMAND_STOP_RECORDING,
+  COMMAND_QUIT,
+} = require("./command.js");
+const { ParameterTable, definitions } = require("./parameter.js");
 
 const sharedMemoryPath = "/dev/shm/state";
 const sharedMemorySize = 4096;
+const pollingInterval = 100;
+
+const generationIndex = readState.fields.indexOf("generation");
 
 const STATUS_INITIALIZING = "INITIALIZING";
 const STATUS_INITIALIZED = "INITIALIZED";
 const STATUS_ERROR = "ERROR";
 
+// Text commands sent by the UI, mapped to typed commands
+const textCommands = {
+  idle: [COMMAND_SET_STATE, modes.IDLE],
+  cali_low: [COMMAND_SET_STATE, modes.CALI_LOW],
+  cali_high: [COMMAND_SET_STATE, modes.CALI_HIGH],
+  cali_save: [COMMAND_SET_STATE, modes.IDLE],
+  drive: [COMMAND_SET_STATE, modes.DRIVE],
+  jitter: [COMMAND_SET_STATE, modes.JITTER],
+  trace_start: [COMMAND_START_TRACE, 0],
+  trace_stop: [COMMAND_STOP_TRACE, 0],
+  profile_start: [COMMAND_START_PROFILE, 0],
+  profile_stop: [COMMAND_STOP_PROFILE, 0],
+  record_start: [COMMAND_START_RECORDING, 0],
+  record_stop: [COMMAND_STOP_RECORDING, 0],
+  quit: [COMMAND_QUIT, 0],
+};
+
 class Robot {
   constructor() {
     this.status = STATUS_INITIALIZING;
@@ -15,6 +50,8 @@ class Robot {
     this.state = {};
     this.shmFd = null;
     this.shmBuffer = Buffer.alloc(sharedMemorySize);
+    this.notifyBuffer = Buffer.alloc(8);
+    this.generation = -1;
     this.inputBuffer = "";
     this.listeners = [];
 
@@ -35,17 +72,40 @@ class Robot {
       }
     }
 
-    // Setup pipe
-    const [readPipeFd, writePipeFd] = process.argv[2].split(",");
+    // Setup pipe and notifications
+    const [readPipeFd, notifyFd, commandNotifyFd] = process.argv[2].split(",");
     this.readPipeFd = +readPipeFd;
-    this.writePipeFd = +writePipeFd;
+    this.notifyFd = +notifyFd;
+    this.commands = new CommandQueue(+commandNotifyFd);
+    this.parameters = new ParameterTable();
 
     // Configure read pipe handler
     const readStream = fs.createReadStream(null, { fd: this.readPipeFd });
     readStream.on("data", (data) => this.handleInput(data.toString()));
 
     // Setup state change handler
-    setInterval(() => this.handleStateChange(), 100);
+    this.waitStateChange();
+  }
+
+  waitStateChange() {
+    // The blocking read runs on a libuv worker thread, so the event loop is
+    // only woken up when a new state frame has been published.
+    // The C side also signals it after acknowledging commands.
+    fs.read(this.notifyFd, this.notifyBuffer, 0, 8, null, (err) => {
+      if (err) {
+        console.error("State notification failed, falling back to polling");
+        setInterval(() => this.handleWake(), pollingInterval);
+        return;
+      }
+      this.handleWake();
+      this.waitStateChange();
+    });
+  }
+
+  handleWake() {
+    this.handleStateChange();
+    this.commands.pollAcks();
+    this.handleParameterChange();
   }
 
   handleInput(input) {
@@ -58,6 +118,9 @@ class Robot {
         const match = this.inputBuffer.match(regex);
         if (match) {
           this.offsets = match[1].split(",").map((x) => +x);
+          if (this.offsets.join(",") !== readState.offsets.join(",")) {
+            console.error("State layout mismatch, re-run state-gen");
+          }
           this.status = STATUS_INITIALIZED;
         }
         break;
@@ -79,18 +142,32 @@ class Robot {
   }
 
   handleStateChange() {
-    const newBuffer = Buffer.alloc(sharedMemorySize);
-    fs.readSync(this.shmFd, newBuffer, 0, sharedMemorySize, 0);
+    if (this.status !== STATUS_INITIALIZED) return;
+    fs.readSync(this.shmFd, this.shmBuffer, 0, sharedMemorySize, 0);
 
-    // Check if the buffer has changed
-    if (newBuffer.equals(this.shmBuffer)) return;
-    this.shmBuffer = newBuffer;
+    // The C side bumps the generation counter whenever it publishes a
+    // changed frame, so there is no need to compare the whole buffer.
+    const generation = this.shmBuffer.readUInt32LE(
+      this.offsets[generationIndex]
+    );
+    if (generation === this.generation) return;
+    this.generation = generation;
 
     const newState = readState(this.shmBuffer, this.offsets);
     this.state = newState;
     this.notify({ type: "state", data: this.state });
   }
 
+  handleParameterChange() {
+    if (this.status !== STATUS_INITIALIZED) return;
+    if (!this.parameters.update()) return;
+    this.notify({ type: "parameters", data: this.parameterMessage() });
+  }
+
+  parameterMessage() {
+    return { definitions, values: this.parameters.values };
+  }
+
   notify(event) {
     this.listeners.forEach((listener) => listener(event));
   }
@@ -101,6 +178,7 @@ class Robot {
     if (this.status === STATUS_INITIALIZED) {
       this.notify({ type: "state", data: this.state });
       this.notify({ type: "input", data: this.inputBuffer });
+      this.notify({ type: "parameters", data: this.parameterMessage() });
     }
   }
 
@@ -108,9 +186,44 @@ class Robot {
     this.listeners = this.listeners.filter((l) => l !== listener);
   }
 
-  sendCommand(command) {
+  sendCommand(command, timestamp = process.hrtime.bigint()) {
     if (this.status !== STATUS_INITIALIZED) return;
-    fs.writeSync(this.writePipeFd, command + "\n");
+
+    const typed = textCommands[command];
+    if (typed === undefined) {
+      console.error(`Unknown command: ${command}`);
+      return;
+    }
+
+    const [type, id] = typed;
+    this.sendTyped(command, type, id, 0, timestamp);
+  }
+
+  setParameter(name, value, timestamp = process.hrtime.bigint()) {
+    if (this.status !== STATUS_INITIALIZED) return;
+
+    const index = this.parameters.indexOf(name);
+    if (index === -1 || typeof value !== "number") {
+      console.error(`Invalid parameter: ${name}=${value}`);
+      return;
+    }
+    this.sendTyped(`${name}=${value}`, COMMAND_SET_PARAMETER, index, value, timestamp);
+  }
+
+  saveParameters(timestamp = process.hrtime.bigint()) {
+    if (this.status !== STATUS_INITIALIZED) return;
+    this.sendTyped("save_parameters", COMMAND_SAVE_PARAMETERS, 0, 0, timestamp);
+  }
+
+  sendTyped(label, type, id, value, timestamp) {
+    this.commands
+      .send(type, id, value, timestamp)
+      .then(({ statusName, latencyNs }) => {
+        console.log(
+          `Command ${label}: ${statusName} in ${(latencyNs / 1000).toFixed(0)}us`
+        );
+      })
+      .catch((err) => console.error(`Command ${label}: ${err.message}`));
   }
 }
 
@@ -0,0 +1,430 @@
+const fs = require("fs/promises");
+const path = require("path");
+const stateCodec = require("./state-codec");
+
+// Drive sessions are recorded to SESSION_PATH/<name>.ses, an append-only
+// file of chunks, with a <name>.idx of one entry per chunk:
+//
+//   file header  magic "RPISES1\0", u32 version, u32 schema version,
+//                f64 start time (ms since epoch), padded to 64 bytes
+//   chunk        u32 CHUNK_MAGIC, u32 records, u32 payload bytes,
+//                u32 reserved, f64 first time, f64 last time, records
+//   record       u8 kind, 3 bytes padding, u32 length, f64 time, payload
+//   index entry  f64 chunk offset, f64 first time, f64 last time
+//
+// The first state record of every chunk is a full state delta, so any chunk
+// can be decoded on its own. Only the chunk being written is held in
+// memory. The index can be rebuilt from the chunk headers if it is lost.
+//
+// All file access is asynchronous, so that it never stalls the event loop
+// that pushes state to the clients. Recording queues its writes in order.
+
+const SESSION_PATH = "sessions";
+const SESSION_MAX_COUNT = 100; // The oldest sessions are deleted beyond it
+
+const FILE_MAGIC = "RPISES1\0";
+const FILE_VERSION = 1;
+const FILE_HEADER_SIZE = 64;
+const CHUNK_MAGIC = 0x4b4e4843; // "CHNK"
+const CHUNK_HEADER_SIZE = 32;
+const RECORD_HEADER_SIZE = 16;
+const INDEX_ENTRY_SIZE = 24;
+
+const CHUNK_MAX_BYTES = 64 * 1024;
+const CHUNK_MAX_AGE = 1000; // ms
+
+const RECORD_STATE = 1; // Payload is a state delta message
+const RECORD_INPUT = 2; // Payload is log text
+const RECORD_COMMAND = 3; // Payload is a command as received from a client
+
+const REPLAY_BATCH = 64; // Records sent before yielding to the event loop
+const REPLAY_RETRY_INTERVAL = 20; // ms to wait while the client is over budget
+
+class SessionRecorder {
+  constructor() {
+    this.name = null;
+    this.isActive = false;
+    this.file = null;
+    this.indexFile = null;
+    this.writes = Promise.resolve();
+    this.offset = 0;
+    this.records = [];
+    this.bytes = 0;
+    this.needsKeyframe = true;
+  }
+
+  isRecording() {
+    return this.isActive;
+  }
+
+  start(state) {
+    if (this.isRecording()) return;
+    this.isActive = true;
+    this.offset = FILE_HEADER_SIZE;
+    this.records = [];
+    this.bytes = 0;
+    this.needsKeyframe = true;
+
+    const startTime = Date.now();
+    this.enqueue(() => this.open(startTime));
+    this.flushTimer = setInterval(() => this.flush(), CHUNK_MAX_AGE);
+    if (state !== null) this.recordState(null, state);
+  }
+
+  // Sessions are named after their start time. A session that starts in the
+  // same second as an earlier one gets a suffix instead of replacing it.
+  async open(startTime) {
+    await fs.mkdir(SESSION_PATH, { recursive: true });
+    await pruneSessions(SESSION_MAX_COUNT - 1);
+
+    const date = new Date(startTime);
+    const pad = (value) => String(value).padStart(2, "0");
+    const base =
+      `${date.getFullYear()}${pad(date.getMonth() + 1)}${pad(date.getDate())}-` +
+      `${pad(date.getHours())}${pad(date.getMinutes())}${pad(date.getSeconds())}`;
+    for (let i = 0; this.file === null; i++) {
+      const name = i === 0 ? base : `${base}-${i}`;
+      try {
+        this.file = await fs.open(sessionPath(name, ".ses"), "wx");
+        this.name = name;
+      } catch (err) {
+        if (err.code !== "EEXIST") throw err;
+      }
+    }
+    this.indexFile = await fs.open(sessionPath(this.name, ".idx"), "w");
+
+    const header = Buffer.alloc(FILE_HEADER_SIZE);
+    header.write(FILE_MAGIC, 0, "latin1");
+    header.writeUInt32LE(FILE_VERSION, 8);
+    header.writeUInt32LE(stateCodec.schema.version, 12);
+    header.writeDoubleLE(startTime, 16);
+    await this.file.write(header);
+    console.log(`Recording session ${this.name}`);
+  }
+
+  stop() {
+    if (!this.isRecording()) return;
+    clearInterval(this.flushTimer);
+    this.flush();
+    this.isActive = false;
+    this.enqueue(async () => {
+      if (this.file !== null) await this.file.close();
+      if (this.indexFile !== null) await this.indexFile.close();
+      if (this.name !== null) console.log(`Session ${this.name} recorded`);
+      this.file = null;
+      this.indexFile = null;
+      this.name = null;
+    });
+  }
+
+  // Runs file operations one after the other, off the caller's path
+  enqueue(task) {
+    this.writes = this.writes.then(task).catch((err) => {
+      console.error(`Session ${this.name}: ${err.message}`);
+    });
+  }
+
+  // message is the delta from prevState to state, re-encoded in full at the
+  // start of every chunk
+  recordState(message, state) {
+    if (!this.isRecording()) return;
+    if (this.needsKeyframe || message === null) {
+      message = stateCodec.encode_state_delta(null, state);
+      this.needsKeyframe = false;
+    }
+    this.record(RECORD_STATE, message);
+  }
+
+  recordInput(text) {
+    this.record(RECORD_INPUT, Buffer.from(text));
+  }
+
+  recordCommand(command) {
+    this.record(RECORD_COMMAND, Buffer.from(command));
+  }
+
+  record(kind, payload) {
+    if (!this.isRecording()) return;
+    const header = Buffer.alloc(RECORD_HEADER_SIZE);
+    header.writeUInt8(kind, 0);
+    header.writeUInt32LE(payload.length, 4);
+    header.writeDoubleLE(Date.now(), 8);
+    this.records.push(header, payload);
+    this.bytes += RECORD_HEADER_SIZE + payload.length;
+    if (this.bytes >= CHUNK_MAX_BYTES) this.flush();
+  }
+
+  flush() {
+    if (this.records.length === 0) return;
+
+    const count = this.records.length / 2;
+    const firstTime = this.records[0].readDoubleLE(8);
+    const lastTime = this.records[this.records.length - 2].readDoubleLE(8);
+    const header = Buffer.alloc(CHUNK_HEADER_SIZE);
+    header.writeUInt32LE(CHUNK_MAGIC, 0);
+    header.writeUInt32LE(count, 4);
+    header.writeUInt32LE(this.bytes, 8);
+    header.writeDoubleLE(firstTime, 16);
+    header.writeDoubleLE(lastTime, 24);
+    const chunk = Buffer.concat([header, ...this.records]);
+
+    const entry = Buffer.alloc(INDEX_ENTRY_SIZE);
+    entry.writeDoubleLE(this.offset, 0);
+    entry.writeDoubleLE(firstTime, 8);
+    entry.writeDoubleLE(lastTime, 16);
+
+    // The index entry only after the chunk, so it never points past the end
+    this.enqueue(async () => {
+      if (this.file === null) return;
+      await this.file.write(chunk);
+      await this.indexFile.write(entry);
+    });
+
+    this.offset += chunk.length;
+    this.records = [];
+    this.bytes = 0;
+    this.needsKeyframe = true;
+  }
+}
+
+function sessionPath(name, extension) {
+  if (!/^[0-9-]+$/.test(name)) throw new Error(`Invalid session: ${name}`);
+  return path.join(SESSION_PATH, `${name}${extension}`);
+}
+
+async function readIndex(name) {
+  let data = null;
+  try {
+    data = await fs.readFile(sessionPath(name, ".idx"));
+  } catch (err) {
+    if (err.code !== "ENOENT") throw err;
+  }
+  if (data !== null) {
+    const entries = [];
+    for (let i = 0; i + INDEX_ENTRY_SIZE <= data.length; i += INDEX_ENTRY_SIZE) {
+      entries.push({
+        offset: data.readDoubleLE(i),
+        firstTime: data.readDoubleLE(i + 8),
+        lastTime: data.readDoubleLE(i + 16),
+      });
+    }
+    return entries;
+  }
+
+  // Rebuild from the chunk headers
+  const file = await fs.open(sessionPath(name, ".ses"), "r");
+  const entries = [];
+  try {
+    const { size } = await file.stat();
+    const header = Buffer.alloc(CHUNK_HEADER_SIZE);
+    for (let offset = FILE_HEADER_SIZE; offset + CHUNK_HEADER_SIZE <= size; ) {
+      await file.read(header, 0, CHUNK_HEADER_SIZE, offset);
+      if (header.readUInt32LE(0) !== CHUNK_MAGIC) break;
+      const bytes = header.readUInt32LE(8);
+      if (offset + CHUNK_HEADER_SIZE + bytes > size) break;
+      entries.push({ offset, firstTime: header.readDoubleLE(16), lastTime: header.readDoubleLE(24) });
+      offset += CHUNK_HEADER_SIZE + bytes;
+    }
+  } finally {
+    await file.close();
+  }
+  return entries;
+}
+
+// Sessions recorded with another state schema cannot be decoded
+async function checkHeader(file) {
+  const header = Buffer.alloc(FILE_HEADER_SIZE);
+  const { bytesRead } = await file.read(header, 0, FILE_HEADER_SIZE, 0);
+  if (bytesRead < FILE_HEADER_SIZE || header.toString("latin1", 0, 8) !== FILE_MAGIC) {
+    throw new Error("Not a session file");
+  }
+  if (header.readUInt32LE(8) !== FILE_VERSION) {
+    throw new Error(`Unsupported session version ${header.readUInt32LE(8)}`);
+  }
+  if (header.readUInt32LE(12) !== stateCodec.schema.version) {
+    throw new Error("Session was recorded with another state schema");
+  }
+}
+
+async function readChunk(file, entry) {
+  const header = Buffer.alloc(CHUNK_HEADER_SIZE);
+  await file.read(header, 0, CHUNK_HEADER_SIZE, entry.offset);
+  if (header.readUInt32LE(0) !== CHUNK_MAGIC) throw new Error("Corrupt session chunk");
+  const payload = Buffer.alloc(header.readUInt32LE(8));
+  await file.read(payload, 0, payload.length, entry.offset + CHUNK_HEADER_SIZE);
+  return payload;
+}
+
+function* parseRecords(payload) {
+  for (let offset = 0; offset + RECORD_HEADER_SIZE <= payload.length; ) {
+    const length = payload.readUInt32LE(offset + 4);
+    const end = offset + RECORD_HEADER_SIZE + length;
+    yield {
+      kind: payload.readUInt8(offset),
+      time: payload.readDoubleLE(offset + 8),
+      payload: payload.subarray(offset + RECORD_HEADER_SIZE, end),
+      raw: payload.subarray(offset, end),
+    };
+    offset = end;
+  }
+}
+
+async function listSessions() {
+  let names;
+  try {
+    names = (await fs.readdir(SESSION_PATH)).filter((file) => file.endsWith(".ses"));
+  } catch (err) {
+    if (err.code === "ENOENT") return [];
+    throw err;
+  }
+  const sessions = await Promise.all(
+    names.map(async (file) => {
+      const name = file.slice(0, -4);
+      const index = await readIndex(name);
+      return {
+        name,
+        start: index.length > 0 ? index[0].firstTime : null,
+        end: index.length > 0 ? index[index.length - 1].lastTime : null,
+        chunks: index.length,
+        bytes: (await fs.stat(sessionPath(name, ".ses"))).size,
+      };
+    })
+  );
+  return sessions.sort((a, b) => a.name.localeCompare(b.name));
+}
+
+async function pruneSessions(keep) {
+  const sessions = await listSessions();
+  for (const session of sessions.slice(0, Math.max(0, sessions.length - keep))) {
+    await fs.rm(sessionPath(session.name, ".ses"), { force: true });
+    await fs.rm(sessionPath(session.name, ".idx"), { force: true });
+  }
+}
+
+// Resolves once out can take more data, or is closed
+function drained(out) {
+  return new Promise((resolve) => {
+    const done = () => {
+      out.off("drain", done);
+      out.off("close", done);
+      resolve();
+    };
+    out.on("drain", done);
+    out.on("close", done);
+  });
+}
+
+// Writes the records of the chunks that overlap [start, end] (ms since
+// epoch) to the stream out and ends it, from the start of the first chunk
+// so that it begins with a full state, in the record format of the session
+// file. One chunk is held at a time: the next one is read once out has
+// drained, so memory stays bounded however long the range. Stops early if
+// out is closed.
+async function writeSessionRange(name, start, end, out) {
+  const chunks = (await readIndex(name)).filter((entry) => entry.lastTime >= start && entry.firstTime <= end);
+  const file = await fs.open(sessionPath(name, ".ses"), "r");
+  try {
+    for (const entry of chunks) {
+      if (out.destroyed) return;
+      const parts = [];
+      for (const record of parseRecords(await readChunk(file, entry))) {
+        if (record.time > end) break;
+        parts.push(record.raw);
+      }
+      if (parts.length > 0 && !out.write(Buffer.concat(parts))) {
+        await drained(out);
+      }
+    }
+  } finally {
+    await file.close();
+  }
+  out.end();
+}
+
+// Pushes a recorded session to one client as the live events would be,
+// reading one chunk at a time. send() returns false while the client is over
+// its send budget; the replay then waits and its clock stops meanwhile, so
+// that it neither floods the socket nor skips state deltas. onEnd() gets the
+// error that ended the replay, if any.
+class Replay {
+  constructor(name, speed, send, onEnd) {
+    this.name = name;
+    this.speed = speed > 0 ? speed : 1;
+    this.send = send;
+    this.onEnd = onEnd;
+    this.isStopped = false;
+    this.timer = null;
+    this.wake = null;
+    this.run();
+  }
+
+  async run() {
+    let error = null;
+    let file = null;
+    try {
+      file = await fs.open(sessionPath(this.name, ".ses"), "r");
+      await checkHeader(file);
+      const index = await readIndex(this.name);
+
+      // Replay time runs from the first record at the given speed
+      const startTime = index.length > 0 ? index[0].firstTime : 0;
+      let startedAt = Date.now();
+      let sentSinceYield = 0;
+      for (const entry of index) {
+        const payload = await readChunk(file, entry);
+        for (const record of parseRecords(payload)) {
+          if (this.isStopped) return;
+
+          const delay = startedAt + (record.time - startTime) / this.speed - Date.now();
+          if (delay > 0) {
+            await this.sleep(delay);
+            sentSinceYield = 0;
+          } else if (sentSinceYield >= REPLAY_BATCH) {
+            await this.sleep(0);
+            sentSinceYield = 0;
+          }
+          while (!this.isStopped && !this.emit(record)) {
+            const pausedAt = Date.now();
+            await this.sleep(REPLAY_RETRY_INTERVAL);
+            startedAt += Date.now() - pausedAt;
+          }
+          sentSinceYield++;
+        }
+      }
+    } catch (err) {
+      error = err;
+    } finally {
+      if (file !== null) await file.close();
+      if (!this.isStopped) {
+        this.isStopped = true;
+        this.onEnd(error);
+      }
+    }
+  }
+
+  // Returns false if the record has to be sent again later
+  emit(record) {
+    if (record.kind === RECORD_STATE) return this.send(record.payload);
+    if (record.kind === RECORD_INPUT) {
+      return this.send(JSON.stringify({ type: "input", data: record.payload.toString() }));
+    }
+    return true;
+  }
+
+  sleep(ms) {
+    return new Promise((resolve) => {
+      this.wake = resolve;
+      this.timer = setTimeout(resolve, ms);
+    });
+  }
+
+  stop() {
+    if (this.isStopped) return;
+    this.isStopped = true;
+    clearTimeout(this.timer);
+    if (this.wake !== null) this.wake();
+    this.onEnd(null);
+  }
+}
+
+module.exports = { SessionRecorder, listSessions, writeSessionRange, Replay };
@@ -0,0 +1,186 @@
+// This file is automatically generated by state-gen script
+// Do not edit this file manually
+const STATE_MESSAGE_DELTA = 0x01;
+const modes = { HALT: 0x00, IDLE: 0x01, CALI_HIGH: 0x02, CALI_LOW: 0x04, DRIVE: 0x08, MUSIC: 0x10, JITTER: 0x20 };
+const schema = {"version": 3783565041, "fields": [["state", "uint32", 1], ["generation", "uint32", 1], ["boot_time_ms", "uint32", 1], ["sensor_low", "uint16", 16], ["sensor_high", "uint16", 16], ["sensor_raw", "uint16", 16], ["sensor_data", "double", 16], ["position", "double", 1], ["speed", "double", 1], ["battery_voltage", "double", 1], ["track", "uint8", 1], ["input_age_histogram", "uint32", 16], ["input_age_max_us", "uint32", 1], ["encoder_left", "int32", 1], ["encoder_right", "int32", 1], ["encoder_rate", "uint32", 1], ["health_minor_faults", "uint32", 8], ["health_major_faults", "uint32", 8], ["health_voluntary_switches", "uint32", 8], ["health_involuntary_switches", "uint32", 8], ["health_migrations", "uint32", 8], ["health_cpu_time_ms", "uint32", 8], ["health_names", "uint8", 128]]};
+const parameters = [{"name": "drive_speed", "default": 15, "min": 0, "max": 40}, {"name": "drive_curvature", "default": 1.5, "min": 0, "max": 5}, {"name": "drive_acceleration", "default": 20, "min": 0, "max": 100}, {"name": "drive_brake_acceleration", "default": 40, "min": 0, "max": 200}, {"name": "drive_kp", "default": 3.0, "min": 0, "max": 50}, {"name": "drive_ki", "default": 100.0, "min": 0, "max": 1000}, {"name": "drive_kd", "default": 0.0, "min": 0, "max": 10}, {"name": "jitter_period_us", "default": 1000, "min": 50, "max": 100000}, {"name": "jitter_stress_threads", "default": 0, "min": 0, "max": 8}, {"name": "health_preemption_threshold", "default": 10, "min": 0, "max": 1000}, {"name": "health_warning_interval_s", "default": 60, "min": 0, "max": 3600}];
+const scratch = Buffer.alloc(2673);
+
+function encode_state_delta(prev, next) {
+  let offset = 3;
+  let count = 0;
+  if (prev === null || prev.state !== next.state) {
+    scratch.writeUInt16LE(0, offset);
+    scratch.writeUInt32LE(next.state, offset + 2);
+    offset += 6;
+    count++;
+  }
+  if (prev === null || prev.generation !== next.generation) {
+    scratch.writeUInt16LE(1, offset);
+    scratch.writeUInt32LE(next.generation, offset + 2);
+    offset += 6;
+    count++;
+  }
+  if (prev === null || prev.boot_time_ms !== next.boot_time_ms) {
+    scratch.writeUInt16LE(2, offset);
+    scratch.writeUInt32LE(next.boot_time_ms, offset + 2);
+    offset += 6;
+    count++;
+  }
+  for (let j = 0; j < 16; j++) {
+    if (prev === null || prev.sensor_low[j] !== next.sensor_low[j]) {
+      scratch.writeUInt16LE(3 + j, offset);
+      scratch.writeUInt16LE(next.sensor_low[j], offset + 2);
+      offset += 4;
+      count++;
+    }
+  }
+  for (let j = 0; j < 16; j++) {
+    if (prev === null || prev.sensor_high[j] !== next.sensor_high[j]) {
+      scratch.writeUInt16LE(19 + j, offset);
+      scratch.writeUInt16LE(next.sensor_high[j], offset + 2);
+      offset += 4;
+      count++;
+    }
+  }
+  for (let j = 0; j < 16; j++) {
+    if (prev === null || prev.sensor_raw[j] !== next.sensor_raw[j]) {
+      scratch.writeUInt16LE(35 + j, offset);
+      scratch.writeUInt16LE(next.sensor_raw[j], offset + 2);
+      offset += 4;
+      count++;
+    }
+  }
+  for (let j = 0; j < 16; j++) {
+    if (prev === null || prev.sensor_data[j] !== next.sensor_data[j]) {
+      scratch.writeUInt16LE(51 + j, offset);
+      scratch.writeDoubleLE(next.sensor_data[j], offset + 2);
+      offset += 10;
+      count++;
+    }
+  }
+  if (prev === null || prev.position !== next.position) {
+    scratch.writeUInt16LE(67, offset);
+    scratch.writeDoubleLE(next.position, offset + 2);
+    offset += 10;
+    count++;
+  }
+  if (prev === null || prev.speed !== next.speed) {
+    scratch.writeUInt16LE(68, offset);
+    scratch.writeDoubleLE(next.speed, offset + 2);
+    offset += 10;
+    count++;
+  }
+  if (prev === null || prev.battery_voltage !== next.battery_voltage) {
+    scratch.writeUInt16LE(69, offset);
+    scratch.writeDoubleLE(next.battery_voltage, offset + 2);
+    offset += 10;
+    count++;
+  }
+  if (prev === null || prev.track !== next.track) {
+    scratch.writeUInt16LE(70, offset);
+    scratch.writeUInt8(next.track, offset + 2);
+    offset += 3;
+    count++;
+  }
+  for (let j = 0; j < 16; j++) {
+    if (prev === null || prev.input_age_histogram[j] !== next.input_age_histogram[j]) {
+      scratch.writeUInt16LE(71 + j, offset);
+      scratch.writeUInt32LE(next.input_age_histogram[j], offset + 2);
+      offset += 6;
+      count++;
+    }
+  }
+  if (prev === null || prev.input_age_max_us !== next.input_age_max_us) {
+    scratch.writeUInt16LE(87, offset);
+    scratch.writeUInt32LE(next.input_age_max_us, offset + 2);
+    offset += 6;
+    count++;
+  }
+  if (prev === null || prev.encoder_left !== next.encoder_left) {
+    scratch.writeUInt16LE(88, offset);
+    scratch.writeInt32LE(next.encoder_left, offset + 2);
+    offset += 6;
+    count++;
+  }
+  if (prev === null || prev.encoder_right !== next.encoder_right) {
+    scratch.writeUInt16LE(89, offset);
+    scratch.writeInt32LE(next.encoder_right, offset + 2);
+    offset += 6;
+    count++;
+  }
+  if (prev === null || prev.encoder_rate !== next.encoder_rate) {
+    scratch.writeUInt16LE(90, offset);
+    scratch.writeUInt32LE(next.encoder_rate, offset + 2);
+    offset += 6;
+    count++;
+  }
+  for (let j = 0; j < 8; j++) {
+    if (prev === null || prev.health_minor_faults[j] !== next.health_minor_faults[j]) {
+      scratch.writeUInt16LE(91 + j, offset);
+      scratch.writeUInt32LE(next.health_minor_faults[j], offset + 2);
+      offset += 6;
+      count++;
+    }
+  }
+  for (let j = 0; j < 8; j++) {
+    if (prev === null || prev.health_major_faults[j] !== next.health_major_faults[j]) {
+      scratch.writeUInt16LE(99 + j, offset);
+      scratch.writeUInt32LE(next.health_major_faults[j], offset + 2);
+      offset += 6;
+      count++;
+    }
+  }
+  for (let j = 0; j < 8; j++) {
+    if (prev === null || prev.health_voluntary_switches[j] !== next.health_voluntary_switches[j]) {
+      scratch.writeUInt16LE(107 + j, offset);
+      scratch.writeUInt32LE(next.health_voluntary_switches[j], offset + 2);
+      offset += 6;
+      count++;
+    }
+  }
+  for (let j = 0; j < 8; j++) {
+    if (prev === null || prev.health_involuntary_switches[j] !== next.health_involuntary_switches[j]) {
+      scratch.writeUInt16LE(115 + j, offset);
+      scratch.writeUInt32LE(next.health_involuntary_switches[j], offset + 2);
+      offset += 6;
+      count++;
+    }
+  }
+  for (let j = 0; j < 8; j++) {
+    if (prev === null || prev.health_migrations[j] !== next.health_migrations[j]) {
+      scratch.writeUInt16LE(123 + j, offset);
+      scratch.writeUInt32LE(next.health_migrations[j], offset + 2);
+      offset += 6;
+      count++;
+    }
+  }
+  for (let j = 0; j < 8; j++) {
+    if (prev === null || prev.health_cpu_time_ms[j] !== next.health_cpu_time_ms[j]) {
+      scratch.writeUInt16LE(131 + j, offset);
+      scratch.writeUInt32LE(next.health_cpu_time_ms[j], offset + 2);
+      offset += 6;
+      count++;
+    }
+  }
+  for (let j = 0; j < 128; j++) {
+    if (prev === null || prev.health_names[j] !== next.health_names[j]) {
+      scratch.writeUInt16LE(139 + j, offset);
+      scratch.writeUInt8(next.health_names[j], offset + 2);
+      offset += 3;
+      count++;
+    }
+  }
+  if (count === 0) return null;
+  scratch.writeUInt8(STATE_MESSAGE_DELTA, 0);
+  scratch.writeUInt16LE(count, 1);
+  return Buffer.from(scratch.subarray(0, offset));
+}
+
+module.exports = {
+  STATE_MESSAGE_DELTA,
+  modes,
+  schema,
+  parameters,
+  encode_state_delta,
+};
@@ -1,80 +1,286 @@
 function read_state(buffer, offsets) {
   const state = {};
   state.state = buffer.readUInt32LE(offsets[0]);
+  state.generation = buffer.readUInt32LE(offsets[1]);
+  state.boot_time_ms = buffer.readUInt32LE(offsets[2]);
   state.sensor_low = [];
-  state.sensor_low[0] = buffer.readUInt16LE(offsets[1] + 0);
-  state.sensor_low[1] = buffer.readUInt16LE(offsets[1] + 2);
-  state.sensor_low[2] = buffer.readUInt16LE(offsets[1] + 4);
-  state.sensor_low[3] = buffer.readUInt16LE(offsets[1] + 6);
-  state.sensor_low[4] = buffer.readUInt16LE(offsets[1] + 8);
-  state.sensor_low[5] = buffer.readUInt16LE(offsets[1] + 10);
-  state.sensor_low[6] = buffer.readUInt16LE(offsets[1] + 12);
-  state.sensor_low[7] = buffer.readUInt16LE(offsets[1] + 14);
-  state.sensor_low[8] = buffer.readUInt16LE(offsets[1] + 16);
-  state.sensor_low[9] = buffer.readUInt16LE(offsets[1] + 18);
-  state.sensor_low[10] = buffer.readUInt16LE(offsets[1] + 20);
-  state.sensor_low[11] = buffer.readUInt16LE(offsets[1] + 22);
-  state.sensor_low[12] = buffer.readUInt16LE(offsets[1] + 24);
-  state.sensor_low[13] = buffer.readUInt16LE(offsets[1] + 26);
-  state.sensor_low[14] = buffer.readUInt16LE(offsets[1] + 28);
-  state.sensor_low[15] = buffer.readUInt16LE(offsets[1] + 30);
+  state.sensor_low[0] = buffer.readUInt16LE(offsets[3] + 0);
+  state.sensor_low[1] = buffer.readUInt16LE(offsets[3] + 2);
+  state.sensor_low[2] = buffer.readUInt16LE(offsets[3] + 4);
+  state.sensor_low[3] = buffer.readUInt16LE(offsets[3] + 6);
+  state.sensor_low[4] = buffer.readUInt16LE(offsets[3] + 8);
+  state.sensor_low[5] = buffer.readUInt16LE(offsets[3] + 10);
+  state.sensor_low[6] = buffer.readUInt16LE(offsets[3] + 12);
+  state.sensor_low[7] = buffer.readUInt16LE(offsets[3] + 14);
+  state.sensor_low[8] = buffer.readUInt16LE(offsets[3] + 16);
+  state.sensor_low[9] = buffer.readUInt16LE(offsets[3] + 18);
+  state.sensor_low[10] = buffer.readUInt16LE(offsets[3] + 20);
+  state.sensor_low[11] = buffer.readUInt16LE(offsets[3] + 22);
+  state.sensor_low[12] = buffer.readUInt16LE(offsets[3] + 24);
+  state.sensor_low[13] = buffer.readUInt16LE(offsets[3] + 26);
+  state.sensor_low[14] = buffer.readUInt16LE(offsets[3] + 28);
+  state.sensor_low[15] = buffer.readUInt16LE(offsets[3] + 30);
   state.sensor_high = [];
-  state.sensor_high[0] = buffer.readUInt16LE(offsets[2] + 0);
-  state.sensor_high[1] = buffer.readUInt16LE(offsets[2] + 2);
-  state.sensor_high[2] = buffer.readUInt16LE(offsets[2] + 4);
-  state.sensor_high[3] = buffer.readUInt16LE(offsets[2] + 6);
-  state.sensor_high[4] = buffer.readUInt16LE(offsets[2] + 8);
-  state.sensor_high[5] = buffer.readUInt16LE(offsets[2] + 10);
-  state.sensor_high[6] = buffer.readUInt16LE(offsets[2] + 12);
-  state.sensor_high[7] = buffer.readUInt16LE(offsets[2] + 14);
-  state.sensor_high[8] = buffer.readUInt16LE(offsets[2] + 16);
-  state.sensor_high[9] = buffer.readUInt16LE(offsets[2] + 18);
-  state.sensor_high[10] = buffer.readUInt16LE(offsets[2] + 20);
-  state.sensor_high[11] = buffer.readUInt16LE(offsets[2] + 22);
-  state.sensor_high[12] = buffer.readUInt16LE(offsets[2] + 24);
-  state.sensor_high[13] = buffer.readUInt16LE(offsets[2] + 26);
-  state.sensor_high[14] = buffer.readUInt16LE(offsets[2] + 28);
-  state.sensor_high[15] = buffer.readUInt16LE(offsets[2] + 30);
+  state.sensor_high[0] = buffer.readUInt16LE(offsets[4] + 0);
+  state.sensor_high[1] = buffer.readUInt16LE(offsets[4] + 2);
+  state.sensor_high[2] = buffer.readUInt16LE(offsets[4] + 4);
+  state.sensor_high[3] = buffer.readUInt16LE(offsets[4] + 6);
+  state.sensor_high[4] = buffer.readUInt16LE(offsets[4] + 8);
+  state.sensor_high[5] = buffer.readUInt16LE(offsets[4] + 10);
+  state.sensor_high[6] = buffer.readUInt16LE(offsets[4] + 12);
+  state.sensor_high[7] = buffer.readUInt16LE(offsets[4] + 14);
+  state.sensor_high[8] = buffer.readUInt16LE(offsets[4] + 16);
+  state.sensor_high[9] = buffer.readUInt16LE(offsets[4] + 18);
+  state.sensor_high[10] = buffer.readUInt16LE(offsets[4] + 20);
+  state.sensor_high[11] = buffer.readUInt16LE(offsets[4] + 22);
+  state.sensor_high[12] = buffer.readUInt16LE(offsets[4] + 24);
+  state.sensor_high[13] = buffer.readUInt16LE(offsets[4] + 26);
+  state.sensor_high[14] = buffer.readUInt16LE(offsets[4] + 28);
+  state.sensor_high[15] = buffer.readUInt16LE(offsets[4] + 30);
   state.sensor_raw = [];
-  state.sensor_raw[0] = buffer.readUInt16LE(offsets[3] + 0);
-  state.sensor_raw[1] = buffer.readUInt16LE(offsets[3] + 2);
-  state.sensor_raw[2] = buffer.readUInt16LE(offsets[3] + 4);
-  state.sensor_raw[3] = buffer.readUInt16LE(offsets[3] + 6);
-  state.sensor_raw[4] = buffer.readUInt16LE(offsets[3] + 8);
-  state.sensor_raw[5] = buffer.readUInt16LE(offsets[3] + 10);
-  state.sensor_raw[6] = buffer.readUInt16LE(offsets[3] + 12);
-  state.sensor_raw[7] = buffer.readUInt16LE(offsets[3] + 14);
-  state.sensor_raw[8] = buffer.readUInt16LE(offsets[3] + 16);
-  state.sensor_raw[9] = buffer.readUInt16LE(offsets[3] + 18);
-  state.sensor_raw[10] = buffer.readUInt16LE(offsets[3] + 20);
-  state.sensor_raw[11] = buffer.readUInt16LE(offsets[3] + 22);
-  state.sensor_raw[12] = buffer.readUInt16LE(offsets[3] + 24);
-  state.sensor_raw[13] = buffer.readUInt16LE(offsets[3] + 26);
-  state.sensor_raw[14] = buffer.readUInt16LE(offsets[3] + 28);
-  state.sensor_raw[15] = buffer.readUInt16LE(offsets[3] + 30);
+  state.sensor_raw[0] = buffer.readUInt16LE(offsets[5] + 0);
+  state.sensor_raw[1] = buffer.readUInt16LE(offsets[5] + 2);
+  state.sensor_raw[2] = buffer.readUInt16LE(offsets[5] + 4);
+  state.sensor_raw[3] = buffer.readUInt16LE(offsets[5] + 6);
+  state.sensor_raw[4] = buffer.readUInt16LE(offsets[5] + 8);
+  state.sensor_raw[5] = buffer.readUInt16LE(offsets[5] + 10);
+  state.sensor_raw[6] = buffer.readUInt16LE(offsets[5] + 12);
+  state.sensor_raw[7] = buffer.readUInt16LE(offsets[5] + 14);
+  state.sensor_raw[8] = buffer.readUInt16LE(offsets[5] + 16);
+  state.sensor_raw[9] = buffer.readUInt16LE(offsets[5] + 18);
+  state.sensor_raw[10] = buffer.readUInt16LE(offsets[5] + 20);
+  state.sensor_raw[11] = buffer.readUInt16LE(offsets[5] + 22);
+  state.sensor_raw[12] = buffer.readUInt16LE(offsets[5] + 24);
+  state.sensor_raw[13] = buffer.readUInt16LE(offsets[5] + 26);
+  state.sensor_raw[14] = buffer.readUInt16LE(offsets[5] + 28);
+  state.sensor_raw[15] = buffer.readUInt16LE(offsets[5] + 30);
   state.sensor_data = [];
-  state.sensor_data[0] = buffer.readDoubleLE(offsets[4] + 0);
-  state.sensor_data[1] = buffer.readDoubleLE(offsets[4] + 8);
-  state.sensor_data[2] = buffer.readDoubleLE(offsets[4] + 16);
-  state.sensor_data[3] = buffer.readDoubleLE(offsets[4] + 24);
-  state.sensor_data[4] = buffer.readDoubleLE(offsets[4] + 32);
-  state.sensor_data[5] = buffer.readDoubleLE(offsets[4] + 40);
-  state.sensor_data[6] = buffer.readDoubleLE(offsets[4] + 48);
-  state.sensor_data[7] = buffer.readDoubleLE(offsets[4] + 56);
-  state.sensor_data[8] = buffer.readDoubleLE(offsets[4] + 64);
-  state.sensor_data[9] = buffer.readDoubleLE(offsets[4] + 72);
-  state.sensor_data[10] = buffer.readDoubleLE(offsets[4] + 80);
-  state.sensor_data[11] = buffer.readDoubleLE(offsets[4] + 88);
-  state.sensor_data[12] = buffer.readDoubleLE(offsets[4] + 96);
-  state.sensor_data[13] = buffer.readDoubleLE(offsets[4] + 104);
-  state.sensor_data[14] = buffer.readDoubleLE(offsets[4] + 112);
-  state.sensor_data[15] = buffer.readDoubleLE(offsets[4] + 120);
-  state.position = buffer.readDoubleLE(offsets[5]);
-  state.speed = buffer.readDoubleLE(offsets[6]);
-  state.battery_voltage = buffer.readDoubleLE(offsets[7]);
-  state.track = buffer.readUInt8(offsets[8]);
-  state.encoder_left = buffer.readInt32LE(offsets[9]);
-  state.encoder_right = buffer.readInt32LE(offsets[10]);
+  state.sensor_data[0] = buffer.readDoubleLE(offsets[6] + 0);
+  state.sensor_data[1] = buffer.readDoubleLE(offsets[6] + 8);
+  state.sensor_data[2] = buffer.readDoubleLE(offsets[6] + 16);
+  state.sensor_data[3] = buffer.readDoubleLE(offsets[6] + 24);
+  state.sensor_data[4] = buffer.readDoubleLE(offsets[6] + 32);
+  state.sensor_data[5] = buffer.readDoubleLE(offsets[6] + 40);
+  state.sensor_data[6] = buffer.readDoubleLE(offsets[6] + 48);
+  state.sensor_data[7] = buffer.readDoubleLE(offsets[6] + 56);
+  state.sensor_data[8] = buffer.readDoubleLE(offsets[6] + 64);
+  state.sensor_data[9] = buffer.readDoubleLE(offsets[6] + 72);
+  state.sensor_data[10] = buffer.readDoubleLE(offsets[6] + 80);
+  state.sensor_data[11] = buffer.readDoubleLE(offsets[6] + 88);
+  state.sensor_data[12] = buffer.readDoubleLE(offsets[6] + 96);
+  state.sensor_data[13] = buffer.readDoubleLE(offsets[6] + 104);
+  state.sensor_data[14] = buffer.readDoubleLE(offsets[6] + 112);
+  state.sensor_data[15] = buffer.readDoubleLE(offsets[6] + 120);
+  state.position = buffer.readDoubleLE(offsets[7]);
+  state.speed = buffer.readDoubleLE(offsets[8]);
+  state.battery_voltage = buffer.readDoubleLE(offsets[9]);
+  state.track = buffer.readUInt8(offsets[10]);
+  state.input_age_histogram = [];
+  state.input_age_histogram[0] = buffer.readUInt32LE(offsets[11] + 0);
+  state.input_age_histogram[1] = buffer.readUInt32LE(offsets[11] + 4);
+  state.input_age_histogram[2] = buffer.readUInt32LE(offsets[11] + 8);
+  state.input_age_histogram[3] = buffer.readUInt32LE(offsets[11] + 12);
+  state.input_age_histogram[4] = buffer.readUInt32LE(offsets[11] + 16);
+  state.input_age_histogram[5] = buffer.readUInt32LE(offsets[11] + 20);
+  state.input_age_histogram[6] = buffer.readUInt32LE(offsets[11] + 24);
+  state.input_age_histogram[7] = buffer.readUInt32LE(offsets[11] + 28);
+  state.input_age_histogram[8] = buffer.readUInt32LE(offsets[11] + 32);
+  state.input_age_histogram[9] = buffer.readUInt32LE(offsets[11] + 36);
+  state.input_age_histogram[10] = buffer.readUInt32LE(offsets[11] + 40);
+  state.input_age_histogram[11] = buffer.readUInt32LE(offsets[11] + 44);
+  state.input_age_histogram[12] = buffer.readUInt32LE(offsets[11] + 48);
+  state.input_age_histogram[13] = buffer.readUInt32LE(offsets[11] + 52);
+  state.input_age_histogram[14] = buffer.readUInt32LE(offsets[11] + 56);
+  state.input_age_histogram[15] = buffer.readUInt32LE(offsets[11] + 60);
+  state.input_age_max_us = buffer.readUInt32LE(offsets[12]);
+  state.encoder_left = buffer.readInt32LE(offsets[13]);
+  state.encoder_right = buffer.readInt32LE(offsets[14]);
+  state.encoder_rate = buffer.readUInt32LE(offsets[15]);
+  state.health_minor_faults = [];
+  state.health_minor_faults[0] = buffer.readUInt32LE(offsets[16] + 0);
+  state.health_minor_faults[1] = buffer.readUInt32LE(offsets[16] + 4);
+  state.health_minor_faults[2] = buffer.readUInt32LE(offsets[16] + 8);
+  state.health_minor_faults[3] = buffer.readUInt32LE(offsets[16] + 12);
+  state.health_minor_faults[4] = buffer.readUInt32LE(offsets[16] + 16);
+  state.health_minor_faults[5] = buffer.readUInt32LE(offsets[16] + 20);
+  state.health_minor_faults[6] = buffer.readUInt32LE(offsets[16] + 24);
+  state.health_minor_faults[7] = buffer.readUInt32LE(offsets[16] + 28);
+  state.health_major_faults = [];
+  state.health_major_faults[0] = buffer.readUInt32LE(offsets[17] + 0);
+  state.health_major_faults[1] = buffer.readUInt32LE(offsets[17] + 4);
+  state.health_major_faults[2] = buffer.readUInt32LE(offsets[17] + 8);
+  state.health_major_faults[3] = buffer.readUInt32LE(offsets[17] + 12);
+  state.health_major_faults[4] = buffer.readUInt32LE(offsets[17] + 16);
+  state.health_major_faults[5] = buffer.readUInt32LE(offsets[17] + 20);
+  state.health_major_faults[6] = buffer.readUInt32LE(offsets[17] + 24);
+  state.health_major_faults[7] = buffer.readUInt32LE(offsets[17] + 28);
+  state.health_voluntary_switches = [];
+  state.health_voluntary_switches[0] = buffer.readUInt32LE(offsets[18] + 0);
+  state.health_voluntary_switches[1] = buffer.readUInt32LE(offsets[18] + 4);
+  state.health_voluntary_switches[2] = buffer.readUInt32LE(offsets[18] + 8);
+  state.health_voluntary_switches[3] = buffer.readUInt32LE(offsets[18] + 12);
+  state.health_voluntary_switches[4] = buffer.readUInt32LE(offsets[18] + 16);
+  state.health_voluntary_switches[5] = buffer.readUInt32LE(offsets[18] + 20);
+  state.health_voluntary_switches[6] = buffer.readUInt32LE(offsets[18] + 24);
+  state.health_voluntary_switches[7] = buffer.readUInt32LE(offsets[18] + 28);
+  state.health_involuntary_switches = [];
+  state.health_involuntary_switches[0] = buffer.readUInt32LE(offsets[19] + 0);
+  state.health_involuntary_switches[1] = buffer.readUInt32LE(offsets[19] + 4);
+  state.health_involuntary_switches[2] = buffer.readUInt32LE(offsets[19] + 8);
+  state.health_involuntary_switches[3] = buffer.readUInt32LE(offsets[19] + 12);
+  state.health_involuntary_switches[4] = buffer.readUInt32LE(offsets[19] + 16);
+  state.health_involuntary_switches[5] = buffer.readUInt32LE(offsets[19] + 20);
+  state.health_involuntary_switches[6] = buffer.readUInt32LE(offsets[19] + 24);
+  state.health_involuntary_switches[7] = buffer.readUInt32LE(offsets[19] + 28);
+  state.health_migrations = [];
+  state.health_migrations[0] = buffer.readUInt32LE(offsets[20] + 0);
+  state.health_migrations[1] = buffer.readUInt32LE(offsets[20] + 4);
+  state.health_migrations[2] = buffer.readUInt32LE(offsets[20] + 8);
+  state.health_migrations[3] = buffer.readUInt32LE(offsets[20] + 12);
+  state.health_migrations[4] = buffer.readUInt32LE(offsets[20] + 16);
+  state.health_migrations[5] = buffer.readUInt32LE(offsets[20] + 20);
+  state.health_migrations[6] = buffer.readUInt32LE(offsets[20] + 24);
+  state.health_migrations[7] = buffer.readUInt32LE(offsets[20] + 28);
+  state.health_cpu_time_ms = [];
+  state.health_cpu_time_ms[0] = buffer.readUInt32LE(offsets[21] + 0);
+  state.health_cpu_time_ms[1] = buffer.readUInt32LE(offsets[21] + 4);
+  state.health_cpu_time_ms[2] = buffer.readUInt32LE(offsets[21] + 8);
+  state.health_cpu_time_ms[3] = buffer.readUInt32LE(offsets[21] + 12);
+  state.health_cpu_time_ms[4] = buffer.readUInt32LE(offsets[21] + 16);
+  state.health_cpu_time_ms[5] = buffer.readUInt32LE(offsets[21] + 20);
+  state.health_cpu_time_ms[6] = buffer.readUInt32LE(offsets[21] + 24);
+  state.health_cpu_time_ms[7] = buffer.readUInt32LE(offsets[21] + 28);
+  state.health_names = [];
+  state.health_names[0] = buffer.readUInt8(offsets[22] + 0);
+  state.health_names[1] = buffer.readUInt8(offsets[22] + 1);
+  state.health_names[2] = buffer.readUInt8(offsets[22] + 2);
+  state.health_names[3] = buffer.readUInt8(offsets[22] + 3);
+  state.health_names[4] = buffer.readUInt8(offsets[22] + 4);
+  state.health_names[5] = buffer.readUInt8(offsets[22] + 5);
+  state.health_names[6] = buffer.readUInt8(offsets[22] + 6);
+  state.health_names[7] = buffer.readUInt8(offsets[22] + 7);
+  state.health_names[8] = buffer.readUInt8(offsets[22] + 8);
+  state.health_names[9] = buffer.readUInt8(offsets[22] + 9);
+  state.health_names[10] = buffer.readUInt8(offsets[22] + 10);
+  state.health_names[11] = buffer.readUInt8(offsets[22] + 11);
+  state.health_names[12] = buffer.readUInt8(offsets[22] + 12);
+  state.health_names[13] = buffer.readUInt8(offsets[22] + 13);
+  state.health_names[14] = buffer.readUInt8(offsets[22] + 14);
+  state.health_names[15] = buffer.readUInt8(offsets[22] + 15);
+  state.health_names[16] = buffer.readUInt8(offsets[22] + 16);
+  state.health_names[17] = buffer.readUInt8(offsets[22] + 17);
+  state.health_names[18] = buffer.readUInt8(offsets[22] + 18);
+  state.health_names[19] = buffer.readUInt8(offsets[22] + 19);
+  state.health_names[20] = buffer.readUInt8(offsets[22] + 20);
+  state.health_names[21] = buffer.readUInt8(offsets[22] + 21);
+  state.health_names[22] = buffer.readUInt8(offsets[22] + 22);
+  state.health_names[23] = buffer.readUInt8(offsets[22] + 23);
+  state.health_names[24] = buffer.readUInt8(offsets[22] + 24);
+  state.health_names[25] = buffer.readUInt8(offsets[22] + 25);
+  state.health_names[26] = buffer.readUInt8(offsets[22] + 26);
+  state.health_names[27] = buffer.readUInt8(offsets[22] + 27);
+  state.health_names[28] = buffer.readUInt8(offsets[22] + 28);
+  state.health_names[29] = buffer.readUInt8(offsets[22] + 29);
+  state.health_names[30] = buffer.readUInt8(offsets[22] + 30);
+  state.health_names[31] = buffer.readUInt8(offsets[22] + 31);
+  state.health_names[32] = buffer.readUInt8(offsets[22] + 32);
+  state.health_names[33] = buffer.readUInt8(offsets[22] + 33);
+  state.health_names[34] = buffer.readUInt8(offsets[22] + 34);
+  state.health_names[35] = buffer.readUInt8(offsets[22] + 35);
+  state.health_names[36] = buffer.readUInt8(offsets[22] + 36);
+  state.health_names[37] = buffer.readUInt8(offsets[22] + 37);
+  state.health_names[38] = buffer.readUInt8(offsets[22] + 38);
+  state.health_names[39] = buffer.readUInt8(offsets[22] + 39);
+  state.health_names[40] = buffer.readUInt8(offsets[22] + 40);
+  state.health_names[41] = buffer.readUInt8(offsets[22] + 41);
+  state.health_names[42] = buffer.readUInt8(offsets[22] + 42);
+  state.health_names[43] = buffer.readUInt8(offsets[22] + 43);
+  state.health_names[44] = buffer.readUInt8(offsets[22] + 44);
+  state.health_names[45] = buffer.readUInt8(offsets[22] + 45);
+  state.health_names[46] = buffer.readUInt8(offsets[22] + 46);
+  state.health_names[47] = buffer.readUInt8(offsets[22] + 47);
+  state.health_names[48] = buffer.readUInt8(offsets[22] + 48);
+  state.health_names[49] = buffer.readUInt8(offsets[22] + 49);
+  state.health_names[50] = buffer.readUInt8(offsets[22] + 50);
+  state.health_names[51] = buffer.readUInt8(offsets[22] + 51);
+  state.health_names[52] = buffer.readUInt8(offsets[22] + 52);
+  state.health_names[53] = buffer.readUInt8(offsets[22] + 53);
+  state.health_names[54] = buffer.readUInt8(offsets[22] + 54);
+  state.health_names[55] = buffer.readUInt8(offsets[22] + 55);
+  state.health_names[56] = buffer.readUInt8(offsets[22] + 56);
+  state.health_names[57] = buffer.readUInt8(offsets[22] + 57);
+  state.health_names[58] = buffer.readUInt8(offsets[22] + 58);
+  state.health_names[59] = buffer.readUInt8(offsets[22] + 59);
+  state.health_names[60] = buffer.readUInt8(offsets[22] + 60);
+  state.health_names[61] = buffer.readUInt8(offsets[22] + 61);
+  state.health_names[62] = buffer.readUInt8(offsets[22] + 62);
+  state.health_names[63] = buffer.readUInt8(offsets[22] + 63);
+  state.health_names[64] = buffer.readUInt8(offsets[22] + 64);
+  state.health_names[65] = buffer.readUInt8(offsets[22] + 65);
+  state.health_names[66] = buffer.readUInt8(offsets[22] + 66);
+  state.health_names[67] = buffer.readUInt8(offsets[22] + 67);
+  state.health_names[68] = buffer.readUInt8(offsets[22] + 68);
+  state.health_names[69] = buffer.readUInt8(offsets[22] + 69);
+  state.health_names[70] = buffer.readUInt8(offsets[22] + 70);
+  state.health_names[71] = buffer.readUInt8(offsets[22] + 71);
+  state.health_names[72] = buffer.readUInt8(offsets[22] + 72);
+  state.health_names[73] = buffer.readUInt8(offsets[22] + 73);
+  state.health_names[74] = buffer.readUInt8(offsets[22] + 74);
+  state.health_names[75] = buffer.readUInt8(offsets[22] + 75);
+  state.health_names[76] = buffer.readUInt8(offsets[22] + 76);
+  state.health_names[77] = buffer.readUInt8(offsets[22] + 77);
+  state.health_names[78] = buffer.readUInt8(offsets[22] + 78);
+  state.health_names[79] = buffer.readUInt8(offsets[22] + 79);
+  state.health_names[80] = buffer.readUInt8(offsets[22] + 80);
+  state.health_names[81] = buffer.readUInt8(offsets[22] + 81);
+  state.health_names[82] = buffer.readUInt8(offsets[22] + 82);
+  state.health_names[83] = buffer.readUInt8(offsets[22] + 83);
+  state.health_names[84] = buffer.readUInt8(offsets[22] + 84);
+  state.health_names[85] = buffer.readUInt8(offsets[22] + 85);
+  state.health_names[86] = buffer.readUInt8(offsets[22] + 86);
+  state.health_names[87] = buffer.readUInt8(offsets[22] + 87);
+  state.health_names[88] = buffer.readUInt8(offsets[22] + 88);
+  state.health_names[89] = buffer.readUInt8(offsets[22] + 89);
+  state.health_names[90] = buffer.readUInt8(offsets[22] + 90);
+  state.health_names[91] = buffer.readUInt8(offsets[22] + 91);
+  state.health_names[92] = buffer.readUInt8(offsets[22] + 92);
+  state.health_names[93] = buffer.readUInt8(offsets[22] + 93);
+  state.health_names[94] = buffer.readUInt8(offsets[22] + 94);
+  state.health_names[95] = buffer.readUInt8(offsets[22] + 95);
+  state.health_names[96] = buffer.readUInt8(offsets[22] + 96);
+  state.health_names[97] = buffer.readUInt8(offsets[22] + 97);
+  state.health_names[98] = buffer.readUInt8(offsets[22] + 98);
+  state.health_names[99] = buffer.readUInt8(offsets[22] + 99);
+  state.health_names[100] = buffer.readUInt8(offsets[22] + 100);
+  state.health_names[101] = buffer.readUInt8(offsets[22] + 101);
+  state.health_names[102] = buffer.readUInt8(offsets[22] + 102);
+  state.health_names[103] = buffer.readUInt8(offsets[22] + 103);
+  state.health_names[104] = buffer.readUInt8(offsets[22] + 104);
+  state.health_names[105] = buffer.readUInt8(offsets[22] + 105);
+  state.health_names[106] = buffer.readUInt8(offsets[22] + 106);
+  state.health_names[107] = buffer.readUInt8(offsets[22] + 107);
+  state.health_names[108] = buffer.readUInt8(offsets[22] + 108);
+  state.health_names[109] = buffer.readUInt8(offsets[22] + 109);
+  state.health_names[110] = buffer.readUInt8(offsets[22] + 110);
+  state.health_names[111] = buffer.readUInt8(offsets[22] + 111);
+  state.health_names[112] = buffer.readUInt8(offsets[22] + 112);
+  state.health_names[113] = buffer.readUInt8(offsets[22] + 113);
+  state.health_names[114] = buffer.readUInt8(offsets[22] + 114);
+  state.health_names[115] = buffer.readUInt8(offsets[22] + 115);
+  state.health_names[116] = buffer.readUInt8(offsets[22] + 116);
+  state.health_names[117] = buffer.readUInt8(offsets[22] + 117);
+  state.health_names[118] = buffer.readUInt8(offsets[22] + 118);
+  state.health_names[119] = buffer.readUInt8(offsets[22] + 119);
+  state.health_names[120] = buffer.readUInt8(offsets[22] + 120);
+  state.health_names[121] = buffer.readUInt8(offsets[22] + 121);
+  state.health_names[122] = buffer.readUInt8(offsets[22] + 122);
+  state.health_names[123] = buffer.readUInt8(offsets[22] + 123);
+  state.health_names[124] = buffer.readUInt8(offsets[22] + 124);
+  state.health_names[125] = buffer.readUInt8(offsets[22] + 125);
+  state.health_names[126] = buffer.readUInt8(offsets[22] + 126);
+  state.health_names[127] = buffer.readUInt8(offsets[22] + 127);
   return state;
 }
 module.exports = read_state;
+module.exports.fields = ["state", "generation", "boot_time_ms", "sensor_low", "sensor_high", "sensor_raw", "sensor_data", "position", "speed", "battery_voltage", "track", "input_age_histogram", "input_age_max_us", "encoder_left", "encoder_right", "encoder_rate", "health_minor_faults", "health_major_faults", "health_voluntary_switches", "health_involuntary_switches", "health_migrations", "health_cpu_time_ms", "health_names"];
+module.exports.offsets = [0, 4, 8, 64, 96, 128, 160, 288, 296, 304, 312, 316, 380, 384, 388, 392, 448, 480, 512, 544, 576, 608, 640];
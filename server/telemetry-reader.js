@@ -0,0 +1,52 @@
+function read_telemetry_record(buffer, base) {
+  const record = {};
+  record.timestamp = Number(buffer.readBigUInt64LE(base + 0));
+  record.input_timestamp = Number(buffer.readBigUInt64LE(base + 8));
+  record.sensor_raw = [];
+  record.sensor_raw[0] = buffer.readUInt16LE(base + 16);
+  record.sensor_raw[1] = buffer.readUInt16LE(base + 18);
+  record.sensor_raw[2] = buffer.readUInt16LE(base + 20);
+  record.sensor_raw[3] = buffer.readUInt16LE(base + 22);
+  record.sensor_raw[4] = buffer.readUInt16LE(base + 24);
+  record.sensor_raw[5] = buffer.readUInt16LE(base + 26);
+  record.sensor_raw[6] = buffer.readUInt16LE(base + 28);
+  record.sensor_raw[7] = buffer.readUInt16LE(base + 30);
+  record.sensor_raw[8] = buffer.readUInt16LE(base + 32);
+  record.sensor_raw[9] = buffer.readUInt16LE(base + 34);
+  record.sensor_raw[10] = buffer.readUInt16LE(base + 36);
+  record.sensor_raw[11] = buffer.readUInt16LE(base + 38);
+  record.sensor_raw[12] = buffer.readUInt16LE(base + 40);
+  record.sensor_raw[13] = buffer.readUInt16LE(base + 42);
+  record.sensor_raw[14] = buffer.readUInt16LE(base + 44);
+  record.sensor_raw[15] = buffer.readUInt16LE(base + 46);
+  record.sensor_data = [];
+  record.sensor_data[0] = buffer.readDoubleLE(base + 48);
+  record.sensor_data[1] = buffer.readDoubleLE(base + 56);
+  record.sensor_data[2] = buffer.readDoubleLE(base + 64);
+  record.sensor_data[3] = buffer.readDoubleLE(base + 72);
+  record.sensor_data[4] = buffer.readDoubleLE(base + 80);
+  record.sensor_data[5] = buffer.readDoubleLE(base + 88);
+  record.sensor_data[6] = buffer.readDoubleLE(base + 96);
+  record.sensor_data[7] = buffer.readDoubleLE(base + 104);
+  record.sensor_data[8] = buffer.readDoubleLE(base + 112);
+  record.sensor_data[9] = buffer.readDoubleLE(base + 120);
+  record.sensor_data[10] = buffer.readDoubleLE(base + 128);
+  record.sensor_data[11] = buffer.readDoubleLE(base + 136);
+  record.sensor_data[12] = buffer.readDoubleLE(base + 144);
+  record.sensor_data[13] = buffer.readDoubleLE(base + 152);
+  record.sensor_data[14] = buffer.readDoubleLE(base + 160);
+  record.sensor_data[15] = buffer.readDoubleLE(base + 168);
+  record.position = buffer.readDoubleLE(base + 176);
+  record.speed = buffer.readDoubleLE(base + 184);
+  record.encoder_left = buffer.readInt32LE(base + 192);
+  record.encoder_right = buffer.readInt32LE(base + 196);
+  record.pid_left_target = buffer.readDoubleLE(base + 200);
+  record.pid_right_target = buffer.readDoubleLE(base + 208);
+  record.pid_left_output = buffer.readDoubleLE(base + 216);
+  record.pid_right_output = buffer.readDoubleLE(base + 224);
+  record.motor_left = buffer.readDoubleLE(base + 232);
+  record.motor_right = buffer.readDoubleLE(base + 240);
+  return record;
+}
+module.exports = read_telemetry_record;
+module.exports.size = 248;
@@ -0,0 +1,94 @@
+const fs = require("fs");
+const readTelemetryRecord = require("./telemetry-reader.js");
+
+const sharedMemoryPath = "/dev/shm/telemetry";
+
+// Must match telemetry_t in main/core/include/telemetry.h
+const TELEMETRY_MAGIC = 0x4d4c4554;
+const HEADER_SIZE = 64;
+const HEAD_OFFSET = 16;
+
+class TelemetryReader {
+  constructor() {
+    this.fd = fs.openSync(sharedMemoryPath, "r");
+    this.header = Buffer.alloc(HEADER_SIZE);
+
+    fs.readSync(this.fd, this.header, 0, HEADER_SIZE, 0);
+    const magic = this.header.readUInt32LE(0);
+    const recordSize = this.header.readUInt32LE(4);
+    if (magic !== TELEMETRY_MAGIC || recordSize !== readTelemetryRecord.size) {
+      throw new Error("Telemetry layout mismatch, re-run state-gen");
+    }
+
+    this.capacity = this.header.readUInt32LE(8);
+    this.recordSize = recordSize;
+    this.buffer = Buffer.alloc(this.capacity * this.recordSize);
+
+    // Start from the most recent record rather than replaying the history
+    this.cursor = this.readHead();
+    this.overruns = 0;
+  }
+
+  readHead() {
+    fs.readSync(this.fd, this.header, 0, HEADER_SIZE, 0);
+    return Number(this.header.readBigUInt64LE(HEAD_OFFSET));
+  }
+
+  readSlots(first, count) {
+    // Copy count slots starting at record index first, handling wrap-around
+    const slot = first % this.capacity;
+    const tail = Math.min(count, this.capacity - slot);
+    fs.readSync(
+      this.fd,
+      this.buffer,
+      0,
+      tail * this.recordSize,
+      HEADER_SIZE + slot * this.recordSize
+    );
+    if (tail < count) {
+      fs.readSync(
+        this.fd,
+        this.buffer,
+        tail * this.recordSize,
+        (count - tail) * this.recordSize,
+        HEADER_SIZE
+      );
+    }
+  }
+
+  read() {
+    // The slot of head - capacity may be being overwritten, so at most
+    // capacity - 1 records behind head are readable.
+    const head = this.readHead();
+    const readable = this.capacity - 1;
+    if (head - this.cursor > readable) {
+      this.overruns += head - readable - this.cursor;
+      this.cursor = head - readable;
+    }
+
+    const count = head - this.cursor;
+    if (count === 0) return [];
+    this.readSlots(this.cursor, count);
+
+    // Drop the records that the producer lapped while they were being copied
+    const headAfter = this.readHead();
+    let lapped = 0;
+    if (headAfter - this.cursor > readable) {
+      lapped = Math.min(count, headAfter - readable - this.cursor);
+      this.overruns += lapped;
+    }
+
+    const records = [];
+    for (let i = lapped; i < count; i++) {
+      records.push(readTelemetryRecord(this.buffer, i * this.recordSize));
+    }
+    this.cursor = head;
+    return records;
+  }
+
+  close() {
+    fs.closeSync(this.fd);
+  }
+}
+
+module.exports = TelemetryReader;